@@ -107,6 +107,54 @@ bool codegen_base::is_const_field(const mfast::field_instruction* inst) const
   return true;
 }
 
+bool codegen_base::is_pod_eligible(const mfast::group_field_instruction* inst) const
+{
+  for (std::size_t i = 0; i < inst->subinstructions().size(); ++i)
+  {
+    const mfast::field_instruction* subinst = inst->subinstruction(i);
+    if (is_const_field(subinst)) {
+      if (subinst->optional())
+        return false;
+      continue;
+    }
+
+    switch (subinst->field_type())
+    {
+    case mfast::field_type_int32:
+    case mfast::field_type_uint32:
+    case mfast::field_type_int64:
+    case mfast::field_type_uint64:
+    case mfast::field_type_decimal:
+    case mfast::field_type_exponent:
+      break;
+    case mfast::field_type_ascii_string:
+    case mfast::field_type_unicode_string:
+    case mfast::field_type_byte_vector:
+      if (subinst->max_length() == 0)
+        return false;
+      break;
+    case mfast::field_type_group:
+      {
+        const mfast::group_field_instruction* group = static_cast<const mfast::group_field_instruction*>(subinst);
+        if (group->ref_instruction() || !is_pod_eligible(group))
+          return false;
+      }
+      break;
+    case mfast::field_type_sequence:
+      {
+        const mfast::sequence_field_instruction* sequence = static_cast<const mfast::sequence_field_instruction*>(subinst);
+        if (sequence->max_length() == 0 || sequence->ref_instruction() ||
+            get_element_instruction(sequence) || !is_pod_eligible(sequence))
+          return false;
+      }
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
 using namespace mfast;
 
 class type_name_finder
@@ -251,6 +299,44 @@ bool codegen_base::contains_only_templateref(const mfast::group_field_instructio
   return inst->subinstructions().size() == 1 && inst->subinstruction(0)->field_type() == mfast::field_type_templateref;
 }
 
+std::string codegen_base::view_field_cref_type(const mfast::compiled_view& view, std::size_t index)
+{
+  mfast::field_type_enum_t type = view.alternative_instruction(index)->field_type();
+  for (std::size_t i = 1; i < view.alternative_count(index); ++i) {
+    if (view.alternative_instruction(index, i)->field_type() != type)
+      return "mfast::field_cref";
+  }
+
+  switch (type) {
+  case mfast::field_type_int32:
+    return "mfast::int32_cref";
+  case mfast::field_type_uint32:
+    return "mfast::uint32_cref";
+  case mfast::field_type_int64:
+    return "mfast::int64_cref";
+  case mfast::field_type_uint64:
+    return "mfast::uint64_cref";
+  case mfast::field_type_decimal:
+    return "mfast::decimal_cref";
+  case mfast::field_type_ascii_string:
+    return "mfast::ascii_string_cref";
+  case mfast::field_type_unicode_string:
+    return "mfast::unicode_string_cref";
+  case mfast::field_type_byte_vector:
+    return "mfast::byte_vector_cref";
+  case mfast::field_type_int32_vector:
+    return "mfast::int32_vector_cref";
+  case mfast::field_type_uint32_vector:
+    return "mfast::uint32_vector_cref";
+  case mfast::field_type_int64_vector:
+    return "mfast::int64_vector_cref";
+  case mfast::field_type_uint64_vector:
+    return "mfast::uint64_vector_cref";
+  default:
+    return "mfast::field_cref";
+  }
+}
+
 const mfast::field_instruction*
 codegen_base::get_element_instruction(const mfast::sequence_field_instruction* inst)
 {
@@ -69,6 +69,15 @@ protected:
 
   bool contains_only_templateref(const mfast::group_field_instruction* inst) const;
 
+  // whether a plain struct can hold the fields of inst: integers, decimals, strings and byte
+  // vectors with an mfast:maxLength, groups and bounded sequences of such fields, and
+  // mandatory constants, which the struct leaves out
+  bool is_pod_eligible(const mfast::group_field_instruction* inst) const;
+
+  // the cref type returned by the accessor of a view field, mfast::field_cref unless every
+  // reference of the field is of the same primitive type
+  static std::string view_field_cref_type(const mfast::compiled_view& view, std::size_t index);
+
 
   bool dont_generate(const mfast::field_instruction* inst) const;
 };
@@ -723,8 +723,20 @@ void cpp_gen::generate(const mfast::aggregate_view_info& info)
     out_ << "\n";
     ++k;
   }
-  out_ << "  };\n"
-       << "  const static mfast::field_view_info __" << my_name << "_data__[] = {\n";
+  out_ << "  };\n";
+
+  if (info.field_names_.size()) {
+    out_ << "  const char* const __" << my_name << "_field_names__[] = {\n";
+    for (std::size_t i = 0; i < info.field_names_.size(); ++i) {
+      out_ << "    \"" << info.field_names_[i] << "\"";
+      if (i + 1 != info.field_names_.size())
+        out_ << ",";
+      out_ << "\n";
+    }
+    out_ << "  };\n";
+  }
+
+  out_ << "  const static mfast::field_view_info __" << my_name << "_data__[] = {\n";
 
   for (std::size_t i = 0; i < info.data_.size()-1; ++i)
   {
@@ -745,6 +757,9 @@ void cpp_gen::generate(const mfast::aggregate_view_info& info)
        << "  \"" << info.name_ <<"\",\n"
        << "  " << ns_prefix << cpp_name(info.instruction_->name()) << "::instruction(),\n"
        << "  mfast::array_view<const  mfast::field_view_info>(__" << my_name << "_data__," << info.data_.size() << "),\n"
-       << "  " << info.max_depth_  << "\n"
+       << "  " << info.max_depth_;
+  if (info.field_names_.size())
+    out_ << ",\n  mfast::array_view<const char* const>(__" << my_name << "_field_names__," << info.field_names_.size() << ")";
+  out_ << "\n"
        << ");\n\n";
 }
@@ -371,6 +371,85 @@ void hpp_gen::visit(const mfast::sequence_field_instruction* inst, void* pIndex)
   }
 }
 
+static std::string pod_type_of(const mfast::field_instruction* inst)
+{
+  std::stringstream strm;
+  switch (inst->field_type())
+  {
+  case mfast::field_type_int32:
+    return "int32_t";
+  case mfast::field_type_uint32:
+    return "uint32_t";
+  case mfast::field_type_int64:
+    return "int64_t";
+  case mfast::field_type_uint64:
+    return "uint64_t";
+  case mfast::field_type_ascii_string:
+  case mfast::field_type_unicode_string:
+    strm << "mfast::pod_string<" << inst->max_length() << ">";
+    return strm.str();
+  case mfast::field_type_byte_vector:
+    strm << "mfast::pod_array<unsigned char, " << inst->max_length() << ">";
+    return strm.str();
+  default:
+    return "mfast::pod_decimal";
+  }
+}
+
+void hpp_gen::gen_pod(const mfast::group_field_instruction* inst,
+                      const std::string&                    name,
+                      const std::string&                    cref_type_name,
+                      const std::string&                    mref_type_name,
+                      const char*                           message_type_name)
+{
+  pod_ << indent << "struct " << name << "\n"
+       << indent << "{\n";
+  pod_.inc_indent();
+
+  if (message_type_name)
+    pod_ << indent << "typedef " << message_type_name << " message_type;\n\n";
+
+  for (std::size_t i = 0; i < inst->subinstructions().size(); ++i)
+  {
+    const mfast::field_instruction* subinst = inst->subinstruction(i);
+    std::string member = cpp_name(subinst);
+
+    if (subinst->field_type() == mfast::field_type_group) {
+      gen_pod(static_cast<const mfast::group_field_instruction*>(subinst),
+              member + "_pod",
+              cref_type_name + "::" + member + "_cref",
+              mref_type_name + "::" + member + "_mref");
+      pod_ << indent << member << "_pod " << member << ";\n";
+    }
+    else if (subinst->field_type() == mfast::field_type_sequence) {
+      gen_pod(static_cast<const mfast::group_field_instruction*>(subinst),
+              member + "_element_pod",
+              cref_type_name + "::" + member + "_element_cref",
+              mref_type_name + "::" + member + "_element_mref");
+      pod_ << indent << "mfast::pod_array<" << member << "_element_pod, " << subinst->max_length() << "> " << member << ";\n";
+    }
+    else if (is_const_field(subinst)) {
+      // the value is given by the template
+      continue;
+    }
+    else {
+      pod_ << indent << pod_type_of(subinst) << " " << member << ";\n";
+    }
+
+    if (subinst->optional())
+      pod_ << indent << "bool " << member << "_present;\n";
+  }
+
+  pod_ << "\n"
+       << indent << "void load(const " << cref_type_name << "& ref);\n"
+       << indent << "void store(const " << mref_type_name << "& ref) const;\n\n"
+       << indent << "// passes the members in template order to fast_pod_decoder or fast_pod_encoder\n"
+       << indent << "template <typename Coder, typename Pod>\n"
+       << indent << "static void code(Coder& coder, Pod& pod);\n";
+  pod_.dec_indent();
+  pod_ << indent << "};\n\n";
+}
+
 void hpp_gen::visit(const mfast::template_instruction* inst, void*)
 {
   // if (inst->subinstructions().size() == 0)
@@ -493,8 +572,17 @@ void hpp_gen::generate(mfast::dynamic_templates_description& desc)
     out_ << "#include \"" << export_symbol_ << ".h\"\n";
   }
 
+  for (std::size_t i = 0; i < desc.size(); ++i)
+  {
+    if (desc[i]->subinstructions().size() && is_pod_eligible(desc[i])) {
+      std::string name = cpp_name(desc[i]);
+      gen_pod(desc[i], name + "_pod", name + "_cref", name + "_mref", name.c_str());
+    }
+  }
+
   out_ << "namespace " << filebase_ << "\n{\n"
        << content_.str()
+       << pod_.str()
        << "\n";
 
   for (const mfast::aggregate_view_info& info: desc.view_infos())
@@ -658,7 +746,15 @@ void hpp_gen::generate(const mfast::aggregate_view_info& info)
        << "    iterator begin() const;\n"
        << "    iterator end() const;\n"
        << "    template <typename FieldAccessor>\n"
-       << "    void accept_accessor(FieldAccessor& accessor) const;\n\n"
+       << "    void accept_accessor(FieldAccessor& accessor) const;\n\n";
+
+  mfast::compiled_view view(info);
+  for (std::size_t i = 0; i < view.size(); ++i) {
+    if (view.field_name(i)[0])
+      out_ << "    " << view_field_cref_type(view, i) << " get_" << cpp_name(view.field_name(i)) << "() const;\n";
+  }
+
+  out_ << "    static const mfast::compiled_view& compiled();\n\n"
        << "  private:\n"
        << "    "  << ns_prefix <<  cpp_name(info.instruction_->name()) << "_cref ref_;\n"
        << "    static const mfast::aggregate_view_info info_;\n"
@@ -59,12 +59,18 @@ private:
   virtual void traverse(const mfast::group_field_instruction* inst, const char* name_suffix);
   virtual void generate(const mfast::aggregate_view_info& info);
   void gen_sequence_typedef(const mfast::sequence_field_instruction* inst, const std::string& name);
+  void gen_pod(const mfast::group_field_instruction* inst,
+               const std::string&                    name,
+               const std::string&                    cref_type_name,
+               const std::string&                    mref_type_name,
+               const char*                           message_type_name = 0);
 
   typedef indented_stringstream ind_stream;
   std::set<std::string> dependency_;
   ind_stream header_cref_;
   ind_stream header_mref_;
   std::stringstream content_;
+  ind_stream pod_;
   std::string export_symbol_;
   std::string export_symbol_uppercase_;
 
@@ -734,7 +734,7 @@ void inl_gen::visit(const mfast::template_instruction* inst, void*)
        << "inline\n"
        << name << "_cref::" << name << "_cref(\n"
        << "  const mfast::field_cref& other)\n"
-       << "  : base_type(mfast::field_cref_core_access::storage_of(other)->of_group.content_,\n"
+       << "  : base_type(mfast::field_cref_core_access::storage_of(other)->group_content(),\n"
        << "              static_cast<instruction_cptr>(other.instruction()))\n"
        << "{\n"
        << "}\n\n"
@@ -783,7 +783,7 @@ void inl_gen::visit(const mfast::template_instruction* inst, void*)
        << name << "_mref::" << name << "_mref(\n"
        << "  const mfast::field_mref_base& other)\n"
        << "  : base_type(other.allocator(),\n"
-       << "              mfast::field_mref_core_access::storage_of(other)->of_group.content_,\n"
+       << "              mfast::field_mref_core_access::storage_of(other)->group_content(),\n"
        << "              static_cast<instruction_cptr>(other.instruction()))\n"
        << "{\n"
        << "}\n\n"
@@ -866,9 +866,110 @@ void inl_gen::visit(const mfast::templateref_instruction*, void* pIndex)
        << "}\n\n";
 }
 
+void inl_gen::gen_pod(const mfast::group_field_instruction* inst,
+                      const std::string&                    name,
+                      const std::string&                    cref_type_name,
+                      const std::string&                    mref_type_name)
+{
+  std::stringstream load;
+  std::stringstream store;
+  std::stringstream code;
+
+  for (std::size_t i = 0; i < inst->subinstructions().size(); ++i)
+  {
+    const mfast::field_instruction* subinst = inst->subinstruction(i);
+    if (is_const_field(subinst))
+      continue;
+
+    std::string member = cpp_name(subinst);
+    std::string present_arg = subinst->optional() ? ", pod." + member + "_present" : "";
+    std::string getter = "ref.get_" + member + "()";
+    std::string setter = "ref.set_" + member + "()";
+    std::string load_statement;
+    std::string store_statement;
+
+    switch (subinst->field_type())
+    {
+    case mfast::field_type_int32:
+    case mfast::field_type_uint32:
+    case mfast::field_type_int64:
+    case mfast::field_type_uint64:
+      load_statement = member + " = " + getter + ".value();";
+      store_statement = setter + ".as(" + member + ");";
+      code << "  coder.code_field(pod." << member << present_arg << ", " << i << ");\n";
+      break;
+    case mfast::field_type_group:
+      gen_pod(static_cast<const mfast::group_field_instruction*>(subinst),
+              name + "::" + member + "_pod",
+              cref_type_name + "::" + member + "_cref",
+              mref_type_name + "::" + member + "_mref");
+      load_statement = member + ".load(" + getter + ");";
+      store_statement = member + ".store(" + setter + ");";
+      code << "  coder.code_group(pod." << member << present_arg << ", " << i << ");\n";
+      break;
+    case mfast::field_type_sequence:
+      gen_pod(static_cast<const mfast::group_field_instruction*>(subinst),
+              name + "::" + member + "_element_pod",
+              cref_type_name + "::" + member + "_element_cref",
+              mref_type_name + "::" + member + "_element_mref");
+      load_statement = "mfast::pod_load_sequence(" + getter + ", " + member + ");";
+      store_statement = "mfast::pod_store_sequence(" + member + ", " + setter + ");";
+      code << "  coder.code_sequence(pod." << member << present_arg << ", " << i << ");\n";
+      break;
+    default:
+      load_statement = "mfast::pod_load(" + getter + ", " + member + ");";
+      store_statement = "mfast::pod_store(" + member + ", " + setter + ");";
+      code << "  coder.code_field(pod." << member << present_arg << ", " << i << ");\n";
+    }
+
+    if (subinst->optional()) {
+      load << "  " << member << "_present = " << getter << ".present();\n"
+           << "  if (" << member << "_present)\n"
+           << "    " << load_statement << "\n";
+      store << "  if (" << member << "_present)\n"
+            << "    " << store_statement << "\n"
+            << "  else\n"
+            << "    ref.omit_" << member << "();\n";
+    }
+    else {
+      load << "  " << load_statement << "\n";
+      store << "  " << store_statement << "\n";
+    }
+  }
+
+  // a struct holding nothing but constants leaves ref unused
+  const char* ref = load.str().size() ? " ref" : "";
+
+  out_ << "inline void\n"
+       << name << "::load(const " << cref_type_name << "&" << ref << ")\n"
+       << "{\n"
+       << load.str()
+       << "}\n\n"
+       << "inline void\n"
+       << name << "::store(const " << mref_type_name << "&" << ref << ") const\n"
+       << "{\n"
+       << store.str()
+       << "}\n\n"
+       << "template <typename Coder, typename Pod>\n"
+       << "inline void\n"
+       << name << "::code(Coder&" << (*ref ? " coder" : "") << ", Pod&" << (*ref ? " pod" : "") << ")\n"
+       << "{\n"
+       << code.str()
+       << "}\n\n";
+}
+
 void inl_gen::generate(mfast::dynamic_templates_description& desc)
 {
   codegen_base::traverse(desc);
+
+  for (std::size_t i = 0; i < desc.size(); ++i)
+  {
+    if (desc[i]->subinstructions().size() && is_pod_eligible(desc[i])) {
+      std::string name = cpp_name(desc[i]);
+      gen_pod(desc[i], name + "_pod", name + "_cref", name + "_mref");
+    }
+  }
+
   for (auto&& info: desc.view_infos())
   {
     this->generate(info);
@@ -1016,5 +1117,22 @@ void inl_gen::generate(const mfast::aggregate_view_info& info)
        << "    if (FieldAccessor::visit_absent || f.present())"
        << "      f.accept_accessor(accessor);\n"
        << "  }\n"
-       << "}\n";
+       << "}\n\n"
+       << "inline const mfast::compiled_view& " << my_name << "::compiled()\n"
+       << "{\n"
+       << "  static const mfast::compiled_view view(info_);\n"
+       << "  return view;\n"
+       << "}\n\n";
+
+  mfast::compiled_view view(info);
+  for (std::size_t i = 0; i < view.size(); ++i) {
+    if (view.field_name(i)[0] == 0)
+      continue;
+    std::string cref_type = view_field_cref_type(view, i);
+    out_ << "inline " << cref_type << "\n"
+         << my_name << "::get_" << cpp_name(view.field_name(i)) << "() const\n"
+         << "{\n"
+         << "  return " << cref_type << "(compiled().get(ref_, " << i << "));\n"
+         << "}\n\n";
+  }
 }
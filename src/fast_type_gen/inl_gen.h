@@ -64,6 +64,11 @@ private:
                       const std::string&              mref_type_name,
                       void*                           pIndex);
 
+  void gen_pod(const mfast::group_field_instruction* inst,
+               const std::string&                    name,
+               const std::string&                    cref_type_name,
+               const std::string&                    mref_type_name);
+
   std::stringstream mref_scope_;
 };
 
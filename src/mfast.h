@@ -26,6 +26,7 @@
 #include <mfast/message_ref.h>
 #include <mfast/nested_message_ref.h>
 #include <mfast/malloc_allocator.h>
+#include <mfast/thread_caching_allocator.h>
 #include <mfast/field_visitor.h>
 #include <mfast/arena_allocator.h>
 #include <mfast/field_comparator.h>
@@ -35,4 +36,13 @@
 #include <mfast/boolean_ref.h>
 #include <mfast/view_iterator.h>
 #include <mfast/ext_ref.h>
+#include <mfast/message_pool.h>
+#include <mfast/field_path.h>
+#include <mfast/flat_message.h>
+#include <mfast/message_snapshot.h>
+#include <mfast/sequence_columns.h>
+#include <mfast/column_batch.h>
+#include <mfast/compiled_view.h>
+#include <mfast/pod_types.h>
+#include <mfast/utf8.h>
 #endif /* end of include guard: MFAST_H_4EMINVTV */
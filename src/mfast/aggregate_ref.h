@@ -277,11 +277,11 @@ namespace mfast
 
   inline
   aggregate_cref::aggregate_cref(const field_cref& other)
-    : storage_array_(field_cref_core_access::storage_of(other)->of_group.content_)
   {
     if (other.instruction()->field_type() == field_type_templateref)
     {
-
+      // of_templateref overlaps the flags of of_group, so it has no offset form
+      this->storage_array_ = field_cref_core_access::storage_of(other)->of_templateref.content_;
       this->instruction_ = static_cast<const group_field_instruction*> (
         field_cref_core_access::storage_of(other)->of_templateref.of_instruction.instruction_);
       if (this->instruction_ == 0)
@@ -292,6 +292,7 @@ namespace mfast
 
     }
     else {
+      this->storage_array_ = field_cref_core_access::storage_of(other)->group_content();
       this->instruction_ = static_cast<const group_field_instruction*> (other.instruction());
     }
   }
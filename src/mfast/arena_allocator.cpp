@@ -21,6 +21,16 @@
 #include <algorithm>
 #include <cstdlib>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define MFAST_ARENA_USE_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 namespace mfast {
 
   inline std::size_t align(std::size_t n, std::size_t x)
@@ -29,21 +39,109 @@ namespace mfast {
     return (n + y) & ~y;
   }
 
+  const std::size_t huge_page_size = 2*1024*1024;
+
   void arena_allocator::free_list(memory_chunk_base* head)
   {
     memory_chunk_base* tmp;
     while ( head ) {
       tmp = head->next_;
-      free(head);
+      system_deallocate(head, head->end_ - reinterpret_cast<char*>(head));
       head = tmp;
     };
   }
 
   arena_allocator::arena_allocator()
     : free_list_head_(0)
+    , next_chunk_size_(default_chunk_size)
+    , mapped_(false)
+  {
+    std::fill(recycled_, recycled_ + num_recycled_classes, static_cast<recycled_block*>(0));
+    current_list_head_ = new_chunk(default_chunk_size, 0);
+  }
+
+  arena_allocator::arena_allocator(const chunk_policy& policy)
+    : free_list_head_(0)
+    , policy_(policy)
+    , mapped_(false)
+  {
+    std::fill(recycled_, recycled_ + num_recycled_classes, static_cast<recycled_block*>(0));
+    policy_.chunk_size = align((std::max)(policy_.chunk_size, std::size_t(default_chunk_size)), default_chunk_size);
+    policy_.growth_factor = (std::max)(policy_.growth_factor, std::size_t(1));
+    policy_.max_chunk_size = (std::max)(policy_.max_chunk_size, policy_.chunk_size);
+    next_chunk_size_ = policy_.chunk_size;
+
+#ifdef MFAST_ARENA_USE_MMAP
+    mapped_ = policy_.huge_pages || policy_.numa_node >= 0;
+#endif
+
+    current_list_head_ = new_chunk(next_chunk_size_, 0);
+    next_chunk_size_ = (std::min)(next_chunk_size_ * policy_.growth_factor, policy_.max_chunk_size);
+
+    if (policy_.prefault) {
+      // fault in the pages now rather than during the first allocations
+      for (char* p = current_list_head_->start_; p < current_list_head_->end_; p += default_chunk_size)
+        *p = 0;
+    }
+  }
+
+  arena_allocator::memory_chunk*
+  arena_allocator::new_chunk(std::size_t size, memory_chunk* next)
+  {
+    void* block = system_allocate(size);
+    return new (block) memory_chunk(size, next);
+  }
+
+  void* arena_allocator::system_allocate(std::size_t& size)
+  {
+#ifdef MFAST_ARENA_USE_MMAP
+    if (mapped_) {
+      void* block = MAP_FAILED;
+#ifdef MAP_HUGETLB
+      if (policy_.huge_pages) {
+        std::size_t huge_size = align(size, huge_page_size);
+        block = mmap(0, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED)
+          size = huge_size;
+      }
+#endif
+      if (block == MAP_FAILED) {
+        // no huge pages reserved by the system, fall back to regular pages
+        size = align(size, static_cast<std::size_t>(sysconf(_SC_PAGESIZE)));
+        block = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED)
+          throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (policy_.huge_pages)
+          madvise(block, size, MADV_HUGEPAGE);
+#endif
+      }
+#if defined(__linux__) && defined(SYS_mbind)
+      if (policy_.numa_node >= 0 && policy_.numa_node < 63) {
+        // MPOL_BIND; the default placement stays in effect if the kernel rejects it
+        unsigned long nodemask = 1UL << policy_.numa_node;
+        syscall(SYS_mbind, block, size, 2, &nodemask, sizeof(nodemask)*8, 0);
+      }
+#endif
+      return block;
+    }
+#endif
+    void* block = malloc(size);
+    if (block == 0)
+      throw std::bad_alloc();
+    return block;
+  }
+
+  void arena_allocator::system_deallocate(void* block, std::size_t size)
   {
-    void* block = malloc(default_chunk_size);
-    current_list_head_ = new (block) memory_chunk(default_chunk_size, 0);
+#ifdef MFAST_ARENA_USE_MMAP
+    if (mapped_) {
+      munmap(block, size);
+      return;
+    }
+#endif
+    (void) size;
+    free(block);
   }
 
   arena_allocator::~arena_allocator()
@@ -81,10 +179,8 @@ namespace mfast {
         std::size_t new_chunk_size = align(n+ sizeof(memory_chunk) - sizeof(uint64_t), // minimum size for the new block
                                            default_chunk_size); // make the size multiple of default_chunk_size
 
-        void* block = malloc(new_chunk_size);
-        if (block == 0)
-          throw std::bad_alloc();
-        current_list_head_ = new (block) memory_chunk(new_chunk_size, current_list_head_);
+        current_list_head_ = new_chunk((std::max)(new_chunk_size, next_chunk_size_), current_list_head_);
+        next_chunk_size_ = (std::min)(next_chunk_size_ * policy_.growth_factor, policy_.max_chunk_size);
       }
     }
     char* result = current_list_head_->start_;
@@ -92,14 +188,73 @@ namespace mfast {
     return result;
   }
 
+  std::size_t arena_allocator::recycled_class_of(std::size_t size)
+  {
+    std::size_t index = 0;
+    while (index+1 < num_recycled_classes &&
+           (std::size_t(min_recycled_size) << (index+1)) <= size)
+      ++index;
+    return index;
+  }
+
+  void arena_allocator::recycle(void* pointer, std::size_t size)
+  {
+    if (pointer == 0 || size < min_recycled_size)
+      return;
+
+    std::size_t index = recycled_class_of(size);
+    recycled_block* block = static_cast<recycled_block*>(pointer);
+    block->next_ = recycled_[index];
+    block->size_ = size;
+    recycled_[index] = block;
+  }
+
+  void* arena_allocator::reuse(std::size_t& size)
+  {
+    // any block in a class above the one of size is big enough
+    std::size_t index = recycled_class_of(size);
+    if ((std::size_t(min_recycled_size) << index) < size)
+      ++index;
+
+    for (; index < num_recycled_classes; ++index) {
+      recycled_block** link = &recycled_[index];
+      for (; *link; link = &(*link)->next_) {
+        recycled_block* block = *link;
+        if (block->size_ >= size) {
+          *link = block->next_;
+          size = block->size_;
+          return block;
+        }
+      }
+    }
+    return 0;
+  }
+
   std::size_t
   arena_allocator::reallocate(void*& pointer, std::size_t old_size, std::size_t new_size)
   {
     // make the new_size at least 64 bytes
     new_size = align(static_cast<std::size_t>(new_size)*2, 64);
-    void* old_pointer = pointer;
-    pointer = this->allocate(new_size);
-    std::memcpy(pointer, old_pointer, old_size);
+
+    char* old_pointer = static_cast<char*>(pointer);
+    memory_chunk* chunk = current_list_head_;
+
+    if (old_size > 0 &&
+        old_pointer + old_size == chunk->start_ &&
+        old_pointer >= reinterpret_cast<char*>(chunk->user_memory) &&
+        static_cast<std::size_t>(chunk->end_ - old_pointer) >= new_size) {
+      // the block is the last one in the current chunk, extend it in place
+      chunk->start_ = old_pointer + new_size;
+      return new_size;
+    }
+
+    pointer = reuse(new_size);
+    if (pointer == 0)
+      pointer = this->allocate(new_size);
+    if (old_pointer) {
+      std::memcpy(pointer, old_pointer, old_size);
+      recycle(old_pointer, old_size);
+    }
     return new_size;
   }
 
@@ -119,6 +274,7 @@ namespace mfast {
     // only keeps the head of current_list_head_ list, the reset of the current_list moves to the free_list
     current_list_head_->next_ = 0;
     current_list_head_->start_ = reinterpret_cast<char*>(current_list_head_->user_memory);
+    std::fill(recycled_, recycled_ + num_recycled_classes, static_cast<recycled_block*>(0));
     return true;
   }
 
@@ -33,10 +33,52 @@ namespace mfast {
     : public allocator
   {
   public:
+    enum {
+      default_chunk_size=4096
+    };
+
+    /// Controls how memory chunks are obtained from the system.
+    ///
+    /// The default policy allocates fixed size chunks with malloc(). Requesting huge pages
+    /// or a NUMA node makes the chunks come from mmap(); if the system does not support
+    /// the request, regular pages and the default memory placement are used instead.
+    struct chunk_policy
+    {
+      chunk_policy()
+        : chunk_size(default_chunk_size)
+        , growth_factor(1)
+        , max_chunk_size(64*1024*1024)
+        , huge_pages(false)
+        , numa_node(-1)
+        , prefault(false)
+      {
+      }
+
+      /// The size of the first chunk.
+      std::size_t chunk_size;
+      /// Each chunk obtained afterwards is growth_factor times as big as the previous one.
+      std::size_t growth_factor;
+      /// The growth stops at this size.
+      std::size_t max_chunk_size;
+      /// Back the chunks with 2 MB huge pages.
+      bool huge_pages;
+      /// Bind the chunks to this NUMA node; -1 for no binding.
+      int numa_node;
+      /// Touch every page of the first chunk in the constructor.
+      bool prefault;
+    };
+
     arena_allocator();
-    ~arena_allocator();
+    explicit arena_allocator(const chunk_policy& policy);
+    virtual ~arena_allocator();
 
     virtual void* allocate(std::size_t n);
+    /// Grow a memory block.
+    ///
+    /// If @a pointer is the last block allocated from the current chunk and the chunk has
+    /// enough room left, the block is extended in place. Otherwise, a block given up by
+    /// a previous reallocate() call is reused if possible before new memory is taken from
+    /// the chunk; the old block is then kept for reuse in turn.
     virtual std::size_t reallocate(void*& pointer, std::size_t old_size, std::size_t new_size);
 
     /// Release all previously allocated memory blocks
@@ -76,7 +118,24 @@ namespace mfast {
 
     };
 
+    struct recycled_block
+    {
+      recycled_block* next_;
+      std::size_t size_;
+    };
+
+    enum {
+      min_recycled_size = 64,
+      num_recycled_classes = 16
+    };
+
     void free_list(memory_chunk_base* list);
+    static std::size_t recycled_class_of(std::size_t size);
+    void recycle(void* pointer, std::size_t size);
+    void* reuse(std::size_t& size);
+    memory_chunk* new_chunk(std::size_t size, memory_chunk* next);
+    void* system_allocate(std::size_t& size);
+    void system_deallocate(void* block, std::size_t size);
 
     // We maintian two singlely linked list of memory chunks : current_list and free_list.
     // The head of current_list is where new smaller memory blocks are allocated from. The
@@ -85,10 +144,15 @@ namespace mfast {
     // from if the available size of the head of current_list is not enough.
     memory_chunk* current_list_head_;
     memory_chunk* free_list_head_;
+    chunk_policy policy_;
+    // Blocks given up by reallocate(), grouped by the highest power of 2 multiple of
+    // min_recycled_size not exceeding their sizes.
+    recycled_block* recycled_[num_recycled_classes];
+    std::size_t next_chunk_size_;
+    bool mapped_;
 
   public:
     enum {
-      default_chunk_size=4096,
       chunk_user_size = default_chunk_size - offsetof(struct memory_chunk_base, user_memory)
     };
 
@@ -121,7 +121,7 @@ namespace mfast
                               uint32_t                                delta_len) const
       {
         std::size_t base_len = base_value.array_length();
-        const typename STRING_MREF::value_type* base_str = static_cast<const typename STRING_MREF::value_type*>(base_value.of_array.content_);
+        const typename STRING_MREF::value_type* base_str = static_cast<const typename STRING_MREF::value_type*>(base_value.array_content());
         std::size_t delta_start_index;
         std::size_t base_start_index;
 
@@ -139,6 +139,7 @@ void dictionary_builder::build_group(const field_instruction*       fi,
 
   dest->set_subinstructions(instructions_view_t(subinstructions,
                                                 instructions_count));
+  dest->build_subinstruction_index(alloc_);
 
   current_type_ = inherited_type;
   current_ns_ = inherited_ns;
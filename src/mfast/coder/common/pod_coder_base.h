@@ -0,0 +1,233 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef POD_CODER_BASE_H_R4T8WJ2C
+#define POD_CODER_BASE_H_R4T8WJ2C
+
+#include "mfast/instructions/int_instructions.h"
+#include "mfast/instructions/decimal_instruction.h"
+#include "mfast/instructions/string_instructions.h"
+#include "mfast/instructions/byte_vector_instruction.h"
+#include "mfast/instructions/sequence_instruction.h"
+#include "mfast/instructions/template_instruction.h"
+#include "mfast/malloc_allocator.h"
+#include "mfast/ext_ref.h"
+#include "mfast/pod_types.h"
+#include "exceptions.h"
+#include "template_repo.h"
+#include <cstring>
+
+namespace mfast
+{
+  namespace coder
+  {
+    // Where the value of an integer dictionary entry is kept; the exponent of a decimal
+    // with individual operators is kept with the other decimal values.
+    struct integer_slot
+    {
+      template <typename T>
+      static T get(const value_storage& storage)
+      {
+        return storage.get<T>();
+      }
+
+      template <typename T>
+      static void set(value_storage& storage, T v)
+      {
+        storage.set<T>(v);
+      }
+
+    };
+
+    struct exponent_slot
+    {
+      template <typename T>
+      static T get(const value_storage& storage)
+      {
+        return static_cast<T>(storage.of_decimal.exponent_);
+      }
+
+      template <typename T>
+      static void set(value_storage& storage, T v)
+      {
+        storage.of_decimal.exponent_ = static_cast<int16_t>(v);
+      }
+
+    };
+
+    /// The dictionary and the instructions shared by fast_pod_decoder and fast_pod_encoder.
+    ///
+    /// The dictionary entries are the same value_storage objects the message coders use,
+    /// so the dictionary scopes and keys of the templates are honored; the field values
+    /// themselves never go through value_storage. String and byteVector entries own a
+    /// copy of their content, allocated from the allocator passed to the constructor.
+    class pod_coder_base
+    {
+    protected:
+      pod_coder_base(allocator* alloc)
+        : repo_(alloc)
+        , alloc_(alloc)
+        , active_(0)
+        , group_(0)
+      {
+      }
+
+      template <typename DescriptionsTuple>
+      void init(const DescriptionsTuple& tp)
+      {
+        repo_.build(tp);
+        // a stream of a single template needs not carry the template id, see fast_encoder_v2
+        template_instruction** unique = repo_.unique_entry();
+        active_ = unique ? *unique : 0;
+      }
+
+      template <typename Pod>
+      const template_instruction* template_of()
+      {
+        const uint32_t id = Pod::message_type::the_id;
+        if (active_ && active_->id() == id)
+          return active_;
+
+        const template_instruction* inst = repo_.get_template(id);
+        if (inst == 0)
+          BOOST_THROW_EXCEPTION(fast_dynamic_error("D9") << template_id_info(id));
+        return inst;
+      }
+
+      template <typename Instruction>
+      static value_storage& previous_value_of(const Instruction* inst)
+      {
+        return const_cast<Instruction*>(inst)->prev_value();
+      }
+
+      // The base value of the delta operator, see codec_helper::delta_base_value_of()
+      static const value_storage& delta_base_value_of(const value_storage& previous,
+                                                      const value_storage& initial_or_default)
+      {
+        if (!previous.is_defined())
+          return initial_or_default;
+        if (previous.is_empty())
+          BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+        return previous;
+      }
+
+      // The base value of the tail operator, see codec_helper::tail_base_value_of()
+      static const value_storage& tail_base_value_of(const value_storage& previous,
+                                                     const value_storage& initial_or_default)
+      {
+        if (!previous.is_defined() || previous.is_empty())
+          return initial_or_default;
+        return previous;
+      }
+
+      template <typename T, typename Slot>
+      static bool is_initial_value(T value, bool present, const value_storage& initial, Slot)
+      {
+        return present != initial.is_empty() &&
+               (!present || value == Slot::template get<T>(initial));
+      }
+
+      static bool is_initial_value(const pod_decimal& value, bool present, const value_storage& initial)
+      {
+        return present != initial.is_empty() &&
+               (!present || (value.mantissa == initial.of_decimal.mantissa_ &&
+                             value.exponent == initial.of_decimal.exponent_));
+      }
+
+      static bool is_initial_value(const char* data, uint32_t length, bool present, const value_storage& initial)
+      {
+        return present != initial.is_empty() &&
+               (!present || equal_content(data, length, initial));
+      }
+
+      static bool equal_content(const char* data, uint32_t length, const value_storage& storage)
+      {
+        return storage.array_length() == length &&
+               (length == 0 || std::memcmp(data, storage.array_content(), length) == 0);
+      }
+
+      template <typename T, typename Slot>
+      static void save_integer(value_storage& entry, T value, bool present, Slot)
+      {
+        Slot::template set<T>(entry, value);
+        entry.present(present);
+        entry.defined(true);
+      }
+
+      static void save_decimal(value_storage& entry, const pod_decimal& value, bool present)
+      {
+        entry.present(present);
+        entry.of_decimal.exponent_ = value.exponent;
+        entry.of_decimal.mantissa_ = value.mantissa;
+        entry.defined(true);
+      }
+
+      void save_array(value_storage& entry, const char* data, uint32_t length, bool present)
+      {
+        entry.defined(true);
+        if (!present) {
+          entry.present(false);
+          return;
+        }
+
+        if (entry.of_array.capacity_in_bytes_ < length+1) {
+          // the entry may still refer to a buffer it doesn't own
+          if (entry.of_array.capacity_in_bytes_ == 0)
+            entry.of_array.content_ = 0;
+          entry.of_array.capacity_in_bytes_ = reallocate_array(alloc_,
+                                                               entry.of_array.content_,
+                                                               entry.of_array.capacity_in_bytes_,
+                                                               length+1);
+        }
+        entry.of_array.inline_ = 0;
+        if (length)
+          std::memcpy(entry.of_array.content_, data, length);
+        entry.array_length(length);
+      }
+
+      static void check_exponent(int exponent)
+      {
+        // [ERR R1]
+        if (exponent < -63 || exponent > 63)
+          BOOST_THROW_EXCEPTION(fast_reportable_error("R1"));
+      }
+
+      template <typename T>
+      static T add_delta(T base, int64_t delta)
+      {
+        return static_cast<T>(static_cast<uint64_t>(base) + static_cast<uint64_t>(delta));
+      }
+
+      template <typename T>
+      static int64_t delta_of(T value, T base)
+      {
+        return static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(base));
+      }
+
+      simple_template_repo_t repo_;
+      allocator* alloc_;
+      // the template of the previous message
+      const template_instruction* active_;
+      // the group, sequence or template whose fields are being coded
+      const group_field_instruction* group_;
+    };
+
+  } /* coder */
+} /* mfast */
+
+#endif /* end of include guard: POD_CODER_BASE_H_R4T8WJ2C */
@@ -0,0 +1,62 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef SEQUENCE_LENGTH_STATS_H_K7QD3M5N
+#define SEQUENCE_LENGTH_STATS_H_K7QD3M5N
+
+#include "mfast/instructions/sequence_instruction.h"
+#include <algorithm>
+
+namespace mfast
+{
+
+/// The lengths a decoder has observed for a sequence.
+struct sequence_length_stats
+{
+  const sequence_field_instruction* instruction;
+  /// The number of times the sequence has been decoded.
+  uint64_t count;
+  /// The largest decoded length.
+  uint32_t high_water_mark;
+  /// Exponentially weighted moving average of the decoded lengths, with a weight of 1/8
+  /// for the latest length.
+  double average;
+
+  /// Adds a decoded length of the sequence of @a inst and returns the capacity to reserve
+  /// when the length exceeds the capacity of the sequence, which is 1.25 times the
+  /// high-water mark.
+  ///
+  /// @pre The statistics were value initialized before their first use.
+  std::size_t add(const sequence_field_instruction* inst, uint32_t length)
+  {
+    if (count++ == 0) {
+      instruction = inst;
+      average = length;
+    }
+    else {
+      average += (length - average)/8;
+    }
+    high_water_mark = (std::max)(high_water_mark, length);
+    return high_water_mark + static_cast<std::size_t>(high_water_mark/4);
+  }
+
+};
+
+}
+
+#endif /* end of include guard: SEQUENCE_LENGTH_STATS_H_K7QD3M5N */
@@ -0,0 +1,227 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef STOP_BIT_CODEC_H_N4C8TQ2E
+#define STOP_BIT_CODEC_H_N4C8TQ2E
+
+#include <boost/detail/endian.hpp>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MFAST_STOP_BIT_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <stdlib.h>
+#endif
+
+namespace mfast
+{
+  namespace detail
+  {
+    // Bulk coding of non-nullable stop bit encoded integers, as used by the int vector fields.
+    //
+    // An integer of at most 8 bytes is handled as a single 64 bit word: the 7 bit groups
+    // are packed or spread with three shift-and-mask steps instead of one shift per byte.
+    // Longer integers, which only occur for 64 bit values, are left to the scalar code.
+
+    inline unsigned count_leading_zeros(uint64_t v)
+    {
+      // v must not be 0
+#if defined(__GNUC__)
+      return static_cast<unsigned>(__builtin_clzll(v));
+#elif defined(_MSC_VER) && defined(_M_X64)
+      unsigned long index;
+      _BitScanReverse64(&index, v);
+      return 63 - static_cast<unsigned>(index);
+#else
+      unsigned n = 0;
+      for (; (v & 0x8000000000000000ULL) == 0; v <<= 1)
+        ++n;
+      return n;
+#endif
+    }
+
+    inline unsigned count_trailing_zeros(uint32_t v)
+    {
+      // v must not be 0
+#if defined(__GNUC__)
+      return static_cast<unsigned>(__builtin_ctz(v));
+#elif defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, v);
+      return static_cast<unsigned>(index);
+#else
+      unsigned n = 0;
+      for (; (v & 1) == 0; v >>= 1)
+        ++n;
+      return n;
+#endif
+    }
+
+    inline uint64_t byte_swap(uint64_t v)
+    {
+#if defined(__GNUC__)
+      return __builtin_bswap64(v);
+#elif defined(_MSC_VER)
+      return _byteswap_uint64(v);
+#else
+      v = ((v & 0x00FF00FF00FF00FFULL) << 8) | ((v >> 8) & 0x00FF00FF00FF00FFULL);
+      v = ((v & 0x0000FFFF0000FFFFULL) << 16) | ((v >> 16) & 0x0000FFFF0000FFFFULL);
+      return (v << 32) | (v >> 32);
+#endif
+    }
+
+    // the first byte at p becomes the most significant one
+    inline uint64_t load_big_endian(const char* p)
+    {
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+#ifdef BOOST_BIG_ENDIAN
+      return v;
+#else
+      return byte_swap(v);
+#endif
+    }
+
+    inline void store_big_endian(char* p, uint64_t v)
+    {
+#ifndef BOOST_BIG_ENDIAN
+      v = byte_swap(v);
+#endif
+      std::memcpy(p, &v, 8);
+    }
+
+    // Returns the integer held by the first len (<= 8) bytes of word, which was loaded
+    // with load_big_endian().
+    template <typename T>
+    inline T extract_stop_bit_integer(uint64_t word, unsigned len)
+    {
+      uint64_t v = (word >> (64 - 8*len)) & 0x7F7F7F7F7F7F7F7FULL;
+      v = (v & 0x007F007F007F007FULL) | ((v >> 1) & 0x3F803F803F803F80ULL);
+      v = (v & 0x00003FFF00003FFFULL) | ((v >> 2) & 0x0FFFC0000FFFC000ULL);
+      v = (v & 0x000000000FFFFFFFULL) | ((v >> 4) & 0x00FFFFFFF0000000ULL);
+      if (std::is_signed<T>::value) {
+        // the most significant bit of the first byte is the sign bit
+        const unsigned shift = 64 - 7*len;
+        return static_cast<T>(static_cast<int64_t>(v << shift) >> shift);
+      }
+      return static_cast<T>(v);
+    }
+
+    /// Decodes up to @a n integers from [first, last) into @a elements, advancing @a first.
+    ///
+    /// Decoding stops early at an integer longer than 8 bytes or when fewer than 8 bytes
+    /// are left, so that the caller can finish with the scalar decoder, which also reports
+    /// buffer underflows.
+    ///
+    /// @return the number of integers decoded.
+    template <typename T>
+    std::size_t decode_stop_bit_integers(const char*& first, const char* last, T* elements, std::size_t n)
+    {
+      std::size_t count = 0;
+#ifdef MFAST_STOP_BIT_SSE2
+      // Locate the stop bits of 16 bytes at a time; every integer ending in the block is
+      // then extracted without looking at its bytes one by one. The 8 byte loads of the
+      // integers starting in the block stay within [first, first+24).
+      while (count < n && last - first >= 24) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        uint32_t stops = static_cast<uint32_t>(_mm_movemask_epi8(block));
+        if (stops == 0)
+          return count;
+
+        const char* p = first;
+        do {
+          unsigned len = static_cast<unsigned>(first + count_trailing_zeros(stops) + 1 - p);
+          if (len > 8) {
+            first = p;
+            return count;
+          }
+          elements[count++] = extract_stop_bit_integer<T>(load_big_endian(p), len);
+          p += len;
+          stops &= stops - 1;
+        } while (stops && count < n);
+        first = p;
+      }
+#endif
+      while (count < n && last - first >= 8) {
+        uint64_t word = load_big_endian(first);
+        uint64_t stops = word & 0x8080808080808080ULL;
+        if (stops == 0)
+          return count;
+        unsigned len = count_leading_zeros(stops)/8 + 1;
+        elements[count++] = extract_stop_bit_integer<T>(word, len);
+        first += len;
+      }
+      return count;
+    }
+
+    // Returns the number of bytes of the non-nullable encoding of v.
+    template <typename T>
+    inline typename std::enable_if<std::is_signed<T>::value, unsigned>::type
+    stop_bit_length(T v)
+    {
+      // the significant bits plus a sign bit
+      uint64_t magnitude = static_cast<uint64_t>(v < 0 ? ~static_cast<int64_t>(v) : static_cast<int64_t>(v));
+      return magnitude == 0 ? 1 : (64 - count_leading_zeros(magnitude))/7 + 1;
+    }
+
+    template <typename T>
+    inline typename std::enable_if<std::is_unsigned<T>::value, unsigned>::type
+    stop_bit_length(T v)
+    {
+      return v == 0 ? 1 : (64 - count_leading_zeros(v) + 6)/7;
+    }
+
+    /// Writes the non-nullable encoding of @a value at @a p and returns the end of it.
+    ///
+    /// Up to 8 bytes past the end may be overwritten.
+    template <typename T>
+    char* insert_stop_bit_integer(char* p, T value)
+    {
+      const unsigned len = stop_bit_length(value);
+      const uint64_t bits = static_cast<uint64_t>(static_cast<typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>(value));
+      if (len <= 8) {
+        uint64_t v = bits & 0x00FFFFFFFFFFFFFFULL;
+        v = (v & 0x000000000FFFFFFFULL) | ((v << 4) & 0x0FFFFFFF00000000ULL);
+        v = (v & 0x00003FFF00003FFFULL) | ((v << 2) & 0x3FFF00003FFF0000ULL);
+        v = (v & 0x007F007F007F007FULL) | ((v << 1) & 0x7F007F007F007F00ULL);
+        v = (v | 0x80) << (64 - 8*len);
+        store_big_endian(p, v);
+        return p + len;
+      }
+
+      for (unsigned i = 0; i < len; ++i) {
+        const unsigned shift = 7*(len - 1 - i);
+        // the first group extends past bit 63 and takes the sign from there
+        uint64_t group = std::is_signed<T>::value ?
+                         static_cast<uint64_t>(static_cast<int64_t>(bits) >> shift) : (bits >> shift);
+        p[i] = static_cast<char>(group & 0x7F);
+      }
+      p[len-1] |= '\x80';
+      return p + len;
+    }
+
+  }
+}
+
+#endif /* end of include guard: STOP_BIT_CODEC_H_N4C8TQ2E */
@@ -4,6 +4,9 @@
 #include "dictionary_builder.h"
 #include <boost/container/map.hpp>
 #include <map>
+#include <vector>
+#include <cstring>
+#include <algorithm>
 
 namespace mfast {
 
@@ -12,7 +15,8 @@ class template_repo_base
 public:
 
   template_repo_base(mfast::allocator* dictionary_alloc)
-    : dictionary_alloc_(dictionary_alloc)
+    : undo_log_active_(false)
+    , dictionary_alloc_(dictionary_alloc)
   {
   }
 
@@ -23,15 +27,92 @@ public:
         dictionary_alloc_->deallocate(vector_enties_[i]->of_array.content_,
                                       vector_enties_[i]->of_array.capacity_in_bytes_);
     }
+    for (std::size_t i = 0; i < owned_buffers_.size(); ++i) {
+      if (owned_buffers_[i].capacity_)
+        dictionary_alloc_->deallocate(owned_buffers_[i].content_, owned_buffers_[i].capacity_);
+    }
   }
 
   void reset_dictionary()
   {
+    if (undo_log_active_) {
+      for (std::size_t i = 0; i < reset_entries_.size(); ++i)
+        record_entry(*reset_entries_[i], undo_entry::defined_bit);
+    }
     for (std::size_t i = 0; i < reset_entries_.size(); ++i) {
       reset_entries_[i]->defined(false);
     }
   }
 
+  /// Starts recording the dictionary entries changed by the coder, so that
+  /// rollback_dictionary() can put back their values. Used for tentative coding
+  /// which must not leave any trace in the dictionary.
+  void start_undo_log()
+  {
+    undo_entries_.clear();
+    undo_contents_.clear();
+    undo_log_active_ = true;
+  }
+
+  bool undo_log_active() const
+  {
+    return undo_log_active_;
+  }
+
+  /// Records the value of @a entry before the coder changes it; @a is_array tells
+  /// whether it is the entry of a string or byteVector field.
+  void log_entry(value_storage& entry, bool is_array)
+  {
+    record_entry(entry, is_array ? undo_entry::array_value : undo_entry::scalar_value);
+  }
+
+  /// Puts back the values recorded since start_undo_log() and stops recording.
+  void rollback_dictionary()
+  {
+    // the entries are restored newest first, so that an entry logged more than
+    // once ends up with its oldest value
+    for (std::size_t i = undo_entries_.size(); i-- > 0; ) {
+      const undo_entry& undo = undo_entries_[i];
+      value_storage& entry = *undo.entry_;
+      switch (undo.kind_) {
+      case undo_entry::defined_bit:
+        entry.defined(undo.saved_.is_defined());
+        break;
+      case undo_entry::scalar_value:
+        entry = undo.saved_;
+        break;
+      case undo_entry::array_value:
+        restore_array_entry(entry, undo.saved_, undo_contents_.data() + undo.content_offset_);
+        break;
+      }
+    }
+    undo_entries_.clear();
+    undo_contents_.clear();
+    undo_log_active_ = false;
+  }
+
+  /// Copies the content of string and byteVector entries which still refer to the storage
+  /// of a message into buffers owned by the dictionary. Afterwards, the messages can be
+  /// destroyed without affecting the subsequent coding.
+  void detach_vector_entries()
+  {
+    owned_buffers_.resize(vector_enties_.size());
+    for (std::size_t i = 0; i < vector_enties_.size(); ++i) {
+      value_storage& entry = *vector_enties_[i];
+      owned_buffer& buffer = owned_buffers_[i];
+      if (entry.of_array.capacity_in_bytes_ > 0 || entry.is_inline_array() ||
+          entry.of_array.content_ == buffer.content_)
+        continue;
+
+      std::size_t len = entry.array_length();
+      if (buffer.capacity_ < len+1)
+        buffer.capacity_ = dictionary_alloc_->reallocate(buffer.content_, buffer.capacity_, len+1);
+      if (len)
+        std::memcpy(buffer.content_, entry.of_array.content_, len);
+      entry.of_array.content_ = buffer.content_;
+    }
+  }
+
   virtual template_instruction* get_template(uint32_t id) = 0;
 
 private:
@@ -43,16 +124,95 @@ private:
 
   void add_vector_entry(value_storage* entry)
   {
-    if (dictionary_alloc_)
+    // an entry shared by several instructions with the same key is only tracked once
+    if (dictionary_alloc_ &&
+        std::find(vector_enties_.begin(), vector_enties_.end(), entry) == vector_enties_.end())
       vector_enties_.push_back(entry);
   }
 
+  void record_entry(value_storage& entry, int kind)
+  {
+    undo_entry undo;
+    undo.entry_ = &entry;
+    undo.saved_ = entry;
+    undo.kind_ = kind;
+    undo.content_offset_ = undo_contents_.size();
+    // The content of string and byteVector entries may be overwritten or reallocated
+    // in place; therefore, we need to keep the bytes as well. Inline contents are
+    // kept in saved_.
+    if (kind == undo_entry::array_value && entry.of_array.len_ > 1 && !entry.is_inline_array()) {
+      const char* content = static_cast<const char*>(entry.of_array.content_);
+      undo_contents_.insert(undo_contents_.end(), content, content + entry.array_length());
+    }
+    undo_entries_.push_back(undo);
+  }
+
+  void restore_array_entry(value_storage& entry, const value_storage& saved, const char* content)
+  {
+    // The buffers owned by the dictionary can only grow or move during coding, keep
+    // using them and copy the saved content back.
+    value_storage buffer = entry;
+    entry = saved;
+
+    if (entry.is_inline_array()) {
+      if (buffer.of_array.capacity_in_bytes_ > 0)
+        dictionary_alloc_->deallocate(buffer.of_array.content_, buffer.of_array.capacity_in_bytes_);
+      return;
+    }
+
+    if (buffer.of_array.capacity_in_bytes_ > 0) {
+      std::size_t len = entry.of_array.len_ > 1 ? entry.array_length() : 0;
+      entry.of_array.content_ = buffer.of_array.content_;
+      entry.of_array.capacity_in_bytes_ = buffer.of_array.capacity_in_bytes_;
+      if (entry.of_array.capacity_in_bytes_ < len+1) {
+        entry.of_array.capacity_in_bytes_ =
+          reallocate_array(dictionary_alloc_,
+                           entry.of_array.content_,
+                           entry.of_array.capacity_in_bytes_,
+                           len+1);
+      }
+      if (len)
+        std::memcpy(entry.of_array.content_, content, len);
+    }
+  }
+
 protected:
   friend class dictionary_builder;
 
+  struct owned_buffer
+  {
+    owned_buffer()
+      : content_(0)
+      , capacity_(0)
+    {
+    }
+
+    void* content_;
+    std::size_t capacity_;
+  };
+
   typedef std::vector<value_storage*> value_entries_t;
   value_entries_t reset_entries_;
   value_entries_t vector_enties_;   // for string and byteVector
+
+  struct undo_entry
+  {
+    enum {
+      defined_bit,
+      scalar_value,
+      array_value
+    };
+
+    value_storage* entry_;
+    value_storage saved_;
+    int kind_;
+    std::size_t content_offset_;
+  };
+
+  std::vector<undo_entry> undo_entries_;
+  std::vector<char> undo_contents_;
+  bool undo_log_active_;
+  std::vector<owned_buffer> owned_buffers_;
   arena_allocator instruction_alloc_;
   mfast::allocator* dictionary_alloc_;
 };
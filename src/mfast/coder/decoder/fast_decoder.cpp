@@ -22,6 +22,7 @@
 #include "mfast/field_visitor.h"
 #include "mfast/sequence_ref.h"
 #include "mfast/malloc_allocator.h"
+#include "mfast/arena_allocator.h"
 #include "mfast/output.h"
 #include "mfast/composite_type.h"
 #include "../common/exceptions.h"
@@ -32,6 +33,8 @@
 #include "decoder_field_operator.h"
 #include "fast_istream.h"
 #include "mfast/vector_ref.h"
+#include "mfast/utf8.h"
+#include <boost/container/flat_map.hpp>
 
 namespace mfast {
 
@@ -83,6 +86,13 @@ struct fast_decoder_impl
   template <typename SimpleMRef>
   void visit(SimpleMRef &mref);
 
+  template <typename SimpleMRef>
+  void check_utf8(const SimpleMRef&)
+  {
+  }
+
+  void check_utf8(const unicode_string_mref& mref);
+
   template <typename IntType>
   void visit(int_vector_mref<IntType>& mref);
 
@@ -92,6 +102,7 @@ struct fast_decoder_impl
   void visit(sequence_element_mref& mref, int);
 
   message_type*  decode_segment(fast_istreambuf& sb);
+  message_type*  arena_message(const template_instruction* inst);
 
   typedef message_type info_entry;
 
@@ -127,21 +138,35 @@ struct fast_decoder_impl
   debug_stream debug_;
   decoder_presence_map* current_;
   std::ostream* warning_log_;
+  arena_allocator* arenas_[2];
+  unsigned arena_index_;
+  bool length_hints_;
+  bool validate_utf8_;
+  typedef boost::container::flat_map<const sequence_field_instruction*, sequence_length_stats> length_stats_map_t;
+  length_stats_map_t length_stats_;
 };
 
 
 
 inline
 fast_decoder_impl::fast_decoder_impl(mfast::allocator* alloc)
-  : repo_(info_entry_converter(alloc))
+  : repo_(info_entry_converter(alloc), alloc)
   , message_alloc_(alloc)
   , strm_(0)
   , warning_log_(0)
+  , arena_index_(0)
+  , length_hints_(false)
+  , validate_utf8_(false)
 {
+  arenas_[0] = arenas_[1] = 0;
 }
 
 fast_decoder_impl::~fast_decoder_impl()
 {
+  // The messages in the arenas are never destructed, all their memory
+  // goes away with the arenas.
+  delete arenas_[0];
+  delete arenas_[1];
 }
 
 inline decoder_presence_map&
@@ -162,6 +187,7 @@ fast_decoder_impl::visit(SimpleMRef& mref)
   field_operator->decode(mref,
                          strm_,
                          current_pmap());
+  check_utf8(mref);
 
   if (mref.present())
     debug_ << "   decoded " << mref.name() << " = " << mref << "\n";
@@ -169,6 +195,15 @@ fast_decoder_impl::visit(SimpleMRef& mref)
     debug_ << "   decoded " << mref.name() << " is absent\n";
 }
 
+inline void
+fast_decoder_impl::check_utf8(const unicode_string_mref& mref)
+{
+  // FAST Specification 1.1: it is a reportable error [ERR R2] if the combined
+  // value of a unicode string is not a valid UTF-8 sequence
+  if (validate_utf8_ && mref.present() && !is_valid_utf8(mref.data(), mref.size()))
+    BOOST_THROW_EXCEPTION(fast_reportable_error("R2"));
+}
+
 template <typename IntType>
 void fast_decoder_impl::visit(int_vector_mref<IntType> &mref)
 {
@@ -181,9 +216,7 @@ void fast_decoder_impl::visit(int_vector_mref<IntType> &mref)
   }
 
   mref.resize(length);
-  for (uint32_t i = 0; i < length; ++i) {
-    strm_.decode(mref[i], false);
-  }
+  strm_.decode_integers(mref.data(), length);
 }
 
 inline void
@@ -232,8 +265,14 @@ fast_decoder_impl::visit(sequence_mref& mref, int)
 
 
   if (length_mref.present()) {
-    debug_ << "  decoded sequence length " << length_mref.value() << "\n";
-    mref.resize(length_mref.value());
+    uint32_t length = length_mref.value();
+    debug_ << "  decoded sequence length " << length << "\n";
+    if (length_hints_) {
+      std::size_t hint = length_stats_[mref.instruction()].add(mref.instruction(), length);
+      if (length > mref.capacity())
+        mref.reserve(hint);
+    }
+    mref.resize(length);
   }
   else {
     debug_ << "  " << mref.name() << "is absent\n";
@@ -338,11 +377,28 @@ fast_decoder_impl::decode_segment(fast_istreambuf& sb)
   // because after the accept_mutator(), the active_message_
   // may change because of the decoding of dynamic template reference
   message_type* message = active_message_;
+  if (arenas_[0]) {
+    message = arena_message(message->instruction());
+  }
   // message->ensure_valid();
   message->ref().accept_mutator(*this);
+
+  if (arenas_[0]) {
+    // the string values in the dictionary must not refer to the arenas
+    repo_.detach_vector_entries();
+  }
   return message;
 }
 
+inline message_type*
+fast_decoder_impl::arena_message(const template_instruction* inst)
+{
+  arena_index_ ^= 1;
+  arena_allocator& arena = *arenas_[arena_index_];
+  arena.reset();
+  return new (arena) message_type(&arena, inst);
+}
+
 fast_decoder::fast_decoder(allocator* alloc)
   : impl_(new fast_decoder_impl(alloc))
 {
@@ -371,6 +427,37 @@ fast_decoder::decode(const char*& first, const char* last, bool force_reset)
   return result;
 }
 
+void
+fast_decoder::auto_reset_arenas(bool enabled, const arena_allocator::chunk_policy& policy)
+{
+  for (unsigned i = 0; i < 2; ++i) {
+    delete impl_->arenas_[i];
+    impl_->arenas_[i] = enabled ? new arena_allocator(policy) : 0;
+  }
+}
+
+void
+fast_decoder::sequence_length_hints(bool enabled)
+{
+  impl_->length_hints_ = enabled;
+}
+
+void
+fast_decoder::validate_utf8(bool enabled)
+{
+  impl_->validate_utf8_ = enabled;
+}
+
+std::vector<sequence_length_stats>
+fast_decoder::sequence_statistics() const
+{
+  std::vector<sequence_length_stats> result;
+  fast_decoder_impl::length_stats_map_t::const_iterator itr;
+  for (itr = impl_->length_stats_.begin(); itr != impl_->length_stats_.end(); ++itr)
+    result.push_back(itr->second);
+  return result;
+}
+
 void
 fast_decoder::debug_log(std::ostream* log)
 {
@@ -7,6 +7,7 @@
 #include "mfast/instructions/byte_vector_instruction.h"
 #include "fast_istreambuf.h"
 #include "decoder_presence_map.h"
+#include "../common/stop_bit_codec.h"
 
 namespace mfast
 {
@@ -40,6 +41,15 @@ namespace mfast
     typename std::enable_if< std::is_integral<T>::value,bool>::type
     decode(T& result, Nullable nullable);
 
+    /**
+     * Decode @a n non-nullable integers, such as the elements of an int vector.
+     *
+     * The integers of up to 8 bytes are decoded in bulk; the result is the same as
+     * calling decode(elements[i], false) @a n times.
+     **/
+    template <typename T>
+    void decode_integers(T* elements, std::size_t n);
+
 
     void decode(decoder_presence_map& pmap)
     {
@@ -326,6 +336,20 @@ namespace mfast
     return true;
   }
 
+  template <typename T>
+  void
+  fast_istream::decode_integers(T* elements, std::size_t n)
+  {
+    std::size_t i = 0;
+    for (;;) {
+      i += detail::decode_stop_bit_integers(buf_->gptr_, buf_->egptr_, elements+i, n-i);
+      if (i == n)
+        return;
+      // an integer longer than 8 bytes, or one close to the end of the buffer
+      this->decode(elements[i++], false);
+    }
+  }
+
 }
 
 
@@ -4,6 +4,7 @@
 #include "../mfast_coder_export.h"
 
 #include <boost/container/map.hpp>
+#include <boost/container/flat_map.hpp>
 #include "mfast/sequence_ref.h"
 #include "mfast/nested_message_ref.h"
 #include "mfast/malloc_allocator.h"
@@ -13,9 +14,11 @@
 #include "../common/debug_stream.h"
 #include "../common/template_repo.h"
 #include "../common/codec_helper.h"
+#include "../common/sequence_length_stats.h"
 #include "../decoder/decoder_presence_map.h"
 #include "../common/codec_helper.h"
 #include "../decoder/fast_istream.h"
+#include "mfast/utf8.h"
 #include "fast_istream_extractor.h"
 #include <tuple>
 #include <vector>
@@ -34,6 +37,69 @@ struct MFAST_CODER_EXPORT fast_decoder_base
 {
   fast_decoder_base(allocator* alloc);
 
+  /// Enables or disables reporting which top level fields of a decoded message may differ
+  /// from the value their dictionary entry held before the message, see field_changed().
+  void report_changed_fields(bool enabled)
+  {
+    track_changes_ = enabled;
+    changed_fields_.clear();
+  }
+
+  /// Returns false if the field at @a index of the last decoded message is known to equal the
+  /// previous value of its dictionary entry, which is the case when the value is taken from
+  /// the dictionary by a copy or tail operator, or if it is a mandatory constant. Every other
+  /// field, including the fields of sequences, optional groups and dynamic templateRefs, is
+  /// reported as changed.
+  ///
+  /// Only with a template scoped dictionary is the previous dictionary value the value of the
+  /// field in the previous message of the same template. With the default global dictionary,
+  /// the entry is shared by every field of the same name and may have been last set by a
+  /// message of another template.
+  ///
+  /// @pre report_changed_fields(true) was called before decoding the message.
+  bool field_changed(std::size_t index) const
+  {
+    return index >= changed_fields_.size()*64 ||
+           ((changed_fields_[index/64] >> (index%64)) & 1);
+  }
+
+  /// The changed fields of the last decoded message as a bitmap, a bit per top level field,
+  /// least significant bit first.
+  const std::vector<uint64_t>& changed_fields() const
+  {
+    return changed_fields_;
+  }
+
+  /// Enables or disables checking that the unicode string fields of the decoded messages
+  /// are valid UTF-8.
+  ///
+  /// When enabled, decode() throws a fast_reportable_error with error code R2 for a unicode
+  /// value which is not. Values copied from the dictionary are not checked again.
+  void validate_utf8(bool enabled)
+  {
+    validate_utf8_ = enabled;
+  }
+
+  /// Reserve the elements of a sequence according to its decoding history.
+  ///
+  /// When enabled, the decoder tracks the decoded lengths of each sequence. Whenever a
+  /// decoded length exceeds the capacity of the sequence, the capacity is raised to 1.25
+  /// times the largest length observed so far rather than to the decoded length, see
+  /// fast_decoder::sequence_length_hints().
+  void sequence_length_hints(bool enabled)
+  {
+    length_hints_ = enabled;
+  }
+
+  /// Returns the length statistics of every sequence decoded while hints were enabled.
+  std::vector<sequence_length_stats> sequence_statistics() const
+  {
+    std::vector<sequence_length_stats> result;
+    length_stats_map_t::const_iterator itr;
+    for (itr = length_stats_.begin(); itr != length_stats_.end(); ++itr)
+      result.push_back(itr->second);
+    return result;
+  }
 
 
 
@@ -46,73 +112,97 @@ struct MFAST_CODER_EXPORT fast_decoder_base
 
   virtual void visit(const nested_message_mref& mref)=0;
 
+  // The decode_field() overloads return whether the decoded value may differ from the
+  // previous value of its dictionary entry; the operator overloads, whether the value is
+  // known to equal it instead.
   template <typename T, typename TypeCategory>
-  void decode_field(const T &ext_ref, TypeCategory);
+  bool decode_field(const T &ext_ref, TypeCategory);
 
   template <typename T>
-  void decode_field(const T &ext_ref, split_decimal_type_tag);
+  bool decode_field(const T &ext_ref, split_decimal_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref, int_vector_type_tag);
+  bool decode_field(const T &ext_ref, int_vector_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref, group_type_tag);
+  bool decode_field(const T &ext_ref, group_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref, sequence_type_tag);
+  bool decode_field(const T &ext_ref, sequence_type_tag);
 
 
   template <typename T, typename TypeCategory>
-  void decode_field (const T &ext_ref,
+  bool decode_field (const T &ext_ref,
                      none_operator_tag,
                      TypeCategory);
 
   template <typename T, typename TypeCategory>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     constant_operator_tag,
                     TypeCategory);
 
   template <typename T, typename TypeCategory>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     copy_operator_tag,
                     TypeCategory);
 
   template <typename T, typename TypeCategory>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     increment_operator_tag,
                     TypeCategory);
 
   template <typename T, typename TypeCategory>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     default_operator_tag,
                     TypeCategory);
 
   template <typename T>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     delta_operator_tag,
                     integer_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     delta_operator_tag,
                     string_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     delta_operator_tag,
                     decimal_type_tag);
 
   template <typename T>
-  void decode_field(const T &ext_ref,
+  bool decode_field(const T &ext_ref,
                     tail_operator_tag,
                     string_type_tag);
 
+  void start_changed_fields(std::size_t num_fields);
+  void mark_changed_field(bool changed);
+
+  template <typename CRef>
+  void check_utf8(const CRef&)
+  {
+  }
 
+  void check_utf8(const unicode_string_cref& ref);
 
   fast_istream strm_;
   allocator* message_alloc_;
   bool force_reset_;
   decoder_presence_map* current_;
+
+  // changed field tracking; only the top level fields of a message get a bit
+  bool track_changes_;
+  unsigned nesting_level_;
+  std::size_t field_index_;
+  bool field_changed_;
+  std::vector<uint64_t> changed_fields_;
+
+  bool validate_utf8_;
+
+  bool length_hints_;
+  typedef boost::container::flat_map<const sequence_field_instruction*, sequence_length_stats> length_stats_map_t;
+  length_stats_map_t length_stats_;
 };
 
 
@@ -272,7 +362,37 @@ fast_decoder_base::fast_decoder_base(allocator* alloc)
   , message_alloc_(alloc)
   , force_reset_(false)
   , current_(0)
+  , track_changes_(false)
+  , nesting_level_(0)
+  , field_index_(0)
+  , field_changed_(false)
+  , validate_utf8_(false)
+  , length_hints_(false)
+{
+}
+
+inline void
+fast_decoder_base::check_utf8(const unicode_string_cref& ref)
 {
+  // [ERR R2]
+  if (validate_utf8_ && ref.present() && !is_valid_utf8(ref.data(), ref.size()))
+    BOOST_THROW_EXCEPTION(fast_reportable_error("R2"));
+}
+
+inline void
+fast_decoder_base::start_changed_fields(std::size_t num_fields)
+{
+  nesting_level_ = 0;
+  field_index_ = 0;
+  changed_fields_.assign((num_fields + 63)/64, 0);
+}
+
+inline void
+fast_decoder_base::mark_changed_field(bool changed)
+{
+  if (changed && field_index_ < changed_fields_.size()*64)
+    changed_fields_[field_index_/64] |= uint64_t(1) << (field_index_%64);
+  ++field_index_;
 }
 
 template <typename T>
@@ -280,21 +400,37 @@ inline void
 fast_decoder_base::visit(const T& ext_ref)
 {
   typedef typename T::type_category type_category;
-  this->decode_field(ext_ref, type_category());
+  if (!track_changes_) {
+    this->decode_field(ext_ref, type_category());
+  }
+  else if (nesting_level_ == 0) {
+    // a top level field is changed if any of the values decoded inside it may have changed
+    field_changed_ = false;
+    ++nesting_level_;
+    bool changed = this->decode_field(ext_ref, type_category());
+    --nesting_level_;
+    mark_changed_field(changed || field_changed_);
+  }
+  else {
+    field_changed_ |= this->decode_field(ext_ref, type_category());
+  }
 }
 
 template <typename T, typename TypeCategory>
-inline void
+inline bool
 fast_decoder_base::decode_field(const T& ext_ref, TypeCategory)
 {
-  this->decode_field(ext_ref,
-                     typename T::operator_category(),
-                     TypeCategory());
-
+  bool unchanged = this->decode_field(ext_ref,
+                                      typename T::operator_category(),
+                                      TypeCategory());
+  // a value taken from the dictionary has been checked when it was decoded
+  if (!unchanged)
+    this->check_utf8(ext_ref.get());
+  return !unchanged;
 }
 
 template <typename T>
-inline void
+inline bool
 fast_decoder_base::decode_field(const T& ext_ref, split_decimal_type_tag)
 {
 
@@ -304,10 +440,12 @@ fast_decoder_base::decode_field(const T& ext_ref, split_decimal_type_tag)
   {
     this->visit(ext_ref.set_mantissa());
   }
+  // the exponent and mantissa report their own changes
+  return false;
 }
 
 template <typename T>
-inline void
+inline bool
 fast_decoder_base::decode_field(const T& ext_ref, int_vector_type_tag)
 {
   typename T::mref_type mref = ext_ref.set();
@@ -315,17 +453,16 @@ fast_decoder_base::decode_field(const T& ext_ref, int_vector_type_tag)
   uint32_t length=0;
   if (!this->strm_.decode(length, ext_ref.optional())) {
     ext_ref.omit();
-    return;
+    return true;
   }
 
   mref.resize(length);
-  for (uint32_t i = 0; i < length; ++i) {
-    this->strm_.decode(mref[i], false_type());
-  }
+  this->strm_.decode_integers(mref.data(), length);
+  return true;
 }
 
 template <typename T>
-inline void
+inline bool
 fast_decoder_base::decode_field(const T& ext_ref, group_type_tag)
 {
   // If a group field is optional, it will occupy a single bit in the presence map.
@@ -334,16 +471,19 @@ fast_decoder_base::decode_field(const T& ext_ref, group_type_tag)
   {
     if (!this->current_->is_next_bit_set()) {
       ext_ref.omit();
-      return;
+      return true;
     }
   }
 
   decoder_pmap_saver<typename T::pmap_segment_size_type> saver(this);
   ext_ref.set().accept(*this);
+  // the presence of an optional group is not kept in any dictionary;
+  // the subfields report their own changes
+  return ext_ref.optional();
 }
 
 template <typename T>
-inline void
+inline bool
 fast_decoder_base::decode_field(const T& ext_ref, sequence_type_tag)
 {
   value_storage storage;
@@ -353,6 +493,12 @@ fast_decoder_base::decode_field(const T& ext_ref, sequence_type_tag)
 
   if (length.present()) {
     std::size_t len = length.get().value();
+    if (length_hints_) {
+      typename T::mref_type mref = ext_ref.set();
+      std::size_t hint = length_stats_[mref.instruction()].add(mref.instruction(), length.get().value());
+      if (len > mref.capacity())
+        mref.reserve(hint);
+    }
     ext_ref.set().resize(len);
 
     for (std::size_t i = 0; i < len; ++i)
@@ -363,6 +509,9 @@ fast_decoder_base::decode_field(const T& ext_ref, sequence_type_tag)
   else {
     ext_ref.omit();
   }
+  // the elements share the dictionary values, which hence don't tell
+  // whether an element equals the element of the previous message.
+  return true;
 }
 
 template <typename Message>
@@ -374,7 +523,7 @@ fast_decoder_base::decode_message(const message_mref& mref)
 }
 
 template <typename T, typename TypeCategory>
-void fast_decoder_base::decode_field (const T& ext_ref,
+bool fast_decoder_base::decode_field (const T& ext_ref,
                                       none_operator_tag,
                                       TypeCategory)
 {
@@ -391,10 +540,11 @@ void fast_decoder_base::decode_field (const T& ext_ref,
   // value. It will not occupy any bits in the presence map.
   if (ext_ref.previous_value_shared())
       save_previous_value(ext_ref.set());
+  return false;
 }
 
 template <typename T, typename TypeCategory>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      constant_operator_tag,
                                      TypeCategory)
 {
@@ -418,10 +568,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
   }
   if (ext_ref.previous_value_shared())
       save_previous_value(mref);
+  return !ext_ref.optional();
 }
 
 template <typename T, typename TypeCategory>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      copy_operator_tag,
                                      TypeCategory)
 {
@@ -458,6 +609,7 @@ void fast_decoder_base::decode_field(const T& ext_ref,
         // if the previous value is empty – the value of the field is empty.
         // If the field is optional the value is considered absent.
         mref.omit();
+        return true;
       }
       else {
         // It is a dynamic error [ERR D6] if the field is mandatory.
@@ -468,12 +620,14 @@ void fast_decoder_base::decode_field(const T& ext_ref,
     else {
       // if the previous value is assigned – the value of the field is the previous value.
       load_previous_value(mref);
+      return true;
     }
   }
+  return false;
 }
 
 template <typename T, typename TypeCategory>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      increment_operator_tag,
                                      TypeCategory)
 {
@@ -524,10 +678,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
       load_previous_value(mref);
     }
   }
+  return false;
 }
 
 template <typename T, typename TypeCategory>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      default_operator_tag,
                                      TypeCategory)
 {
@@ -542,7 +697,7 @@ void fast_decoder_base::decode_field(const T& ext_ref,
     stream >> ext_ref;
     //  A NULL indicates that the value is absent and the state of the previous value is left unchanged.
     if (!ext_ref.present())
-      return;
+      return false;
   }
   else {
     // If the field has optional presence and no initial value, the field is considered absent
@@ -555,10 +710,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
 
   if (ext_ref.previous_value_shared())
     save_previous_value(mref);
+  return false;
 }
 
 template <typename T>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      delta_operator_tag,
                                      integer_type_tag)
 {
@@ -581,10 +737,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
     //  If the field has optional presence, the delta value can be NULL. In that case the value of the field is considered absent.
     mref.omit();
   }
+  return false;
 }
 
 template <typename T>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      delta_operator_tag,
                                      string_type_tag)
 {
@@ -617,10 +774,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
   else {
     mref.omit();
   }
+  return false;
 }
 
 template <typename T>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      delta_operator_tag,
                                      decimal_type_tag)
 {
@@ -639,10 +797,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
     //
     save_previous_value(mref);
   }
+  return false;
 }
 
 template <typename T>
-void fast_decoder_base::decode_field(const T& ext_ref,
+bool fast_decoder_base::decode_field(const T& ext_ref,
                                      tail_operator_tag,
                                      string_type_tag)
 {
@@ -697,10 +856,11 @@ void fast_decoder_base::decode_field(const T& ext_ref,
     else {
       // * assigned – the value of the field is the previous value.
       load_previous_value(mref);
-      return;
+      return true;
     }
   }
   save_previous_value(mref);
+  return false;
 }
 
 /////////////////////////////////////////////////////////
@@ -729,6 +889,14 @@ fast_decoder_core<NumTokens>::visit(const nested_message_mref& mref)
   decoder_pmap_saver<true_type> saver(this);
   info_entry* saved_active_info = this->active_message_info_;
 
+  bool top_level = false;
+  if (this->track_changes_) {
+    // the target may be of another template than the one of the previous message
+    this->field_changed_ = true;
+    top_level = this->nesting_level_ == 0;
+    this->nesting_level_ += top_level;
+  }
+
 
   if (this->current_->is_next_bit_set()) {
     uint32_t template_id;
@@ -749,6 +917,11 @@ fast_decoder_core<NumTokens>::visit(const nested_message_mref& mref)
 
   this->active_message_info_ = saved_active_info;
 
+  if (top_level) {
+    --this->nesting_level_;
+    this->mark_changed_field(true);
+  }
+
 }
 
 template <unsigned NumTokens>
@@ -784,6 +957,9 @@ fast_decoder_core<NumTokens>::decode_segment(fast_istreambuf& sb)
     repo_.reset_dictionary();
   }
 
+  if (track_changes_)
+    start_changed_fields(message.instruction()->subinstructions().size());
+
   message_decode_function_t decode = active_message_info_->decode_fun_;
   (this->*decode)(message);
 
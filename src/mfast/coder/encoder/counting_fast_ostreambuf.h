@@ -0,0 +1,100 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef COUNTING_FAST_OSTREAMBUF_H_Q3W8ZK2N
+#define COUNTING_FAST_OSTREAMBUF_H_Q3W8ZK2N
+
+#include "fast_ostreambuf.h"
+#include <vector>
+#include <algorithm>
+
+namespace mfast {
+
+  /// A stream buffer which only counts the number of bytes that would have been written.
+  ///
+  /// The bytes are put into a small scratch area which is recycled whenever it is full,
+  /// so the encoded stream is never materialized. Presence maps are never written back;
+  /// only their final length is taken into account.
+  ///
+  /// Because a presence map reserves its maximum size before it is shrunk, the encoder may
+  /// need more buffer space than the final length; peak_length() reports that amount.
+  class counting_fast_ostreambuf
+    : public fast_ostreambuf
+  {
+  public:
+    counting_fast_ostreambuf(std::vector<char>& scratch)
+      : fast_ostreambuf(0, 0)
+      , scratch_(scratch)
+      , discarded_(0)
+      , shrunk_(0)
+      , peak_(0)
+    {
+      if (scratch_.size() < 256)
+        scratch_.resize(256);
+      char* addr = &scratch_[0];
+      setp(addr, addr, addr+scratch_.size());
+    }
+
+    virtual std::size_t length() const
+    {
+      return discarded_ + (pptr_ - pbase_) - shrunk_;
+    }
+
+    /// The largest number of bytes the stream has occupied at any time.
+    std::size_t peak_length() const
+    {
+      return (std::max)(peak_, length());
+    }
+
+    virtual void write_bytes_at(const char* data, std::size_t n, std::size_t, bool shrink)
+    {
+      // Mirror the trailing zero bytes removal in fast_ostreambuf::write_bytes_at()
+      // without touching the bytes already counted.
+      if (shrink && n > 1 && data[n-1] == '\x80') {
+        peak_ = peak_length();
+        std::size_t index = n-2;
+        for (; index > 0 && data[index] == 0; --index) ;
+
+        if (data[index] & '\x80') {
+          ++index;
+        }
+        shrunk_ += n - (index+1);
+      }
+    }
+
+  protected:
+    virtual void overflow(std::size_t n)
+    {
+      discarded_ += pptr_ - pbase_;
+      if (n >= scratch_.size())
+        scratch_.resize(2*n);
+      char* addr = &scratch_[0];
+      setp(addr, addr, addr+scratch_.size());
+    }
+
+  private:
+    std::vector<char>& scratch_;
+    std::size_t discarded_;
+    std::size_t shrunk_;
+    std::size_t peak_;
+  };
+
+}
+
+#endif /* end of include guard: COUNTING_FAST_OSTREAMBUF_H_Q3W8ZK2N */
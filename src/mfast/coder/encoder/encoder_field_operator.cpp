@@ -358,7 +358,7 @@ namespace mfast
       template <typename T>
       bool operator() (const vector_cref<T>& v, const value_storage& prev) const
       {
-        return v.size() == prev.of_array.len_-1 && memcmp(v.data(),prev.of_array.content_, v.size()*sizeof(T)) == 0;
+        return v.size() == prev.of_array.len_-1 && memcmp(v.data(),prev.array_content(), v.size()*sizeof(T)) == 0;
       }
 
     };
@@ -623,11 +623,15 @@ namespace mfast
         typedef typename T::const_reverse_iterator const_reverse_iterator;
         typedef typename std::iterator_traits<const_iterator>::difference_type difference_type;
 
+        // Never compare past the end of the shorter value; the previous value buffer
+        // may hold stale bytes beyond its current length.
+        difference_type common_len = static_cast<difference_type>((std::min)(cref.size(), prev_cref.size()));
+
         std::pair<const_iterator, const_iterator> common_prefix_positions
-          = std::mismatch(cref.begin(), cref.end(), prev_cref.begin());
+          = std::mismatch(cref.begin(), cref.begin() + common_len, prev_cref.begin());
 
         std::pair<const_reverse_iterator, const_reverse_iterator> common_suffix_positions
-          = std::mismatch(cref.rbegin(), cref.rend(), prev_cref.rbegin());
+          = std::mismatch(cref.rbegin(), cref.rbegin() + common_len, prev_cref.rbegin());
 
         int32_t substraction_len;
         const_iterator delta_iterator;
@@ -65,6 +65,7 @@ namespace mfast
   inline void
   encoder_presence_map::init(fast_ostream* stream, std::size_t maxbits)
   {
+    reset();
     stream_ = stream;
     offset_ = stream->offset();
     maxbytes_ =  (maxbits +6)/7; // i.e. ceiling(maxbits/7)
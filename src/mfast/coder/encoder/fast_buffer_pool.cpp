@@ -0,0 +1,135 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <cstdlib>
+#include <new>
+#include "fast_buffer_pool.h"
+
+namespace mfast {
+
+  namespace {
+    const std::size_t min_size_bits = 8;
+    const std::size_t num_size_classes = 17; // 256 bytes to 16 MB
+    const std::size_t max_cached_buffers = 16;
+
+    struct free_buffer
+    {
+      free_buffer* next_;
+    };
+
+    struct free_lists
+    {
+      free_buffer* heads_[num_size_classes];
+      std::size_t counts_[num_size_classes];
+      std::size_t cached_bytes_;
+      // set once the lists have been destroyed; the destructors of other
+      // thread_local and static objects may still release buffers afterwards
+      bool torn_down_;
+
+      free_lists()
+        : cached_bytes_(0)
+        , torn_down_(false)
+      {
+        for (std::size_t i = 0; i < num_size_classes; ++i) {
+          heads_[i] = 0;
+          counts_[i] = 0;
+        }
+      }
+
+      ~free_lists()
+      {
+        for (std::size_t i = 0; i < num_size_classes; ++i) {
+          while (heads_[i]) {
+            free_buffer* next = heads_[i]->next_;
+            std::free(heads_[i]);
+            heads_[i] = next;
+          }
+          counts_[i] = 0;
+        }
+        cached_bytes_ = 0;
+        torn_down_ = true;
+      }
+
+    };
+
+    thread_local free_lists local_free_lists;
+
+    std::size_t size_class_of(std::size_t size)
+    {
+      std::size_t index = 0;
+      while ((fast_buffer_pool::min_pooled_size << index) < size)
+        ++index;
+      return index;
+    }
+
+  }
+
+  char* fast_buffer_pool::acquire(std::size_t& size)
+  {
+    if (size > max_pooled_size) {
+      void* result = std::malloc(size);
+      if (result == 0)
+        throw std::bad_alloc();
+      return static_cast<char*>(result);
+    }
+
+    std::size_t index = size_class_of(size);
+    size = min_pooled_size << index;
+
+    free_lists& lists = local_free_lists;
+    free_buffer* head = lists.torn_down_ ? 0 : lists.heads_[index];
+    if (head) {
+      lists.heads_[index] = head->next_;
+      --lists.counts_[index];
+      lists.cached_bytes_ -= size;
+      return reinterpret_cast<char*>(head);
+    }
+
+    void* result = std::malloc(size);
+    if (result == 0)
+      throw std::bad_alloc();
+    return static_cast<char*>(result);
+  }
+
+  void fast_buffer_pool::release(char* buffer, std::size_t size)
+  {
+    if (buffer == 0)
+      return;
+
+    if (size > max_pooled_size) {
+      std::free(buffer);
+      return;
+    }
+
+    std::size_t index = size_class_of(size);
+    free_lists& lists = local_free_lists;
+    if (lists.torn_down_ ||
+        lists.counts_[index] == max_cached_buffers ||
+        lists.cached_bytes_ + size > max_cached_bytes) {
+      std::free(buffer);
+      return;
+    }
+
+    free_buffer* node = reinterpret_cast<free_buffer*>(buffer);
+    node->next_ = lists.heads_[index];
+    lists.heads_[index] = node;
+    ++lists.counts_[index];
+    lists.cached_bytes_ += size;
+  }
+
+}
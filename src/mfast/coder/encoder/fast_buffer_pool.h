@@ -0,0 +1,52 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef FAST_BUFFER_POOL_H_5MV0RH3C
+#define FAST_BUFFER_POOL_H_5MV0RH3C
+
+#include <cstddef>
+#include "mfast/coder/mfast_coder_export.h"
+
+namespace mfast {
+
+  /// A pool of uninitialized byte buffers for encoding.
+  ///
+  /// Buffer sizes are rounded up to a power of 2 and every size class keeps a per thread
+  /// free list, so acquiring a buffer which has been released on the same thread is just
+  /// a few pointer operations. Buffers larger than max_pooled_size are not cached, and each
+  /// thread keeps at most max_cached_bytes in its free lists; any other buffer is freed.
+  class MFAST_CODER_EXPORT fast_buffer_pool
+  {
+  public:
+    static const std::size_t min_pooled_size = 256;
+    static const std::size_t max_pooled_size = 16*1024*1024;
+    static const std::size_t max_cached_bytes = 32*1024*1024;
+
+    /// Obtain a buffer of at least @a size bytes.
+    ///
+    /// @param[in,out] size The requested size; set to the actual capacity of the returned buffer.
+    static char* acquire(std::size_t& size);
+
+    /// Give back a buffer obtained from acquire() with the capacity reported there.
+    static void release(char* buffer, std::size_t size);
+  };
+
+}
+
+#endif /* end of include guard: FAST_BUFFER_POOL_H_5MV0RH3C */
@@ -29,6 +29,7 @@
 #include "encoder_field_operator.h"
 #include "fast_ostream.h"
 #include "resizable_fast_ostreambuf.h"
+#include "pooled_fast_ostreambuf.h"
 
 namespace mfast
 {
@@ -136,9 +137,7 @@ namespace mfast
   {
     strm_.encode(static_cast<uint32_t>(cref.size()), !cref.present(), cref.optional());
     if (cref.present()) {
-      for (std::size_t i = 0; i < cref.size(); ++i) {
-        strm_.encode(cref[i], false, false);
-      }
+      strm_.encode_integers(cref.data(), cref.size());
     }
   }
 
@@ -296,6 +295,15 @@ namespace mfast
     buffer.resize(sb.length());
   }
 
+  void
+  fast_encoder::encode(const message_cref&     message,
+                       pooled_fast_ostreambuf& buffer,
+                       bool                    force_reset)
+  {
+    impl_->strm_.rdbuf(&buffer);
+    impl_->encode_segment(message, force_reset);
+  }
+
   const template_instruction*
   fast_encoder::template_with_id(uint32_t id)
   {
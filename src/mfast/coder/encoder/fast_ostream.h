@@ -22,7 +22,9 @@
 
 #include "mfast/field_instructions.h"
 #include "../common/codec_helper.h"
+#include "../common/stop_bit_codec.h"
 #include "fast_ostreambuf.h"
+#include <algorithm>
 
 namespace mfast {
 
@@ -39,6 +41,10 @@ namespace mfast {
     template <typename IntType, typename Nullable>
     void encode(IntType t, bool is_null, Nullable nullable);
 
+    // Encodes n non-nullable integers, such as the elements of an int vector.
+    template <typename IntType>
+    void encode_integers(const IntType* elements, std::size_t n);
+
     template <typename Nullable>
     void encode(const char* ascii,
                 uint32_t len,
@@ -190,10 +196,12 @@ namespace mfast {
     char buffer[max_encoded_length]= {'\0'};
     int i = max_encoded_length-1;
 
-    for (; i >= 0 && value != no_significant_bits; --i) {
+    // at least one group is written, -1 has no significant bits but still takes a byte
+    do {
       buffer[i] = value & static_cast<IntType>(0x7F);
       value = (value >> 7) | padding_mask;
-    }
+      --i;
+    } while (i >= 0 && value != no_significant_bits);
 
     ++i;
 
@@ -215,6 +223,23 @@ namespace mfast {
     rdbuf()->sputn(buffer+i, max_encoded_length-i);
   }
 
+  template <typename IntType>
+  void fast_ostream::encode_integers(const IntType* elements, std::size_t n)
+  {
+    // the encodings are gathered in batches; insert_stop_bit_integer() may write
+    // 8 bytes past the end of an encoding
+    const std::size_t batch_size = 16;
+    char buffer[batch_size*10+8];
+
+    for (std::size_t i = 0; i < n; ) {
+      const std::size_t batch_end = (std::min)(n, i+batch_size);
+      char* p = buffer;
+      for (; i < batch_end; ++i)
+        p = detail::insert_stop_bit_integer(p, elements[i]);
+      rdbuf()->sputn(buffer, p-buffer);
+    }
+  }
+
   template <typename Nullable>
   inline void
   fast_ostream::encode(const char* ascii,
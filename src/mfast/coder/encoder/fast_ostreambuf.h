@@ -93,7 +93,7 @@ namespace mfast
   inline void
   fast_ostreambuf::sputn(const char* data, std::size_t n)
   {
-    while (pptr_+n >= epptr_)
+    while (pptr_+n > epptr_)
       overflow(n);
 
     std::copy(data, data+n, pptr_);
@@ -103,7 +103,7 @@ namespace mfast
   inline void
   fast_ostreambuf::skip(std::size_t n)
   {
-    while (pptr_+n >= epptr_)
+    while (pptr_+n > epptr_)
       overflow(n);
     pptr_ += n;
   }
@@ -0,0 +1,96 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef POOLED_FAST_OSTREAMBUF_H_8JX2NQ4L
+#define POOLED_FAST_OSTREAMBUF_H_8JX2NQ4L
+
+#include "fast_ostreambuf.h"
+#include "fast_buffer_pool.h"
+#include <cstring>
+
+namespace mfast {
+
+  /// A growable stream buffer whose storage is drawn from fast_buffer_pool.
+  ///
+  /// Unlike resizable_fast_ostreambuf, growing never zero-fills memory and the storage
+  /// goes back to the pool when the object is destroyed or release() is called.
+  class pooled_fast_ostreambuf
+    : public fast_ostreambuf
+  {
+  public:
+    explicit pooled_fast_ostreambuf(std::size_t initial_capacity = 1024)
+      : fast_ostreambuf(0, 0)
+      , capacity_(initial_capacity)
+    {
+      char* addr = fast_buffer_pool::acquire(capacity_);
+      setp(addr, addr, addr+capacity_);
+    }
+
+    ~pooled_fast_ostreambuf()
+    {
+      fast_buffer_pool::release(pbase_, capacity_);
+    }
+
+    const char* data() const
+    {
+      return pbase_;
+    }
+
+    std::size_t capacity() const
+    {
+      return capacity_;
+    }
+
+    /// Discard the written content but keep the storage.
+    void clear()
+    {
+      pptr_ = pbase_;
+    }
+
+    /// Discard the written content and give the storage back to the pool.
+    void release()
+    {
+      fast_buffer_pool::release(pbase_, capacity_);
+      capacity_ = 0;
+      setp(0, 0, 0);
+    }
+
+  protected:
+    virtual void overflow(std::size_t n)
+    {
+      std::size_t len = length();
+      std::size_t new_capacity = 2*(len + n);
+      char* addr = fast_buffer_pool::acquire(new_capacity);
+      if (len)
+        std::memcpy(addr, pbase_, len);
+      fast_buffer_pool::release(pbase_, capacity_);
+      capacity_ = new_capacity;
+      setp(addr, addr+len, addr+capacity_);
+    }
+
+  private:
+    pooled_fast_ostreambuf(const pooled_fast_ostreambuf&);
+    pooled_fast_ostreambuf& operator = (const pooled_fast_ostreambuf&);
+
+    std::size_t capacity_;
+  };
+
+}
+
+#endif /* end of include guard: POOLED_FAST_OSTREAMBUF_H_8JX2NQ4L */
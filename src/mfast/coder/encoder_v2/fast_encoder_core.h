@@ -10,6 +10,8 @@
 #include "../common/exceptions.h"
 #include "../encoder/fast_ostream.h"
 #include "../encoder/resizable_fast_ostreambuf.h"
+#include "../encoder/counting_fast_ostreambuf.h"
+#include "../encoder/pooled_fast_ostreambuf.h"
 #include "../encoder/encoder_presence_map.h"
 #include "mfast/ext_ref.h"
 #include "fast_ostream_inserter.h"
@@ -39,7 +41,7 @@ inline bool equivalent (const decimal_cref& v, const value_storage& prev)
 template <typename T>
 inline bool equivalent (const vector_cref<T>& v, const value_storage& prev)
 {
-  return v.size() == prev.of_array.len_-1 && memcmp(v.data(),prev.of_array.content_, v.size()*sizeof(T)) == 0;
+  return v.size() == prev.of_array.len_-1 && memcmp(v.data(),prev.array_content(), v.size()*sizeof(T)) == 0;
 }
 
 struct fast_encoder_core;
@@ -79,12 +81,25 @@ struct MFAST_CODER_EXPORT fast_encoder_core
            std::vector<char>&  buffer,
            bool                force_reset);
 
+  void
+  encode_i(const message_cref&     message,
+           pooled_fast_ostreambuf& buffer,
+           bool                    force_reset);
+
+  std::size_t
+  encoded_size_i(const message_cref& message,
+                 bool                force_reset,
+                 std::size_t*        buffer_size = 0);
+
 
   /// vistation functions for mFAST data structures
   template <typename T>
   void visit(const T& ext_ref);
   void visit(const nested_message_cref& cref);
 
+  template <typename T>
+  void update_previous_value(const T& cref);
+
 
   /// FAST encoding rules
   template <typename T, typename TypeCategory>
@@ -102,6 +117,12 @@ struct MFAST_CODER_EXPORT fast_encoder_core
   template <typename T>
   void encode_field(const T &ext_ref, sequence_type_tag);
 
+  template <typename T, typename PmapSegmentSize>
+  void encode_sequence_elements(const T& ext_ref, std::size_t length, PmapSegmentSize);
+
+  template <typename T>
+  void encode_sequence_elements(const T& ext_ref, std::size_t length, pmap_segment_size_zero);
+
 
   template <typename T, typename TypeCategory>
   void encode_field (const T &ext_ref,
@@ -176,6 +197,7 @@ struct MFAST_CODER_EXPORT fast_encoder_core
   fast_ostream strm_;
   info_entry* active_message_info_;
   encoder_presence_map* current_;
+  std::vector<char> scratch_buffer_;
 };
 
 template <typename T>
@@ -216,6 +238,28 @@ public:
 
 };
 
+// Makes a presence map the current one for the lifetime of the object, without
+// initializing or committing it.
+class encoder_pmap_scope
+{
+  encoder_presence_map* prev_pmap_;
+  fast_encoder_core* core_;
+
+public:
+  encoder_pmap_scope(fast_encoder_core* core, encoder_presence_map* pmap)
+    : prev_pmap_(core->current_)
+    , core_(core)
+  {
+    core_->current_ = pmap;
+  }
+
+  ~encoder_pmap_scope()
+  {
+    core_->current_ = this->prev_pmap_;
+  }
+
+};
+
 
 inline
 fast_encoder_core::fast_encoder_core(allocator* alloc)
@@ -266,12 +310,59 @@ fast_encoder_core::encode_i(const message_cref& message,
   buffer.resize(sb.length());
 }
 
+inline void
+fast_encoder_core::encode_i(const message_cref&     message,
+                            pooled_fast_ostreambuf& buffer,
+                            bool                    force_reset)
+{
+  this->strm_.rdbuf(&buffer);
+  this->encode_segment(message, force_reset);
+}
+
+inline std::size_t
+fast_encoder_core::encoded_size_i(const message_cref& message,
+                                  bool                force_reset,
+                                  std::size_t*        buffer_size)
+{
+  counting_fast_ostreambuf sb(scratch_buffer_);
+  this->strm_.rdbuf(&sb);
+
+  // Run the regular encoding rules and then roll back the dictionary entries
+  // they have changed, so that the next encode() produces the same stream.
+  info_entry* saved_message_info = active_message_info_;
+  repo_.start_undo_log();
+  try {
+    this->encode_segment(message, force_reset);
+  }
+  catch (...) {
+    repo_.rollback_dictionary();
+    active_message_info_ = saved_message_info;
+    throw;
+  }
+  repo_.rollback_dictionary();
+  active_message_info_ = saved_message_info;
+  if (buffer_size)
+    *buffer_size = sb.peak_length();
+  return sb.length();
+}
+
 inline void
 fast_encoder_core::allow_overlong_pmap_i(bool v)
 {
   this->strm_.allow_overlong_pmap(v);
 }
 
+template <typename T>
+inline void
+fast_encoder_core::update_previous_value(const T& cref)
+{
+  // only encoded_size() keeps an undo log
+  if (repo_.undo_log_active())
+    repo_.log_entry(previous_value_of(cref),
+                    std::is_same<typename T::type_category, string_type_tag>::value);
+  strm_.save_previous_value(cref);
+}
+
 template <typename T>
 inline void
 fast_encoder_core::visit(const T& ext_ref)
@@ -320,9 +411,7 @@ inline void fast_encoder_core::encode_field(const T& ext_ref, int_vector_type_ta
 
   this->strm_.encode(static_cast<uint32_t>(cref.size()), !cref.present(), cref.optional());
   if (cref.present()) {
-    for (std::size_t i = 0; i < cref.size(); ++i) {
-      this->strm_.encode(cref[i], false, false_type());
-    }
+    this->strm_.encode_integers(cref.data(), cref.size());
   }
 }
 
@@ -353,9 +442,39 @@ fast_encoder_core::encode_field(const T& ext_ref, sequence_type_tag)
   typename T::length_type length = ext_ref.get_length(storage);
   this->visit(length);
   std::size_t sz = length.get().value();
-  for (std::size_t i = 0; i < sz; ++i)
+
+  typedef typename T::element_type element_type;
+  this->encode_sequence_elements(ext_ref, sz, typename element_type::pmap_segment_size_type());
+}
+
+// All elements of a sequence share the same instruction and thus the same presence map
+// size; the presence map is set up once for the whole sequence instead of once per element.
+template <typename T, typename PmapSegmentSize>
+inline void
+fast_encoder_core::encode_sequence_elements(const T&        ext_ref,
+                                            std::size_t     length,
+                                            PmapSegmentSize)
+{
+  encoder_presence_map pmap;
+  encoder_pmap_scope scope(this, &pmap);
+
+  for (std::size_t i = 0; i < length; ++i)
+  {
+    pmap.init(&this->strm_, PmapSegmentSize::value);
+    ext_ref[i].get().accept(*this);
+    pmap.commit();
+  }
+}
+
+template <typename T>
+inline void
+fast_encoder_core::encode_sequence_elements(const T&    ext_ref,
+                                            std::size_t length,
+                                            pmap_segment_size_zero)
+{
+  for (std::size_t i = 0; i < length; ++i)
   {
-    this->visit(ext_ref[i]);
+    ext_ref[i].get().accept(*this);
   }
 }
 
@@ -376,7 +495,7 @@ fast_encoder_core::encode_field (const T& ext_ref,
   // nullable representation and the NULL is used to represent absence of a
   // value. It will not occupy any bits in the presence map.
   if (ext_ref.previous_value_shared())
-    strm_.save_previous_value(ext_ref.get());
+    this->update_previous_value(ext_ref.get());
 }
 
 template <typename T, typename TypeCategory>
@@ -396,7 +515,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   }
 
   if (ext_ref.previous_value_shared())
-    strm_.save_previous_value(cref);
+    this->update_previous_value(cref);
 }
 
 template <typename T, typename TypeCategory>
@@ -409,7 +528,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   typename T::cref_type cref = ext_ref.get();
 
   value_storage previous = previous_value_of(cref);
-  strm_.save_previous_value(cref);
+  this->update_previous_value(cref);
 
   if (!previous.is_defined())
   {
@@ -458,7 +577,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   typename T::cref_type cref = ext_ref.get();
 
   value_storage previous = previous_value_of(cref);
-  strm_.save_previous_value(cref);
+  this->update_previous_value(cref);
 
   if (!previous.is_defined())
   {
@@ -519,7 +638,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   if (cref.is_initial_value()) {
     pmap.set_next_bit(false);
     if (ext_ref.previous_value_shared())
-      strm_.save_previous_value(cref);
+      this->update_previous_value(cref);
     return;
   }
 
@@ -531,7 +650,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   else {
     strm_ << ext_ref;
     if (ext_ref.previous_value_shared())
-      strm_.save_previous_value(cref);
+      this->update_previous_value(cref);
   }
 }
 
@@ -554,7 +673,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
     int64_t delta = static_cast<int64_t>(cref.value() - base.value());
 
     strm_.encode(delta, false, ext_ref.nullable());
-    strm_.save_previous_value(cref);
+    this->update_previous_value(cref);
   }
 
 }
@@ -579,11 +698,15 @@ fast_encoder_core::encode_field(const T& ext_ref,
   typedef typename T::cref_type::const_reverse_iterator const_reverse_iterator;
   typedef typename std::iterator_traits<const_iterator>::difference_type difference_type;
 
+  // Never compare past the end of the shorter value; the previous value buffer
+  // may hold stale bytes beyond its current length.
+  difference_type common_len = static_cast<difference_type>((std::min)(cref.size(), prev_cref.size()));
+
   std::pair<const_iterator, const_iterator> common_prefix_positions
-    = std::mismatch(cref.begin(), cref.end(), prev_cref.begin());
+    = std::mismatch(cref.begin(), cref.begin() + common_len, prev_cref.begin());
 
   std::pair<const_reverse_iterator, const_reverse_iterator> common_suffix_positions
-    = std::mismatch(cref.rbegin(), cref.rend(), prev_cref.rbegin());
+    = std::mismatch(cref.rbegin(), cref.rbegin() + common_len, prev_cref.rbegin());
 
   int32_t substraction_len;
   const_iterator delta_iterator;
@@ -610,7 +733,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
   strm_.encode(substraction_len, false, ext_ref.nullable());
   strm_.encode(delta_iterator, delta_len, cref.instruction(), false_type());
 
-  strm_.save_previous_value(cref);
+  this->update_previous_value(cref);
 }
 
 template <typename T>
@@ -632,7 +755,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
     decimal_cref delta(&delta_storage, cref.instruction());
     strm_ << T(delta);
 
-    strm_.save_previous_value(cref);
+    this->update_previous_value(cref);
   }
   else {
     strm_.encode_null();
@@ -691,7 +814,7 @@ fast_encoder_core::encode_field(const T& ext_ref,
                  cref.instruction(),
                  ext_ref.nullable());
   }
-  strm_.save_previous_value(cref);
+  this->update_previous_value(cref);
 
 }
 
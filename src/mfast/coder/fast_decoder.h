@@ -21,6 +21,9 @@
 #include "mfast_coder_export.h"
 #include "mfast/message_ref.h"
 #include "mfast/malloc_allocator.h"
+#include "mfast/arena_allocator.h"
+#include "common/sequence_length_stats.h"
+#include <vector>
 
 
 namespace mfast
@@ -66,6 +69,39 @@ class MFAST_CODER_EXPORT fast_decoder
     ///            after.
     message_cref decode(const char*& first, const char* last, bool force_reset = false);
 
+    /// Build every decoded message in one of two alternating arenas.
+    ///
+    /// At the beginning of each decode() call, the arena holding the message before the
+    /// previous one is reset and the new message is built in it. Thus, the memory of the
+    /// messages is reclaimed in constant time without any per field deallocation, and the
+    /// memory usage is bounded by the size of the two largest messages. A message returned
+    /// by decode() remains valid until decode() is invoked twice more.
+    ///
+    /// @param enabled Whether to decode into the arenas; otherwise, the messages are
+    ///        built with the allocator passed to the constructor and reused for the same
+    ///        template.
+    /// @param policy Specifies how the arenas obtain memory from the system.
+    void auto_reset_arenas(bool                                  enabled,
+                           const arena_allocator::chunk_policy& policy = arena_allocator::chunk_policy());
+
+    /// Reserve the elements of a sequence according to its decoding history.
+    ///
+    /// When enabled, the decoder tracks the decoded lengths of each sequence. Whenever a
+    /// decoded length exceeds the capacity of the sequence, the capacity is raised to 1.25
+    /// times the largest length observed so far rather than to the decoded length. This
+    /// avoids reallocating and moving the elements each time the length grows a little.
+    void sequence_length_hints(bool enabled);
+
+    /// Returns the length statistics of every sequence decoded while hints were enabled.
+    std::vector<sequence_length_stats> sequence_statistics() const;
+
+    /// Enables or disables checking that the unicode string fields of the decoded messages
+    /// are valid UTF-8.
+    ///
+    /// When enabled, decode() throws a fast_reportable_error with error code R2 for a unicode
+    /// value which is not.
+    void validate_utf8(bool enabled);
+
     void debug_log(std::ostream* os);
     void warning_log(std::ostream* os);
 
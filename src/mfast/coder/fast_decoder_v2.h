@@ -66,6 +66,14 @@ public:
     return this->decode_stream(token, first, last, force_reset);
   }
 
+  // changed field reporting, UTF-8 validation and sequence length hints, see coder::fast_decoder_base
+  using coder::fast_decoder_core<NumTokens>::report_changed_fields;
+  using coder::fast_decoder_core<NumTokens>::field_changed;
+  using coder::fast_decoder_core<NumTokens>::changed_fields;
+  using coder::fast_decoder_core<NumTokens>::validate_utf8;
+  using coder::fast_decoder_core<NumTokens>::sequence_length_hints;
+  using coder::fast_decoder_core<NumTokens>::sequence_statistics;
+
 };
 
 template <>
@@ -104,6 +112,14 @@ public:
     return this->decode_stream(0, first, last, force_reset);
   }
 
+  // changed field reporting, UTF-8 validation and sequence length hints, see coder::fast_decoder_base
+  using coder::fast_decoder_core<0>::report_changed_fields;
+  using coder::fast_decoder_core<0>::field_changed;
+  using coder::fast_decoder_core<0>::changed_fields;
+  using coder::fast_decoder_core<0>::validate_utf8;
+  using coder::fast_decoder_core<0>::sequence_length_hints;
+  using coder::fast_decoder_core<0>::sequence_statistics;
+
 };
 
 
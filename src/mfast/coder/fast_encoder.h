@@ -29,6 +29,7 @@
 namespace mfast
 {
 struct fast_encoder_impl;
+class pooled_fast_ostreambuf;
 
 ///
 class MFAST_CODER_EXPORT fast_encoder
@@ -83,6 +84,18 @@ class MFAST_CODER_EXPORT fast_encoder
                 std::vector<char>&  buffer,
                 bool                force_reset = false);
 
+    /// Encode a  message into FAST byte stream and append the encoded stream to \a buffer.
+    ///
+    /// The storage of \a buffer comes from fast_buffer_pool; once the buffer is reused with
+    /// clear(), encoding does not allocate memory anymore.
+    ///
+    /// @param[in] message The message to be encoded.
+    /// @param[in] buffer The buffer for the encoded FAST stream to be appended to.
+    /// @param[in] force_reset Force the encoder to reset and discard all exisiting history values.
+    void encode(const message_cref&     message,
+                pooled_fast_ostreambuf& buffer,
+                bool                    force_reset = false);
+
     /// Instruct the encoder whether the overlong presence map is allowed.
     ///
     /// Overlong presence map is allowed by default for better performance.
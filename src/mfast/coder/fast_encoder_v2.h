@@ -76,6 +76,54 @@ public:
     this->encode_i(message, buffer, force_reset);
   }
 
+  /// Encode a  message into FAST byte stream and append the encoded stream to \a buffer.
+  ///
+  /// The storage of \a buffer comes from fast_buffer_pool; once the buffer is reused with
+  /// clear(), encoding does not allocate memory anymore.
+  ///
+  /// @param[in] message The message to be encoded.
+  /// @param[in] buffer The buffer for the encoded FAST stream to be appended to.
+  /// @param[in] force_reset Force the encoder to reset and discard all exisiting history values.
+  void encode(const message_cref&     message,
+              pooled_fast_ostreambuf& buffer,
+              bool                    force_reset = false)
+  {
+    this->encode_i(message, buffer, force_reset);
+  }
+
+  /// Compute the size of the FAST byte stream that encode() would produce for \a message.
+  ///
+  /// Nothing is written and the encoder dictionary is left untouched; therefore, the
+  /// following encode() call with the same arguments yields exactly that many bytes.
+  ///
+  /// @param[in] message The message to be encoded.
+  /// @param[in] force_reset Compute the size as if the encoder is reset before encoding.
+  ///
+  /// @returns The size of the encoded byte stream.
+  std::size_t encoded_size(const message_cref& message,
+                           bool                force_reset = false)
+  {
+    return this->encoded_size_i(message, force_reset);
+  }
+
+  /// Compute the size of the buffer that encode() needs for \a message.
+  ///
+  /// It equals encoded_size() unless the overlong presence map is disallowed, in which
+  /// case the encoder temporarily occupies the maximum size of each presence map before
+  /// shrinking it. Like encoded_size(), the encoder dictionary is left untouched.
+  ///
+  /// @param[in] message The message to be encoded.
+  /// @param[in] force_reset Compute the size as if the encoder is reset before encoding.
+  ///
+  /// @returns The smallest buffer size encode() succeeds with.
+  std::size_t required_buffer_size(const message_cref& message,
+                                   bool                force_reset = false)
+  {
+    std::size_t buffer_size;
+    this->encoded_size_i(message, force_reset, &buffer_size);
+    return buffer_size;
+  }
+
   /// Instruct the encoder whether the overlong presence map is allowed.
   ///
   /// Overlong presence map is allowed by default for better performance.
@@ -0,0 +1,630 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef FAST_POD_DECODER_H_K2N7QX4E
+#define FAST_POD_DECODER_H_K2N7QX4E
+
+#include "common/pod_coder_base.h"
+#include "decoder/fast_istream.h"
+#include "decoder/decoder_presence_map.h"
+#include <type_traits>
+#include <stdexcept>
+
+namespace mfast
+{
+
+///
+/// FAST decoder which decodes straight into the plain structs fast_type_gen emits for the
+/// templates with bounded fields, see mfast/pod_types.h.
+///
+/// Each field is decoded from the byte stream into its struct member, and the dictionary
+/// is updated along the way; no message object is involved. The structs pass their members
+/// to the decoder in template order with their static code() member.
+///
+/// A stream interleaving several templates must be decoded with the same decoder, since
+/// the templates may share dictionary entries; decode() rejects a message whose template is
+/// not the one of the struct, so such a stream is better decoded with fast_decoder_v2.
+class fast_pod_decoder
+  : coder::pod_coder_base
+{
+public:
+
+  template <typename DescriptionsTuple>
+  fast_pod_decoder(const DescriptionsTuple& tp,
+                   typename std::enable_if< !std::is_base_of< mfast::templates_description, DescriptionsTuple>::value, allocator*>::type alloc = malloc_allocator::instance())
+    : coder::pod_coder_base(alloc)
+    , strm_(0)
+    , current_(0)
+  {
+    this->init(tp);
+  }
+
+  template <typename T>
+  fast_pod_decoder(const T* desc,
+                   typename std::enable_if< std::is_base_of< mfast::templates_description, T>::value, allocator*>::type alloc = malloc_allocator::instance())
+    : coder::pod_coder_base(alloc)
+    , strm_(0)
+    , current_(0)
+  {
+    this->init(std::make_tuple(desc));
+  }
+
+  /// Decode a message into @a pod.
+  ///
+  /// @param[in,out] first The initial position of the buffer to be decoded. After decoding
+  ///                the parameter is set to position of the first unconsumed data byte.
+  /// @param[in] last The last position of the buffer to be decoded.
+  /// @param[out] pod The struct to hold the decoded message. The members of absent optional
+  ///                 fields are left untouched.
+  /// @param[in] force_reset Force the decoder to reset and discard all exisiting history values.
+  ///            Notice that the reset is done before the decoding of the input buffer rather than
+  ///            after.
+  ///
+  /// @throw std::invalid_argument if the message is not of the template of @a pod; @a first is
+  ///        left unchanged then.
+  /// @throw std::length_error if a string, byte vector or sequence exceeds its capacity in
+  ///        @a pod; as the message is partially decoded, the next message should be decoded
+  ///        with @a force_reset.
+  template <typename Pod>
+  void decode(const char*& first, const char* last, Pod& pod, bool force_reset = false);
+
+  // The members of the structs are decoded by the following functions, @a index being the
+  // index of the field in the enclosing template, group or sequence.
+
+  template <typename T>
+  typename std::enable_if< std::is_integral<T>::value>::type
+  code_field(T& value, bool& present, std::size_t index)
+  {
+    const integer_field_instruction_base* inst = static_cast<const integer_field_instruction_base*>(group_->subinstruction(index));
+    present = decode_integer(inst, inst->initial_or_default_value(), value, coder::integer_slot());
+  }
+
+  void code_field(pod_decimal& value, bool& present, std::size_t index)
+  {
+    const decimal_field_instruction* inst = static_cast<const decimal_field_instruction*>(group_->subinstruction(index));
+    if (inst->field_type() == field_type_decimal)
+      present = decode_decimal(inst, value);
+    else
+      present = decode_split_decimal(inst, value);
+  }
+
+  template <std::size_t N>
+  void code_field(pod_string<N>& value, bool& present, std::size_t index)
+  {
+    present = decode_string(group_->subinstruction(index), value.data, value.length, N);
+  }
+
+  template <std::size_t N>
+  void code_field(pod_array<unsigned char, N>& value, bool& present, std::size_t index)
+  {
+    present = decode_string(group_->subinstruction(index), reinterpret_cast<char*>(value.elements), value.size, N);
+  }
+
+  template <typename T>
+  void code_field(T& value, std::size_t index)
+  {
+    bool present;
+    code_field(value, present, index);
+  }
+
+  template <typename Group>
+  void code_group(Group& group, bool& present, std::size_t index);
+
+  template <typename Group>
+  void code_group(Group& group, std::size_t index)
+  {
+    bool present;
+    code_group(group, present, index);
+  }
+
+  template <typename Element, std::size_t N>
+  void code_sequence(pod_array<Element, N>& sequence, bool& present, std::size_t index);
+
+  template <typename Element, std::size_t N>
+  void code_sequence(pod_array<Element, N>& sequence, std::size_t index)
+  {
+    bool present;
+    code_sequence(sequence, present, index);
+  }
+
+private:
+  template <typename T, typename Slot>
+  bool decode_integer(const integer_field_instruction_base* inst,
+                      const value_storage&                  initial_or_default,
+                      T&                                    value,
+                      Slot);
+
+  bool decode_decimal(const decimal_field_instruction* inst, pod_decimal& value);
+  bool decode_decimal_value(pod_decimal& value, bool nullable);
+  bool decode_split_decimal(const decimal_field_instruction* inst, pod_decimal& value);
+
+  bool decode_string(const field_instruction* inst, char* data, uint32_t& length, std::size_t capacity);
+  bool read_string(const ascii_field_instruction* inst, bool nullable, const char*& str, uint32_t& len);
+  void assign_string(const ascii_field_instruction* inst,
+                     const char*                    str,
+                     uint32_t                       len,
+                     bool                           from_stream,
+                     char*                          data,
+                     uint32_t&                      length,
+                     std::size_t                    capacity);
+  void apply_string_delta(const ascii_field_instruction* inst,
+                          const value_storage&           base,
+                          int32_t                        substraction_length,
+                          const char*                    delta_str,
+                          uint32_t                       delta_len,
+                          char*                          data,
+                          uint32_t&                      length,
+                          std::size_t                    capacity);
+
+  fast_istream strm_;
+  decoder_presence_map* current_;
+};
+
+template <typename Pod>
+inline void
+fast_pod_decoder::decode(const char*& first, const char* last, Pod& pod, bool force_reset)
+{
+  assert(first < last);
+  fast_istreambuf sb(first, last-first);
+  strm_.reset(&sb);
+
+  decoder_presence_map pmap;
+  current_ = &pmap;
+  strm_.decode(pmap);
+
+  const template_instruction* inst = active_;
+  if (pmap.is_next_bit_set()) {
+    uint32_t template_id;
+    strm_.decode(template_id, false_type());
+
+    inst = repo_.get_template(template_id);
+    if (inst == 0)
+      BOOST_THROW_EXCEPTION(fast_dynamic_error("D9") << coder::template_id_info(template_id));
+  }
+
+  if (inst == 0 || inst->id() != Pod::message_type::the_id)
+    BOOST_THROW_EXCEPTION(std::invalid_argument("the message is not of the template of the struct"));
+  active_ = inst;
+
+  if (force_reset || inst->has_reset_attribute())
+    repo_.reset_dictionary();
+
+  group_ = inst;
+  Pod::code(*this, pod);
+  first = sb.gptr();
+}
+
+template <typename Group>
+inline void
+fast_pod_decoder::code_group(Group& group, bool& present, std::size_t index)
+{
+  const group_field_instruction* inst = static_cast<const group_field_instruction*>(group_->subinstruction(index));
+
+  // An optional group occupies a single bit in the presence map.
+  present = !inst->optional() || current_->is_next_bit_set();
+  if (!present)
+    return;
+
+  decoder_presence_map pmap;
+  decoder_presence_map* saved_pmap = current_;
+  if (inst->segment_pmap_size() > 0) {
+    strm_.decode(pmap);
+    current_ = &pmap;
+  }
+
+  const group_field_instruction* saved_group = group_;
+  group_ = inst;
+  Group::code(*this, group);
+  group_ = saved_group;
+  current_ = saved_pmap;
+}
+
+template <typename Element, std::size_t N>
+inline void
+fast_pod_decoder::code_sequence(pod_array<Element, N>& sequence, bool& present, std::size_t index)
+{
+  const sequence_field_instruction* inst = static_cast<const sequence_field_instruction*>(group_->subinstruction(index));
+  const uint32_field_instruction* length_inst = inst->length_instruction();
+
+  uint32_t length;
+  present = decode_integer(length_inst, length_inst->initial_or_default_value(), length, coder::integer_slot());
+  if (!present)
+    return;
+
+  detail::check_pod_capacity(length, N, inst->name());
+  sequence.size = length;
+
+  decoder_presence_map pmap;
+  decoder_presence_map* saved_pmap = current_;
+  const group_field_instruction* saved_group = group_;
+  group_ = inst;
+
+  for (uint32_t i = 0; i < length; ++i) {
+    if (inst->segment_pmap_size() > 0) {
+      strm_.decode(pmap);
+      current_ = &pmap;
+    }
+    Element::code(*this, sequence.elements[i]);
+  }
+
+  group_ = saved_group;
+  current_ = saved_pmap;
+}
+
+template <typename T, typename Slot>
+bool
+fast_pod_decoder::decode_integer(const integer_field_instruction_base* inst,
+                                 const value_storage&                  initial_or_default,
+                                 T&                                    value,
+                                 Slot)
+{
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool optional = inst->optional();
+  const bool nullable = inst->is_nullable();
+  bool present = true;
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    present = strm_.decode(value, nullable);
+    break;
+
+  case operator_constant:
+    // An optional field with the constant operator occupies a single bit; a mandatory one, none.
+    if (optional)
+      present = current_->is_next_bit_set();
+    value = Slot::template get<T>(initial);
+    break;
+
+  case operator_default:
+    if (current_->is_next_bit_set()) {
+      // A NULL indicates that the value is absent and the state of the previous value is left unchanged.
+      if (!strm_.decode(value, nullable))
+        return false;
+    }
+    else {
+      present = !initial.is_empty();
+      value = Slot::template get<T>(initial_or_default);
+    }
+    break;
+
+  case operator_copy:
+  case operator_increment:
+    if (current_->is_next_bit_set()) {
+      // A NULL indicates that the value is absent and the state of the previous value is set to empty
+      present = strm_.decode(value, nullable);
+    }
+    else if (!previous.is_defined()) {
+      // the initial value becomes the new previous value; it is a dynamic error [ERR D5]
+      // if a mandatory field has no initial value.
+      if (initial.is_empty() && !optional)
+        BOOST_THROW_EXCEPTION(fast_dynamic_error("D5"));
+      present = !initial.is_empty();
+      value = Slot::template get<T>(initial_or_default);
+    }
+    else if (previous.is_empty()) {
+      // It is a dynamic error [ERR D6] if the field is mandatory.
+      if (!optional)
+        BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+      return false;
+    }
+    else {
+      value = Slot::template get<T>(previous);
+      if (inst->field_operator() == operator_increment)
+        value = static_cast<T>(value + 1);
+    }
+    save_integer(previous, value, present, Slot());
+    return present;
+
+  case operator_delta:
+    {
+      int64_t delta;
+      // If the field has optional presence, the delta value can be NULL.
+      if (!strm_.decode(delta, nullable))
+        return false;
+      const value_storage& base = delta_base_value_of(previous, initial_or_default);
+      value = add_delta(Slot::template get<T>(base), delta);
+      save_integer(previous, value, true, Slot());
+      return true;
+    }
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (inst->previous_value_shared())
+    save_integer(previous, value, present, Slot());
+  return present;
+}
+
+inline bool
+fast_pod_decoder::decode_decimal_value(pod_decimal& value, bool nullable)
+{
+  int16_t exponent;
+  if (!strm_.decode(exponent, nullable))
+    return false;
+  check_exponent(exponent);
+  value.exponent = static_cast<int8_t>(exponent);
+  strm_.decode(value.mantissa, false);
+  return true;
+}
+
+inline bool
+fast_pod_decoder::decode_decimal(const decimal_field_instruction* inst, pod_decimal& value)
+{
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool nullable = inst->is_nullable();
+  bool present = true;
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    present = decode_decimal_value(value, nullable);
+    break;
+
+  case operator_constant:
+    if (inst->optional())
+      present = current_->is_next_bit_set();
+    value.mantissa = initial.of_decimal.mantissa_;
+    value.exponent = static_cast<int8_t>(initial.of_decimal.exponent_);
+    break;
+
+  case operator_default:
+    if (current_->is_next_bit_set()) {
+      if (!decode_decimal_value(value, nullable))
+        return false;
+    }
+    else {
+      present = !initial.is_empty();
+      value.mantissa = initial.of_decimal.mantissa_;
+      value.exponent = static_cast<int8_t>(initial.of_decimal.exponent_);
+    }
+    break;
+
+  case operator_copy:
+    if (current_->is_next_bit_set()) {
+      present = decode_decimal_value(value, nullable);
+    }
+    else if (!previous.is_defined()) {
+      if (inst->mandatory_without_initial_value())
+        BOOST_THROW_EXCEPTION(fast_dynamic_error("D5"));
+      present = !initial.is_empty();
+      value.mantissa = initial.of_decimal.mantissa_;
+      value.exponent = static_cast<int8_t>(initial.of_decimal.exponent_);
+    }
+    else if (previous.is_empty()) {
+      if (!inst->optional())
+        BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+      return false;
+    }
+    else {
+      value.mantissa = previous.of_decimal.mantissa_;
+      value.exponent = static_cast<int8_t>(previous.of_decimal.exponent_);
+    }
+    save_decimal(previous, value, present);
+    return present;
+
+  case operator_delta:
+    {
+      int16_t exponent_delta;
+      if (!strm_.decode(exponent_delta, nullable))
+        return false;
+      int64_t mantissa_delta;
+      strm_.decode(mantissa_delta, false);
+
+      const value_storage& base = delta_base_value_of(previous, inst->initial_or_default_value());
+      int exponent = base.of_decimal.exponent_ + exponent_delta;
+      check_exponent(exponent);
+      value.exponent = static_cast<int8_t>(exponent);
+      value.mantissa = add_delta(base.of_decimal.mantissa_, mantissa_delta);
+      save_decimal(previous, value, true);
+      return true;
+    }
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (inst->previous_value_shared())
+    save_decimal(previous, value, present);
+  return present;
+}
+
+inline bool
+fast_pod_decoder::decode_split_decimal(const decimal_field_instruction* inst, pod_decimal& value)
+{
+  int16_t exponent;
+  if (!decode_integer(inst, inst->initial_or_default_value(), exponent, coder::exponent_slot()))
+    return false;
+  check_exponent(exponent);
+  value.exponent = static_cast<int8_t>(exponent);
+
+  const mantissa_field_instruction* mantissa_inst = inst->mantissa_instruction();
+  decode_integer(mantissa_inst, mantissa_inst->initial_or_default_value(), value.mantissa, coder::integer_slot());
+  return true;
+}
+
+inline bool
+fast_pod_decoder::read_string(const ascii_field_instruction* inst, bool nullable, const char*& str, uint32_t& len)
+{
+  if (inst->field_type() == field_type_ascii_string)
+    return strm_.decode(str, len, static_cast<const ascii_field_instruction*>(0), nullable);
+
+  // unicode strings and byte vectors are both length preceded
+  const unsigned char* bytes = 0;
+  bool present = strm_.decode(bytes, len, static_cast<const byte_vector_field_instruction*>(0), nullable);
+  str = reinterpret_cast<const char*>(bytes);
+  return present;
+}
+
+inline void
+fast_pod_decoder::assign_string(const ascii_field_instruction* inst,
+                                const char*                    str,
+                                uint32_t                       len,
+                                bool                           from_stream,
+                                char*                          data,
+                                uint32_t&                      length,
+                                std::size_t                    capacity)
+{
+  detail::check_pod_capacity(len, capacity, inst->name());
+  if (len)
+    std::memcpy(data, str, len);
+  // the last character of an ascii string in the stream carries the stop bit
+  if (from_stream && len && inst->field_type() == field_type_ascii_string)
+    data[len-1] &= 0x7F;
+  length = len;
+}
+
+inline void
+fast_pod_decoder::apply_string_delta(const ascii_field_instruction* inst,
+                                     const value_storage&           base,
+                                     int32_t                        substraction_length,
+                                     const char*                    delta_str,
+                                     uint32_t                       delta_len,
+                                     char*                          data,
+                                     uint32_t&                      length,
+                                     std::size_t                    capacity)
+{
+  const uint32_t base_len = base.array_length();
+  const char* base_str = static_cast<const char*>(base.array_content());
+
+  // Characters are removed from the front when the subtraction length is negative; it uses
+  // an excess-1 encoding then. It is a dynamic error [ERR D7] if the subtraction length is
+  // larger than the number of characters in the base value.
+  const bool front = substraction_length < 0;
+  const uint32_t removed = static_cast<uint32_t>(front ? ~substraction_length : substraction_length);
+  if (removed > base_len)
+    BOOST_THROW_EXCEPTION(fast_dynamic_error("D7"));
+
+  const uint32_t kept = base_len - removed;
+  detail::check_pod_capacity(kept + delta_len, capacity, inst->name());
+
+  char* delta_pos = front ? data : data + kept;
+  if (front)
+    std::memmove(data + delta_len, base_str + removed, kept);
+  else
+    std::memmove(data, base_str, kept);
+  if (delta_len) {
+    std::memcpy(delta_pos, delta_str, delta_len);
+    if (inst->field_type() == field_type_ascii_string)
+      delta_pos[delta_len-1] &= 0x7F;
+  }
+  length = kept + delta_len;
+}
+
+inline bool
+fast_pod_decoder::decode_string(const field_instruction* field_inst, char* data, uint32_t& length, std::size_t capacity)
+{
+  const ascii_field_instruction* inst = static_cast<const ascii_field_instruction*>(field_inst);
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool nullable = inst->is_nullable();
+  bool present = true;
+  const char* str;
+  uint32_t len;
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    present = read_string(inst, nullable, str, len);
+    if (present)
+      assign_string(inst, str, len, true, data, length, capacity);
+    break;
+
+  case operator_constant:
+    if (inst->optional())
+      present = current_->is_next_bit_set();
+    assign_string(inst, static_cast<const char*>(initial.array_content()), initial.array_length(), false,
+                  data, length, capacity);
+    break;
+
+  case operator_default:
+    if (current_->is_next_bit_set()) {
+      if (!read_string(inst, nullable, str, len))
+        return false;
+      assign_string(inst, str, len, true, data, length, capacity);
+    }
+    else {
+      present = !initial.is_empty();
+      if (present)
+        assign_string(inst, static_cast<const char*>(initial.array_content()), initial.array_length(), false,
+                      data, length, capacity);
+    }
+    break;
+
+  case operator_copy:
+  case operator_tail:
+    if (current_->is_next_bit_set()) {
+      present = read_string(inst, nullable, str, len);
+      if (!present)
+        ;
+      else if (inst->field_operator() == operator_copy)
+        assign_string(inst, str, len, true, data, length, capacity);
+      else {
+        // the tail replaces as many characters at the end of the base value
+        const value_storage& base = tail_base_value_of(previous, inst->initial_or_default_value());
+        apply_string_delta(inst, base, static_cast<int32_t>((std::min)(len, base.array_length())),
+                           str, len, data, length, capacity);
+      }
+    }
+    else if (!previous.is_defined()) {
+      if (inst->mandatory_without_initial_value())
+        BOOST_THROW_EXCEPTION(fast_dynamic_error(inst->field_operator() == operator_copy ? "D5" : "D6"));
+      present = !initial.is_empty();
+      if (present)
+        assign_string(inst, static_cast<const char*>(initial.array_content()), initial.array_length(), false,
+                      data, length, capacity);
+    }
+    else if (previous.is_empty()) {
+      if (!inst->optional())
+        BOOST_THROW_EXCEPTION(fast_dynamic_error(inst->field_operator() == operator_copy ? "D6" : "D7"));
+      return false;
+    }
+    else {
+      // the value is the previous value, which is kept in the dictionary already
+      assign_string(inst, static_cast<const char*>(previous.array_content()), previous.array_length(), false,
+                    data, length, capacity);
+      return true;
+    }
+    save_array(previous, data, length, present);
+    return present;
+
+  case operator_delta:
+    {
+      int32_t substraction_length;
+      if (!strm_.decode(substraction_length, nullable))
+        return false;
+      read_string(inst, false, str, len);
+
+      const value_storage& base = delta_base_value_of(previous, inst->initial_or_default_value());
+      apply_string_delta(inst, base, substraction_length, str, len, data, length, capacity);
+      save_array(previous, data, length, true);
+      return true;
+    }
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (present && inst->previous_value_shared())
+    save_array(previous, data, length, present);
+  return present;
+}
+
+} /* mfast */
+
+#endif /* end of include guard: FAST_POD_DECODER_H_K2N7QX4E */
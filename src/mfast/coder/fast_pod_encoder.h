@@ -0,0 +1,574 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef FAST_POD_ENCODER_H_W8D3LM5P
+#define FAST_POD_ENCODER_H_W8D3LM5P
+
+#include "common/pod_coder_base.h"
+#include "encoder/fast_ostream.h"
+#include "encoder/fast_ostreambuf.h"
+#include "encoder/encoder_presence_map.h"
+#include <type_traits>
+
+namespace mfast
+{
+
+///
+/// FAST encoder which encodes straight from the plain structs fast_type_gen emits for the
+/// templates with bounded fields, see mfast/pod_types.h.
+///
+/// The counterpart of fast_pod_decoder; the produced stream is the same as the one
+/// fast_encoder_v2 produces for the equivalent message.
+class fast_pod_encoder
+  : coder::pod_coder_base
+{
+public:
+
+  template <typename DescriptionsTuple>
+  fast_pod_encoder(const DescriptionsTuple& tp,
+                   typename std::enable_if< !std::is_base_of< mfast::templates_description, DescriptionsTuple>::value, allocator*>::type alloc = malloc_allocator::instance())
+    : coder::pod_coder_base(alloc)
+    , strm_(alloc)
+    , current_(0)
+  {
+    this->init(tp);
+  }
+
+  template <typename T>
+  fast_pod_encoder(const T* desc,
+                   typename std::enable_if< std::is_base_of< mfast::templates_description, T>::value, allocator*>::type alloc = malloc_allocator::instance())
+    : coder::pod_coder_base(alloc)
+    , strm_(alloc)
+    , current_(0)
+  {
+    this->init(std::make_tuple(desc));
+  }
+
+  /// Encode @a pod into FAST byte stream.
+  ///
+  /// @param[in] pod The message to be encoded.
+  /// @param[in] buffer The start position for the encoded FAST stream to be written to.
+  /// @param[in] buffer_size The capacity of @a buffer.
+  /// @param[in] force_reset Force the encoder to reset and discard all exisiting history values.
+  ///
+  /// @returns The size of the encoded byte stream. If the supplied buffer size is smaller than requried,
+  ///          an exception is thrown.
+  template <typename Pod>
+  std::size_t encode(const Pod&  pod,
+                     char*       buffer,
+                     std::size_t buffer_size,
+                     bool        force_reset = false);
+
+  /// Instruct the encoder whether the overlong presence map is allowed.
+  ///
+  /// Overlong presence map is allowed by default for better performance.
+  /// It can be disabled for better standard conformance reason.
+  void allow_overlong_pmap(bool v)
+  {
+    strm_.allow_overlong_pmap(v);
+  }
+
+  // The members of the structs are encoded by the following functions, @a index being the
+  // index of the field in the enclosing template, group or sequence.
+
+  template <typename T>
+  typename std::enable_if< std::is_integral<T>::value>::type
+  code_field(T value, bool present, std::size_t index)
+  {
+    const integer_field_instruction_base* inst = static_cast<const integer_field_instruction_base*>(group_->subinstruction(index));
+    encode_integer(inst, inst->initial_or_default_value(), value, present, coder::integer_slot());
+  }
+
+  void code_field(const pod_decimal& value, bool present, std::size_t index)
+  {
+    const decimal_field_instruction* inst = static_cast<const decimal_field_instruction*>(group_->subinstruction(index));
+    if (inst->field_type() == field_type_decimal)
+      encode_decimal(inst, value, present);
+    else
+      encode_split_decimal(inst, value, present);
+  }
+
+  template <std::size_t N>
+  void code_field(const pod_string<N>& value, bool present, std::size_t index)
+  {
+    detail::check_pod_capacity(value.length, N, group_->subinstruction(index)->name());
+    encode_string(group_->subinstruction(index), value.data, value.length, present);
+  }
+
+  template <std::size_t N>
+  void code_field(const pod_array<unsigned char, N>& value, bool present, std::size_t index)
+  {
+    detail::check_pod_capacity(value.size, N, group_->subinstruction(index)->name());
+    encode_string(group_->subinstruction(index), reinterpret_cast<const char*>(value.elements), value.size, present);
+  }
+
+  template <typename T>
+  void code_field(const T& value, std::size_t index)
+  {
+    code_field(value, true, index);
+  }
+
+  template <typename Group>
+  void code_group(const Group& group, bool present, std::size_t index);
+
+  template <typename Group>
+  void code_group(const Group& group, std::size_t index)
+  {
+    code_group(group, true, index);
+  }
+
+  template <typename Element, std::size_t N>
+  void code_sequence(const pod_array<Element, N>& sequence, bool present, std::size_t index);
+
+  template <typename Element, std::size_t N>
+  void code_sequence(const pod_array<Element, N>& sequence, std::size_t index)
+  {
+    code_sequence(sequence, true, index);
+  }
+
+private:
+  template <typename T, typename Slot>
+  void encode_integer(const integer_field_instruction_base* inst,
+                      const value_storage&                  initial_or_default,
+                      T                                     value,
+                      bool                                  present,
+                      Slot);
+
+  void encode_decimal(const decimal_field_instruction* inst, const pod_decimal& value, bool present);
+  void encode_split_decimal(const decimal_field_instruction* inst, const pod_decimal& value, bool present);
+
+  void encode_string(const field_instruction* inst, const char* data, uint32_t length, bool present);
+  void write_string(const ascii_field_instruction* inst, const char* str, uint32_t len, bool nullable);
+  void write_string_delta(const ascii_field_instruction* inst,
+                          const value_storage&           base,
+                          const char*                    data,
+                          uint32_t                       length);
+
+  fast_ostream strm_;
+  encoder_presence_map* current_;
+};
+
+template <typename Pod>
+inline std::size_t
+fast_pod_encoder::encode(const Pod&  pod,
+                         char*       buffer,
+                         std::size_t buffer_size,
+                         bool        force_reset)
+{
+  assert(buffer_size > 0);
+
+  const template_instruction* inst = this->template_of<Pod>();
+
+  fast_ostreambuf sb(buffer, buffer_size);
+  strm_.rdbuf(&sb);
+
+  if (force_reset || inst->has_reset_attribute())
+    repo_.reset_dictionary();
+
+  const bool need_encode_template_id = (active_ != inst);
+
+  encoder_presence_map pmap;
+  current_ = &pmap;
+  pmap.init(&strm_, inst->segment_pmap_size());
+  pmap.set_next_bit(need_encode_template_id);
+
+  if (need_encode_template_id)
+  {
+    active_ = inst;
+    strm_.encode(inst->id(), false, false_type());
+  }
+
+  group_ = inst;
+  Pod::code(*this, pod);
+
+  pmap.commit();
+  return sb.length();
+}
+
+template <typename Group>
+inline void
+fast_pod_encoder::code_group(const Group& group, bool present, std::size_t index)
+{
+  const group_field_instruction* inst = static_cast<const group_field_instruction*>(group_->subinstruction(index));
+
+  // If a group field is optional, it will occupy a single bit in the presence map.
+  // The contents of the group may appear in the stream iff the bit is set.
+  if (inst->optional()) {
+    current_->set_next_bit(present);
+    if (!present)
+      return;
+  }
+
+  encoder_presence_map pmap;
+  encoder_presence_map* saved_pmap = current_;
+  if (inst->segment_pmap_size() > 0) {
+    pmap.init(&strm_, inst->segment_pmap_size());
+    current_ = &pmap;
+  }
+
+  const group_field_instruction* saved_group = group_;
+  group_ = inst;
+  Group::code(*this, group);
+  group_ = saved_group;
+
+  if (inst->segment_pmap_size() > 0)
+    pmap.commit();
+  current_ = saved_pmap;
+}
+
+template <typename Element, std::size_t N>
+inline void
+fast_pod_encoder::code_sequence(const pod_array<Element, N>& sequence, bool present, std::size_t index)
+{
+  const sequence_field_instruction* inst = static_cast<const sequence_field_instruction*>(group_->subinstruction(index));
+  const uint32_field_instruction* length_inst = inst->length_instruction();
+
+  if (present)
+    detail::check_pod_capacity(sequence.size, N, inst->name());
+  encode_integer(length_inst, length_inst->initial_or_default_value(), sequence.size, present, coder::integer_slot());
+  if (!present)
+    return;
+
+  encoder_presence_map pmap;
+  encoder_presence_map* saved_pmap = current_;
+  const group_field_instruction* saved_group = group_;
+  group_ = inst;
+
+  for (uint32_t i = 0; i < sequence.size; ++i) {
+    if (inst->segment_pmap_size() > 0) {
+      pmap.init(&strm_, inst->segment_pmap_size());
+      current_ = &pmap;
+    }
+    Element::code(*this, sequence.elements[i]);
+    if (inst->segment_pmap_size() > 0)
+      pmap.commit();
+  }
+
+  group_ = saved_group;
+  current_ = saved_pmap;
+}
+
+template <typename T, typename Slot>
+void
+fast_pod_encoder::encode_integer(const integer_field_instruction_base* inst,
+                                 const value_storage&                  initial_or_default,
+                                 T                                     value,
+                                 bool                                  present,
+                                 Slot)
+{
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool nullable = inst->is_nullable();
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    // An optional field without operator is encoded with a nullable representation
+    // and the NULL represents the absence of a value.
+    strm_.encode(value, !present, nullable);
+    break;
+
+  case operator_constant:
+    if (inst->optional())
+      current_->set_next_bit(present);
+    break;
+
+  case operator_default:
+    if (is_initial_value(value, present, initial, Slot())) {
+      current_->set_next_bit(false);
+      break;
+    }
+    current_->set_next_bit(true);
+    //  A NULL indicates that the value is absent and the state of the previous value is left unchanged.
+    strm_.encode(value, !present, nullable);
+    if (!present)
+      return;
+    break;
+
+  case operator_copy:
+  case operator_increment:
+    {
+      const value_storage saved = previous;
+      save_integer(previous, value, present, Slot());
+
+      bool same;
+      if (!saved.is_defined()) {
+        same = is_initial_value(value, present, initial, Slot());
+      }
+      else if (saved.is_empty()) {
+        // It is a dynamic error [ERR D6] if the field is mandatory.
+        if (present && !inst->optional())
+          BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+        same = !present;
+      }
+      else {
+        T expected = Slot::template get<T>(saved);
+        if (inst->field_operator() == operator_increment)
+          expected = static_cast<T>(expected + 1);
+        same = present && value == expected;
+      }
+
+      current_->set_next_bit(!same);
+      if (!same)
+        strm_.encode(value, !present, nullable);
+      return;
+    }
+
+  case operator_delta:
+    if (!present) {
+      //  If the field has optional presence, the delta value can be NULL.
+      strm_.encode_null();
+      return;
+    }
+    else {
+      const value_storage& base = delta_base_value_of(previous, initial_or_default);
+      strm_.encode(delta_of(value, Slot::template get<T>(base)), false, nullable);
+      save_integer(previous, value, true, Slot());
+      return;
+    }
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (inst->previous_value_shared())
+    save_integer(previous, value, present, Slot());
+}
+
+inline void
+fast_pod_encoder::encode_decimal(const decimal_field_instruction* inst, const pod_decimal& value, bool present)
+{
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool nullable = inst->is_nullable();
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    strm_.encode(static_cast<int16_t>(value.exponent), !present, nullable);
+    if (present)
+      strm_.encode(value.mantissa, false, false_type());
+    break;
+
+  case operator_constant:
+    if (inst->optional())
+      current_->set_next_bit(present);
+    break;
+
+  case operator_default:
+    if (is_initial_value(value, present, initial)) {
+      current_->set_next_bit(false);
+      break;
+    }
+    current_->set_next_bit(true);
+    strm_.encode(static_cast<int16_t>(value.exponent), !present, nullable);
+    if (!present)
+      return;
+    strm_.encode(value.mantissa, false, false_type());
+    break;
+
+  case operator_copy:
+    {
+      bool same;
+      if (!previous.is_defined()) {
+        same = is_initial_value(value, present, initial);
+      }
+      else if (previous.is_empty()) {
+        if (present && !inst->optional())
+          BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+        same = !present;
+      }
+      else {
+        same = present &&
+               value.mantissa == previous.of_decimal.mantissa_ &&
+               value.exponent == previous.of_decimal.exponent_;
+      }
+      save_decimal(previous, value, present);
+
+      current_->set_next_bit(!same);
+      if (!same) {
+        strm_.encode(static_cast<int16_t>(value.exponent), !present, nullable);
+        if (present)
+          strm_.encode(value.mantissa, false, false_type());
+      }
+      return;
+    }
+
+  case operator_delta:
+    if (!present) {
+      strm_.encode_null();
+      return;
+    }
+    else {
+      const value_storage& base = delta_base_value_of(previous, inst->initial_or_default_value());
+      strm_.encode(static_cast<int16_t>(value.exponent - base.of_decimal.exponent_), false, nullable);
+      strm_.encode(delta_of(value.mantissa, base.of_decimal.mantissa_), false, false_type());
+      save_decimal(previous, value, true);
+      return;
+    }
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (inst->previous_value_shared())
+    save_decimal(previous, value, present);
+}
+
+inline void
+fast_pod_encoder::encode_split_decimal(const decimal_field_instruction* inst, const pod_decimal& value, bool present)
+{
+  encode_integer(inst, inst->initial_or_default_value(), static_cast<int16_t>(value.exponent), present, coder::exponent_slot());
+  if (present) {
+    const mantissa_field_instruction* mantissa_inst = inst->mantissa_instruction();
+    encode_integer(mantissa_inst, mantissa_inst->initial_or_default_value(), value.mantissa, true, coder::integer_slot());
+  }
+}
+
+inline void
+fast_pod_encoder::write_string(const ascii_field_instruction* inst, const char* str, uint32_t len, bool nullable)
+{
+  if (inst->field_type() == field_type_ascii_string)
+    strm_.encode(str, len, static_cast<const ascii_field_instruction*>(0), nullable);
+  else // unicode strings and byte vectors are both length preceded
+    strm_.encode(reinterpret_cast<const unsigned char*>(str), len, static_cast<const byte_vector_field_instruction*>(0), nullable);
+}
+
+inline void
+fast_pod_encoder::write_string_delta(const ascii_field_instruction* inst,
+                                     const value_storage&           base,
+                                     const char*                    data,
+                                     uint32_t                       length)
+{
+  const uint32_t base_len = base.array_length();
+  const char* base_str = static_cast<const char*>(base.array_content());
+  const uint32_t common_len = (std::min)(length, base_len);
+
+  uint32_t prefix = 0;
+  while (prefix < common_len && data[prefix] == base_str[prefix])
+    ++prefix;
+  uint32_t suffix = 0;
+  while (suffix < common_len && data[length-1-suffix] == base_str[base_len-1-suffix])
+    ++suffix;
+
+  int32_t substraction_len;
+  const char* delta;
+  uint32_t delta_len;
+
+  if (prefix >= suffix) {
+    substraction_len = static_cast<int32_t>(base_len - prefix);
+    delta = data + prefix;
+    delta_len = length - prefix;
+  }
+  else {
+    // Characters are removed from the front when the subtraction length is negative,
+    // using an excess-1 encoding.
+    substraction_len = ~static_cast<int32_t>(base_len - suffix);
+    delta = data;
+    delta_len = length - suffix;
+  }
+
+  strm_.encode(substraction_len, false, inst->is_nullable());
+  write_string(inst, delta, delta_len, false);
+}
+
+inline void
+fast_pod_encoder::encode_string(const field_instruction* field_inst, const char* data, uint32_t length, bool present)
+{
+  const ascii_field_instruction* inst = static_cast<const ascii_field_instruction*>(field_inst);
+  value_storage& previous = previous_value_of(inst);
+  const value_storage& initial = inst->initial_value();
+  const bool nullable = inst->is_nullable();
+
+  switch (inst->field_operator()) {
+  case operator_none:
+    write_string(inst, present ? data : 0, length, nullable);
+    break;
+
+  case operator_constant:
+    if (inst->optional())
+      current_->set_next_bit(present);
+    break;
+
+  case operator_default:
+    if (is_initial_value(data, length, present, initial)) {
+      current_->set_next_bit(false);
+      break;
+    }
+    current_->set_next_bit(true);
+    write_string(inst, present ? data : 0, length, nullable);
+    if (!present)
+      return;
+    break;
+
+  case operator_copy:
+  case operator_tail:
+    {
+      // With the bit cleared, both operators yield the initial or previous value.
+      bool same;
+      if (!previous.is_defined()) {
+        same = is_initial_value(data, length, present, initial);
+      }
+      else if (previous.is_empty()) {
+        if (present && !inst->optional())
+          BOOST_THROW_EXCEPTION(fast_dynamic_error("D6"));
+        same = !present;
+      }
+      else {
+        same = present && equal_content(data, length, previous);
+      }
+
+      current_->set_next_bit(!same);
+      if (same)
+        ;
+      else if (!present || inst->field_operator() == operator_copy)
+        write_string(inst, present ? data : 0, length, nullable);
+      else {
+        // the tail replaces the end of the base value of the same length; a value
+        // of another length is sent whole.
+        const value_storage& base = tail_base_value_of(previous, inst->initial_or_default_value());
+        uint32_t tail_pos = 0;
+        if (length == base.array_length()) {
+          const char* base_str = static_cast<const char*>(base.array_content());
+          while (tail_pos < length && data[tail_pos] == base_str[tail_pos])
+            ++tail_pos;
+        }
+        write_string(inst, data + tail_pos, length - tail_pos, nullable);
+      }
+      save_array(previous, data, length, present);
+      return;
+    }
+
+  case operator_delta:
+    if (!present) {
+      strm_.encode_null();
+      return;
+    }
+    write_string_delta(inst, delta_base_value_of(previous, inst->initial_or_default_value()), data, length);
+    save_array(previous, data, length, true);
+    return;
+
+  default:
+    BOOST_THROW_EXCEPTION(fast_static_error("S2"));
+  }
+
+  if (present && inst->previous_value_shared())
+    save_array(previous, data, length, present);
+}
+
+} /* mfast */
+
+#endif /* end of include guard: FAST_POD_ENCODER_H_W8D3LM5P */
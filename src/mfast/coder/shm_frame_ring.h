@@ -0,0 +1,494 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef SHM_FRAME_RING_H_K2D7WQ5E
+#define SHM_FRAME_RING_H_K2D7WQ5E
+
+#include "fast_encoder_v2.h"
+#include <atomic>
+#include <new>
+#include <string>
+#include <boost/exception/all.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace mfast
+{
+
+class shm_frame_ring_error
+  : public virtual boost::exception, public virtual std::exception
+{
+public:
+  shm_frame_ring_error()
+  {
+  }
+
+  shm_frame_ring_error(const char* api_function, const std::string& name)
+  {
+    *this << boost::errinfo_api_function(api_function)
+          << boost::errinfo_file_name(name)
+          << boost::errinfo_errno(errno);
+  }
+
+};
+
+///
+/// A bounded lock-free queue of encoded FAST frames living in POSIX shared memory.
+///
+/// The frame data area is divided into cells of cache_line_size bytes, and each frame
+/// occupies just enough consecutive cells to hold its encoded length. Producers reserve
+/// the cells for a frame of a given length, encode into them in place and commit the actual
+/// frame length; consumers acquire a committed frame, decode directly from it and release it.
+/// Any number of producers and consumers, in the same or in different processes, may use the
+/// ring concurrently. A frame never wraps around the end of the data area; when it does not
+/// fit into the cells left before the end, those cells are published as padding which the
+/// consumers skip.
+///
+/// A single frame can be at most capacity() bytes long; try_reserve() and try_push() throw
+/// buffer_overflow_error for a longer frame, which could never be sent.
+///
+/// The encoded frames, however, are only meaningful to a decoder whose dictionary has seen
+/// every previous frame of the encoder. With a single producer and a single consumer, each
+/// using one encoder or decoder, this holds as long as both sides stay in sync. Otherwise,
+/// create the ring with @a reset_every_frame, so that every frame is encoded and decoded
+/// with a fresh dictionary.
+///
+/// A frame encoded with force_reset is marked as such, and try_pop() then resets the
+/// decoder as well.
+///
+/// The head and tail counters are kept on separate cache lines so that producers and
+/// consumers do not contend on the same line.
+class shm_frame_ring
+{
+public:
+  static const std::size_t cache_line_size = 64;
+
+  class frame
+  {
+  public:
+    frame()
+      : cell_(0)
+      , pos_(0)
+      , cells_(0)
+      , data_(0)
+      , size_(0)
+      , reset_(false)
+    {
+    }
+
+    /// The start of the frame content.
+    char* data() const
+    {
+      return data_;
+    }
+
+    /// The capacity of the reserved cells after try_reserve(), or the committed frame length after try_acquire().
+    std::size_t size() const
+    {
+      return size_;
+    }
+
+  private:
+    friend class shm_frame_ring;
+    void* cell_;
+    unsigned long long pos_;
+    unsigned long long cells_;
+    char* data_;
+    std::size_t size_;
+    bool reset_;
+  };
+
+  /// Create a new ring, replacing any existing shared memory object with the same name.
+  ///
+  /// @param[in] name The name of the POSIX shared memory object, e.g. "/fast_md".
+  /// @param[in] capacity The size of the frame data area in bytes, which is also the maximum
+  ///            length of a single frame; rounded up to a power of 2 number of cells.
+  /// @param[in] reset_every_frame Whether try_push() and try_pop() always reset the
+  ///            dictionaries; required when there is more than one producer or consumer.
+  shm_frame_ring(const char* name,
+                 std::size_t capacity,
+                 bool        reset_every_frame = false)
+    : name_(name)
+    , owner_(true)
+  {
+    std::size_t n = 1;
+    while (n * cell_size < capacity)
+      n <<= 1;
+
+    map(O_CREAT | O_RDWR, sizeof(ring_header) + cell_headers_size(n) + n * cell_size);
+
+    header_->num_cells_ = n;
+    header_->cell_size_ = cell_size;
+    header_->reset_every_frame_ = reset_every_frame;
+    new (&header_->tail_) atomic_counter(0);
+    new (&header_->head_) atomic_counter(0);
+    init_cells();
+
+    for (std::size_t i = 0; i < n; ++i) {
+      new (&cell_at(i)->sequence_) atomic_counter(i);
+      new (&cell_at(i)->cells_) atomic_counter(0);
+      cell_at(i)->length_ = 0;
+      cell_at(i)->reset_ = 0;
+    }
+
+    new (&header_->magic_) atomic_counter(0);
+    header_->magic_.store(magic_number, std::memory_order_release);
+  }
+
+  /// Attach to a ring created by another shm_frame_ring object, possibly in another process.
+  ///
+  /// @throws shm_frame_ring_error if the shared memory object is not a ring, or is too small
+  ///         for the cells its header describes.
+  explicit shm_frame_ring(const char* name)
+    : name_(name)
+    , owner_(false)
+  {
+    map(O_RDWR, 0);
+    if (header_->magic_.load(std::memory_order_acquire) != magic_number || !valid_layout()) {
+      unmap();
+      BOOST_THROW_EXCEPTION(shm_frame_ring_error() << boost::errinfo_file_name(name_));
+    }
+    init_cells();
+  }
+
+  ~shm_frame_ring()
+  {
+    unmap();
+  }
+
+  /// Remove the shared memory object; attached rings remain usable until they are destroyed.
+  static void remove(const char* name)
+  {
+    ::shm_unlink(name);
+  }
+
+  /// The size of the frame data area, and hence the maximum length of a frame.
+  std::size_t capacity() const
+  {
+    return static_cast<std::size_t>(header_->num_cells_) * cell_size;
+  }
+
+  bool reset_every_frame() const
+  {
+    return header_->reset_every_frame_ != 0;
+  }
+
+  /// Reserve enough free cells to hold a frame of @a len bytes.
+  ///
+  /// @returns false if the ring does not have enough free cells.
+  /// @throws buffer_overflow_error if @a len exceeds capacity().
+  bool try_reserve(frame& f, std::size_t len)
+  {
+    if (len > capacity())
+      throw buffer_overflow_error();
+
+    const unsigned long long n = header_->num_cells_;
+    const unsigned long long cells = len ? (len + cell_size - 1) / cell_size : 1;
+
+    unsigned long long pos = header_->tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      unsigned long long index = pos & mask_;
+      // a frame crossing the end of the data area is preceded by padding up to the end
+      bool padding = index + cells > n;
+      unsigned long long count = padding ? n - index : cells;
+
+      int state = cells_state(pos, count);
+      if (state == 0) {
+        if (header_->tail_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+          cell_header* cell = cell_at(index);
+          if (!padding) {
+            set_frame(f, cell, pos, cells, static_cast<std::size_t>(cells * cell_size));
+            return true;
+          }
+          cell->cells_.store(count, std::memory_order_relaxed);
+          cell->length_ = 0;
+          cell->reset_ = 0;
+          cell->sequence_.store(pos + 1, std::memory_order_release);
+          pos += count;
+        }
+      }
+      else if (state < 0) {
+        return false;
+      }
+      else {
+        pos = header_->tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Publish a reserved frame holding @a len bytes. A zero length frame is skipped by consumers.
+  ///
+  /// @param[in] reset Whether the frame was encoded with force_reset.
+  void commit(frame& f, std::size_t len, bool reset = false)
+  {
+    cell_header* cell = static_cast<cell_header*>(f.cell_);
+    cell->cells_.store(f.cells_, std::memory_order_relaxed);
+    cell->length_ = len;
+    cell->reset_ = reset;
+    cell->sequence_.store(f.pos_ + 1, std::memory_order_release);
+  }
+
+  /// Acquire the oldest committed frame for reading.
+  ///
+  /// @returns false if the ring is empty.
+  bool try_acquire(frame& f)
+  {
+    unsigned long long pos = header_->head_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell_header* cell = cell_at(pos & mask_);
+      unsigned long long seq = cell->sequence_.load(std::memory_order_acquire);
+      long long dif = static_cast<long long>(seq - (pos + 1));
+      if (dif == 0) {
+        // may be stale if another consumer got here first; the exchange below then fails
+        unsigned long long cells = cell->cells_.load(std::memory_order_relaxed);
+        if (header_->head_.compare_exchange_weak(pos, pos + cells, std::memory_order_relaxed)) {
+          set_frame(f, cell, pos, cells, static_cast<std::size_t>(cell->length_));
+          f.reset_ = cell->reset_ != 0;
+          if (f.size_)
+            return true;
+          // padding or an abandoned reservation
+          release(f);
+          pos = header_->head_.load(std::memory_order_relaxed);
+        }
+      }
+      else if (dif < 0) {
+        return false;
+      }
+      else {
+        pos = header_->head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Give an acquired frame back to the producers. The frame content must not be accessed afterwards.
+  void release(frame& f)
+  {
+    const unsigned long long n = header_->num_cells_;
+    for (unsigned long long i = 0; i < f.cells_; ++i)
+      cell_at((f.pos_ + i) & mask_)->sequence_.store(f.pos_ + i + n, std::memory_order_release);
+  }
+
+  /// Encode a message directly into the ring.
+  ///
+  /// The frame is sized with fast_encoder_v2::required_buffer_size() beforehand, so it takes
+  /// exactly the cells the encoder needs, including the room a presence map occupies before
+  /// it is shrunk when the overlong presence map is disallowed.
+  ///
+  /// @returns false if the ring does not have enough free cells; the encoder dictionary
+  ///          is left untouched then.
+  /// @throws buffer_overflow_error if the encoder needs more than capacity() bytes; the
+  ///         encoder dictionary is left untouched as well. Should encoding fail after the
+  ///         cells are reserved, they are given up and the exception is propagated; as the
+  ///         encoder dictionary may then hold part of the failed message, the next message
+  ///         of @a encoder must be pushed with @a force_reset.
+  bool try_push(fast_encoder_v2&    encoder,
+                const message_cref& message,
+                bool                force_reset = false)
+  {
+    force_reset = force_reset || reset_every_frame();
+    std::size_t len = encoder.required_buffer_size(message, force_reset);
+
+    frame f;
+    if (!try_reserve(f, len))
+      return false;
+
+    try {
+      len = encoder.encode(message, f.data(), f.size(), force_reset);
+    }
+    catch (...) {
+      commit(f, 0);
+      throw;
+    }
+    commit(f, len, force_reset);
+    return true;
+  }
+
+  /// Decode the oldest frame in place and pass the decoded message to @a handler.
+  ///
+  /// The message may refer to the frame content; therefore, it is only valid inside
+  /// @a handler, the frame is released once @a handler returns.
+  ///
+  /// @returns false if the ring is empty.
+  template <typename Decoder, typename Handler>
+  bool try_pop(Decoder& decoder,
+               Handler  handler,
+               bool     force_reset = false)
+  {
+    frame f;
+    if (!try_acquire(f))
+      return false;
+
+    try {
+      const char* first = f.data();
+      handler(decoder.decode(first, first + f.size(), force_reset || f.reset_));
+    }
+    catch (...) {
+      release(f);
+      throw;
+    }
+    release(f);
+    return true;
+  }
+
+private:
+  typedef std::atomic<unsigned long long> atomic_counter;
+
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory requires lock-free 64 bits atomic operations");
+
+  static const unsigned long long magic_number = 0x4641535452494E47ULL; // "FASTRING"
+  static const std::size_t cell_size = cache_line_size;
+
+  struct ring_header
+  {
+    atomic_counter magic_;
+    unsigned long long num_cells_;
+    unsigned long long cell_size_;
+    unsigned long long reset_every_frame_;
+    char pad0_[cache_line_size - 4 * sizeof(unsigned long long)];
+    atomic_counter tail_;
+    char pad1_[cache_line_size - sizeof(atomic_counter)];
+    atomic_counter head_;
+    char pad2_[cache_line_size - sizeof(atomic_counter)];
+  };
+
+  // Only the header of the first cell of a frame describes the frame; the sequence
+  // of every cell tracks whether the cell is free for the producers.
+  struct cell_header
+  {
+    atomic_counter sequence_;
+    atomic_counter cells_;
+    unsigned long long length_;
+    unsigned long long reset_;
+  };
+
+  static std::size_t cell_headers_size(std::size_t n)
+  {
+    return (n * sizeof(cell_header) + cache_line_size - 1) & ~(cache_line_size - 1);
+  }
+
+  void map(int oflag, std::size_t size)
+  {
+    if (owner_)
+      ::shm_unlink(name_.c_str());
+
+    int fd = ::shm_open(name_.c_str(), oflag, 0600);
+    if (fd == -1)
+      BOOST_THROW_EXCEPTION(shm_frame_ring_error("shm_open", name_));
+
+    if (owner_) {
+      if (::ftruncate(fd, static_cast<off_t>(size)) == -1) {
+        shm_frame_ring_error err("ftruncate", name_);
+        ::close(fd);
+        BOOST_THROW_EXCEPTION(err);
+      }
+    }
+    else {
+      struct stat st;
+      if (::fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(ring_header)) {
+        shm_frame_ring_error err("fstat", name_);
+        ::close(fd);
+        BOOST_THROW_EXCEPTION(err);
+      }
+      size = static_cast<std::size_t>(st.st_size);
+    }
+
+    void* addr = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+      BOOST_THROW_EXCEPTION(shm_frame_ring_error("mmap", name_));
+
+    header_ = static_cast<ring_header*>(addr);
+    mapped_size_ = size;
+  }
+
+  bool valid_layout() const
+  {
+    unsigned long long n = header_->num_cells_;
+    if (n == 0 || (n & (n-1)) != 0 || header_->cell_size_ != cell_size)
+      return false;
+    // checked by division first so that a corrupt header cannot overflow the product
+    std::size_t available = mapped_size_ - sizeof(ring_header);
+    if (available / (sizeof(cell_header) + cell_size) < n)
+      return false;
+    std::size_t num_cells = static_cast<std::size_t>(n);
+    return cell_headers_size(num_cells) + num_cells * cell_size <= available;
+  }
+
+  void unmap()
+  {
+    ::munmap(header_, mapped_size_);
+  }
+
+  void init_cells()
+  {
+    std::size_t n = static_cast<std::size_t>(header_->num_cells_);
+    cells_ = reinterpret_cast<cell_header*>(header_ + 1);
+    data_ = reinterpret_cast<char*>(cells_) + cell_headers_size(n);
+    mask_ = n - 1;
+  }
+
+  cell_header* cell_at(unsigned long long index) const
+  {
+    return cells_ + index;
+  }
+
+  // Whether the @a count cells starting at ring position @a pos are free (0), still hold
+  // frames of the previous round (-1) or have been reserved by another producer (1).
+  int cells_state(unsigned long long pos, unsigned long long count) const
+  {
+    for (unsigned long long i = 0; i < count; ++i) {
+      unsigned long long seq = cell_at((pos + i) & mask_)->sequence_.load(std::memory_order_acquire);
+      long long dif = static_cast<long long>(seq - (pos + i));
+      if (dif != 0)
+        return dif < 0 ? -1 : 1;
+    }
+    return 0;
+  }
+
+  void set_frame(frame&             f,
+                 cell_header*       cell,
+                 unsigned long long pos,
+                 unsigned long long cells,
+                 std::size_t        size) const
+  {
+    f.cell_ = cell;
+    f.pos_ = pos;
+    f.cells_ = cells;
+    f.data_ = data_ + (pos & mask_) * cell_size;
+    f.size_ = size;
+  }
+
+  shm_frame_ring(const shm_frame_ring&);
+  shm_frame_ring& operator = (const shm_frame_ring&);
+
+  std::string name_;
+  bool owner_;
+  ring_header* header_;
+  std::size_t mapped_size_;
+  cell_header* cells_;
+  char* data_;
+  unsigned long long mask_;
+};
+
+} /* mfast */
+
+#endif /* end of include guard: SHM_FRAME_RING_H_K2D7WQ5E */
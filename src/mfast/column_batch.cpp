@@ -0,0 +1,657 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "column_batch.h"
+#include "aggregate_ref.h"
+#include <boost/exception/all.hpp>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace mfast {
+
+  namespace detail {
+
+    class column_builder
+    {
+    public:
+      column_builder(const std::string& name, column_type type)
+        : name_(name)
+        , type_(type)
+        , length_(0)
+        , null_count_(0)
+      {
+        if (type_ == column_binary || type_ == column_list)
+          offsets_.push_back(0);
+      }
+
+      ~column_builder()
+      {
+        for (std::size_t i = 0; i < children_.size(); ++i)
+          delete children_[i];
+      }
+
+      void append_validity(bool valid)
+      {
+        if (length_ % 8 == 0)
+          validity_.push_back(0);
+        if (valid)
+          validity_.back() |= static_cast<uint8_t>(1 << (length_ % 8));
+        else
+          ++null_count_;
+        ++length_;
+      }
+
+      void append_value(uint64_t value, bool valid)
+      {
+        values_.push_back(valid ? value : 0);
+        append_validity(valid);
+      }
+
+      void append_decimal(const value_storage* v)
+      {
+        bool valid = (v != 0 && !v->is_empty());
+        values_.push_back(valid ? v->of_decimal.mantissa_ : 0);
+        exponents_.push_back(valid ? v->of_decimal.exponent_ : 0);
+        append_validity(valid);
+      }
+
+      void append_binary(const value_storage* v)
+      {
+        bool valid = (v != 0 && !v->is_empty());
+        if (valid) {
+          const char* content = static_cast<const char*>(v->array_content());
+          data_.insert(data_.end(), content, content + v->array_length());
+        }
+        offsets_.push_back(static_cast<int32_t>(data_.size()));
+        append_validity(valid);
+      }
+
+      // Appends a list of n child rows; the children are appended by the caller.
+      void append_list(std::size_t n, bool valid)
+      {
+        offsets_.push_back(offsets_.back() + static_cast<int32_t>(n));
+        append_validity(valid);
+      }
+
+      column_view view() const
+      {
+        column_view result;
+        result.name = name_.c_str();
+        result.type = type_;
+        result.length = length_;
+        result.null_count = null_count_;
+        result.validity = validity_.empty() ? 0 : &validity_[0];
+        result.values = values_.empty() ? 0 : &values_[0];
+        result.exponents = exponents_.empty() ? 0 : &exponents_[0];
+        result.offsets = offsets_.empty() ? 0 : &offsets_[0];
+        result.data = data_.empty() ? 0 : &data_[0];
+        result.data_size = data_.size();
+        for (std::size_t i = 0; i < children_.size(); ++i)
+          result.children.push_back(children_[i]->view());
+        return result;
+      }
+
+      std::string name_;
+      column_type type_;
+      std::size_t length_;
+      std::size_t null_count_;
+      std::vector<uint8_t> validity_;
+      std::vector<uint64_t> values_;
+      std::vector<int16_t> exponents_;
+      std::vector<int32_t> offsets_;
+      std::vector<char> data_;
+      std::vector<column_builder*> children_;
+    };
+
+  }
+
+  namespace {
+
+    using detail::column_builder;
+
+    void add_columns(const group_field_instruction* instruction,
+                     const std::string&             prefix,
+                     std::vector<column_builder*>&  columns)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+        const field_instruction* inst = subinstructions[i];
+        std::string name = prefix + inst->name();
+        switch (inst->field_type()) {
+        case field_type_int32:
+        case field_type_int64:
+          columns.push_back(new column_builder(name, column_int64));
+          break;
+        case field_type_uint32:
+        case field_type_uint64:
+        case field_type_enum:
+          columns.push_back(new column_builder(name, column_uint64));
+          break;
+        case field_type_decimal:
+        case field_type_exponent:
+          columns.push_back(new column_builder(name, column_decimal));
+          break;
+        case field_type_ascii_string:
+        case field_type_unicode_string:
+        case field_type_byte_vector:
+          columns.push_back(new column_builder(name, column_binary));
+          break;
+        case field_type_int32_vector:
+        case field_type_int64_vector:
+        case field_type_uint32_vector:
+        case field_type_uint64_vector:
+          {
+            column_builder* list = new column_builder(name, column_list);
+            columns.push_back(list);
+            bool is_signed = inst->field_type() == field_type_int32_vector ||
+                             inst->field_type() == field_type_int64_vector;
+            list->children_.push_back(new column_builder("", is_signed ? column_int64 : column_uint64));
+          }
+          break;
+        case field_type_sequence:
+          {
+            column_builder* list = new column_builder(name, column_list);
+            columns.push_back(list);
+            add_columns(static_cast<const group_field_instruction*>(inst), "", list->children_);
+          }
+          break;
+        case field_type_group:
+        case field_type_template:
+          add_columns(static_cast<const group_field_instruction*>(inst), name + ".", columns);
+          break;
+        default:
+          // dynamic templateRef
+          break;
+        }
+      }
+    }
+
+    template <typename T>
+    void append_vector(column_builder* list, const value_storage* v)
+    {
+      bool valid = (v != 0 && !v->is_empty());
+      std::size_t n = valid ? v->array_length() : 0;
+      list->append_list(n, valid);
+      column_builder* child = list->children_[0];
+      const T* elements = static_cast<const T*>(v ? v->array_content() : 0);
+      for (std::size_t i = 0; i < n; ++i)
+        child->append_value(static_cast<uint64_t>(elements[i]), true);
+    }
+
+    // Appends the subfields in fields to the columns from cursor on, advancing cursor past
+    // them; fields is null when the enclosing group is absent.
+    void append_fields(const group_field_instruction* instruction,
+                       const value_storage*           fields,
+                       column_builder**&              cursor)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+        const field_instruction* inst = subinstructions[i];
+        const value_storage* v = fields ? &fields[i] : 0;
+        bool valid = (v != 0 && !v->is_empty());
+        switch (inst->field_type()) {
+        case field_type_int32:
+          (*cursor++)->append_value(static_cast<uint64_t>(valid ? v->get<int32_t>() : 0), valid);
+          break;
+        case field_type_int64:
+          (*cursor++)->append_value(static_cast<uint64_t>(valid ? v->get<int64_t>() : 0), valid);
+          break;
+        case field_type_uint32:
+          (*cursor++)->append_value(valid ? v->get<uint32_t>() : 0, valid);
+          break;
+        case field_type_uint64:
+        case field_type_enum:
+          (*cursor++)->append_value(valid ? v->get<uint64_t>() : 0, valid);
+          break;
+        case field_type_decimal:
+        case field_type_exponent:
+          (*cursor++)->append_decimal(v);
+          break;
+        case field_type_ascii_string:
+        case field_type_unicode_string:
+        case field_type_byte_vector:
+          (*cursor++)->append_binary(v);
+          break;
+        case field_type_int32_vector:
+          append_vector<int32_t>(*cursor++, v);
+          break;
+        case field_type_int64_vector:
+          append_vector<int64_t>(*cursor++, v);
+          break;
+        case field_type_uint32_vector:
+          append_vector<uint32_t>(*cursor++, v);
+          break;
+        case field_type_uint64_vector:
+          append_vector<uint64_t>(*cursor++, v);
+          break;
+        case field_type_sequence:
+          {
+            const group_field_instruction* element = static_cast<const group_field_instruction*>(inst);
+            column_builder* list = *cursor++;
+            std::size_t n = valid ? v->array_length() : 0;
+            list->append_list(n, valid);
+            const value_storage* elements = valid ? static_cast<const value_storage*>(v->of_array.content_) : 0;
+            std::size_t stride = element->subinstructions().size();
+            for (std::size_t j = 0; j < n; ++j) {
+              column_builder** children = list->children_.empty() ? 0 : &list->children_[0];
+              append_fields(element, elements + j * stride, children);
+            }
+          }
+          break;
+        case field_type_group:
+        case field_type_template:
+          {
+            bool present = v != 0 && (!inst->optional() || v->of_group.present_);
+            append_fields(static_cast<const group_field_instruction*>(inst),
+                          present ? v->group_content() : 0,
+                          cursor);
+          }
+          break;
+        default:
+          break;
+        }
+      }
+    }
+
+  }
+
+  column_batch::column_batch(const template_instruction* instruction)
+    : instruction_(instruction)
+    , num_rows_(0)
+    , sealed_(false)
+  {
+    try {
+      add_columns(instruction, "", columns_);
+    }
+    catch (...) {
+      for (std::size_t i = 0; i < columns_.size(); ++i)
+        delete columns_[i];
+      throw;
+    }
+  }
+
+  column_batch::~column_batch()
+  {
+    for (std::size_t i = 0; i < columns_.size(); ++i)
+      delete columns_[i];
+  }
+
+  void
+  column_batch::append(const message_cref& msg)
+  {
+    if (msg.instruction() != instruction_)
+      BOOST_THROW_EXCEPTION(std::invalid_argument("the message is not of the template of the column batch"));
+    if (sealed_)
+      BOOST_THROW_EXCEPTION(std::logic_error("cannot append to a sealed column batch"));
+
+    column_builder** cursor = columns_.empty() ? 0 : &columns_[0];
+    append_fields(instruction_, aggregate_cref_core_access::storage_of(msg), cursor);
+    ++num_rows_;
+  }
+
+  void
+  column_batch::seal()
+  {
+    if (sealed_)
+      return;
+    sealed_ = true;
+    for (std::size_t i = 0; i < columns_.size(); ++i)
+      views_.push_back(columns_[i]->view());
+  }
+
+  column_batch_builder::~column_batch_builder()
+  {
+    for (batches_t::iterator it = batches_.begin(); it != batches_.end(); ++it)
+      delete it->second;
+  }
+
+  void
+  column_batch_builder::append(const message_cref& msg)
+  {
+    batches_t::iterator it = batches_.find(msg.instruction());
+    if (it == batches_.end()) {
+      // construct the batch first so that a throwing constructor leaves no null entry behind
+      column_batch* batch = new column_batch(msg.instruction());
+      try {
+        it = batches_.insert(batches_t::value_type(msg.instruction(), batch)).first;
+      }
+      catch (...) {
+        delete batch;
+        throw;
+      }
+    }
+    it->second->append(msg);
+  }
+
+  column_batch*
+  column_batch_builder::release(const template_instruction* instruction)
+  {
+    batches_t::iterator it = batches_.find(instruction);
+    if (it == batches_.end())
+      return 0;
+    column_batch* result = it->second;
+    batches_.erase(it);
+    result->seal();
+    return result;
+  }
+
+  const column_batch*
+  column_batch_builder::batch(const template_instruction* instruction) const
+  {
+    batches_t::const_iterator it = batches_.find(instruction);
+    return it == batches_.end() ? 0 : it->second;
+  }
+
+  namespace {
+
+    const char column_file_magic[8] = { 'M', 'F', 'A', 'S', 'T', 'C', 'O', 'L' };
+    const uint32_t column_file_version = 1;
+    const uint64_t column_file_alignment = 64;
+
+    struct column_file_header
+    {
+      char magic_[8];
+      uint32_t version_;
+      uint32_t num_columns_;
+      uint64_t num_rows_;
+      uint64_t num_entries_;
+    };
+
+    enum {
+      name_buffer,
+      validity_buffer,
+      values_buffer,
+      exponents_buffer,
+      offsets_buffer,
+      data_buffer,
+      num_buffers
+    };
+
+    struct column_file_buffer
+    {
+      uint64_t offset_;
+      uint64_t size_;
+    };
+
+    // The columns are stored depth first, each followed by its children.
+    struct column_file_entry
+    {
+      uint32_t type_;
+      uint32_t num_children_;
+      uint64_t length_;
+      uint64_t null_count_;
+      column_file_buffer buffers_[num_buffers];
+    };
+
+    uint64_t align(uint64_t n)
+    {
+      return (n + column_file_alignment - 1) & ~(column_file_alignment - 1);
+    }
+
+    // whether the buffer has room for count elements of the given width
+    bool holds(const column_file_buffer& buffer, uint64_t count, uint64_t width)
+    {
+      return buffer.size_ / width >= count;
+    }
+
+    int32_t offset_at(const char* content, const column_file_buffer& offsets, uint64_t row)
+    {
+      // the buffer needs not be aligned in a corrupted file
+      int32_t result;
+      std::memcpy(&result, content + offsets.offset_ + row * sizeof(int32_t), sizeof(result));
+      return result;
+    }
+
+    // whether the length + 1 offsets start at 0 and never decrease
+    bool ascending_offsets(const char* content, const column_file_buffer& offsets, uint64_t length)
+    {
+      if (offset_at(content, offsets, 0) != 0)
+        return false;
+      for (uint64_t i = 1; i <= length; ++i) {
+        if (offset_at(content, offsets, i) < offset_at(content, offsets, i-1))
+          return false;
+      }
+      return true;
+    }
+
+    // remaining_entries is the number of directory entries after e
+    void check_entry(const char* content, const column_file_entry& e, uint64_t remaining_entries)
+    {
+      const column_file_buffer& name = e.buffers_[name_buffer];
+      if (name.size_ == 0 || content[name.offset_ + name.size_ - 1] != '\0')
+        BOOST_THROW_EXCEPTION(std::runtime_error("column file name is not terminated"));
+      if (e.type_ > column_list)
+        BOOST_THROW_EXCEPTION(std::runtime_error("unknown column file type"));
+      // the children follow their list column
+      if ((e.type_ != column_list && e.num_children_ != 0) || e.num_children_ > remaining_entries)
+        BOOST_THROW_EXCEPTION(std::runtime_error("inconsistent column file children"));
+
+      bool valid = holds(e.buffers_[validity_buffer], e.length_ / 8 + (e.length_ % 8 != 0), 1);
+      switch (e.type_) {
+      case column_decimal:
+        valid = valid && holds(e.buffers_[exponents_buffer], e.length_, sizeof(int16_t));
+      // fall through
+      case column_int64:
+      case column_uint64:
+        valid = valid && holds(e.buffers_[values_buffer], e.length_, sizeof(uint64_t));
+        break;
+      default:
+        // the length + 1 offsets, written so that it cannot overflow
+        valid = valid && e.buffers_[offsets_buffer].size_ / sizeof(int32_t) > e.length_;
+      }
+      if (!valid)
+        BOOST_THROW_EXCEPTION(std::runtime_error("column file buffer too small"));
+
+      // the offsets of a list column are checked against its children by read_column()
+      if (e.type_ == column_binary || e.type_ == column_list) {
+        const column_file_buffer& offsets = e.buffers_[offsets_buffer];
+        if (!ascending_offsets(content, offsets, e.length_) ||
+            (e.type_ == column_binary &&
+             static_cast<uint64_t>(offset_at(content, offsets, e.length_)) > e.buffers_[data_buffer].size_))
+          BOOST_THROW_EXCEPTION(std::runtime_error("invalid column file offsets"));
+      }
+    }
+
+    void flatten(const column_view& column, std::vector<const column_view*>& result)
+    {
+      result.push_back(&column);
+      for (std::size_t i = 0; i < column.children.size(); ++i)
+        flatten(column.children[i], result);
+    }
+
+    void buffers_of(const column_view& column, const void* buffers[num_buffers], uint64_t sizes[num_buffers])
+    {
+      buffers[name_buffer] = column.name;
+      sizes[name_buffer] = std::strlen(column.name) + 1;
+      buffers[validity_buffer] = column.validity;
+      sizes[validity_buffer] = (column.length + 7) / 8;
+      buffers[values_buffer] = column.values;
+      sizes[values_buffer] = column.values ? column.length * sizeof(uint64_t) : 0;
+      buffers[exponents_buffer] = column.exponents;
+      sizes[exponents_buffer] = column.exponents ? column.length * sizeof(int16_t) : 0;
+      buffers[offsets_buffer] = column.offsets;
+      sizes[offsets_buffer] = column.offsets ? (column.length + 1) * sizeof(int32_t) : 0;
+      buffers[data_buffer] = column.data;
+      sizes[data_buffer] = column.data_size;
+    }
+
+    class file_writer
+    {
+    public:
+      explicit file_writer(const char* path)
+        : file_(std::fopen(path, "wb"))
+        , position_(0)
+      {
+        if (file_ == 0)
+          BOOST_THROW_EXCEPTION(std::runtime_error(std::string("cannot open ") + path));
+      }
+
+      ~file_writer()
+      {
+        if (file_)
+          std::fclose(file_);
+      }
+
+      void write(const void* data, uint64_t size)
+      {
+        if (size && std::fwrite(data, 1, size, file_) != size)
+          BOOST_THROW_EXCEPTION(std::runtime_error("cannot write the column file"));
+        position_ += size;
+      }
+
+      void pad_to(uint64_t position)
+      {
+        static const char zeros[column_file_alignment] = {0};
+        write(zeros, position - position_);
+      }
+
+      void close()
+      {
+        FILE* file = file_;
+        file_ = 0;
+        if (std::fclose(file) != 0)
+          BOOST_THROW_EXCEPTION(std::runtime_error("cannot write the column file"));
+      }
+
+    private:
+      FILE* file_;
+      uint64_t position_;
+    };
+
+    column_view read_column(const char*                 content,
+                            const column_file_entry*&   entry,
+                            const column_file_entry*    entries_end)
+    {
+      if (entry == entries_end)
+        BOOST_THROW_EXCEPTION(std::runtime_error("truncated column file directory"));
+      const column_file_entry& e = *entry++;
+      const char* buffers[num_buffers];
+      for (int i = 0; i < num_buffers; ++i)
+        buffers[i] = e.buffers_[i].size_ ? content + e.buffers_[i].offset_ : 0;
+
+      column_view result;
+      result.name = buffers[name_buffer];
+      result.type = static_cast<column_type>(e.type_);
+      result.length = e.length_;
+      result.null_count = e.null_count_;
+      result.validity = reinterpret_cast<const uint8_t*>(buffers[validity_buffer]);
+      result.values = buffers[values_buffer];
+      result.exponents = reinterpret_cast<const int16_t*>(buffers[exponents_buffer]);
+      result.offsets = reinterpret_cast<const int32_t*>(buffers[offsets_buffer]);
+      result.data = buffers[data_buffer];
+      result.data_size = e.buffers_[data_buffer].size_;
+      for (uint32_t i = 0; i < e.num_children_; ++i) {
+        result.children.push_back(read_column(content, entry, entries_end));
+        // the rows of a list end within every child
+        if (static_cast<uint64_t>(offset_at(content, e.buffers_[offsets_buffer], e.length_)) >
+            result.children.back().length)
+          BOOST_THROW_EXCEPTION(std::runtime_error("invalid column file offsets"));
+      }
+      return result;
+    }
+
+  }
+
+  void write_column_file(const column_batch& batch, const char* path)
+  {
+    if (!batch.sealed())
+      BOOST_THROW_EXCEPTION(std::logic_error("the column batch is not sealed"));
+
+    std::vector<const column_view*> columns;
+    for (std::size_t i = 0; i < batch.columns().size(); ++i)
+      flatten(batch.columns()[i], columns);
+
+    column_file_header header;
+    std::memcpy(header.magic_, column_file_magic, sizeof(column_file_magic));
+    header.version_ = column_file_version;
+    header.num_columns_ = static_cast<uint32_t>(batch.columns().size());
+    header.num_rows_ = batch.num_rows();
+    header.num_entries_ = columns.size();
+
+    std::vector<column_file_entry> entries(columns.size());
+    uint64_t offset = align(sizeof(header) + entries.size() * sizeof(column_file_entry));
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      const column_view& column = *columns[i];
+      column_file_entry& entry = entries[i];
+      entry.type_ = column.type;
+      entry.num_children_ = static_cast<uint32_t>(column.children.size());
+      entry.length_ = column.length;
+      entry.null_count_ = column.null_count;
+
+      const void* buffers[num_buffers];
+      uint64_t sizes[num_buffers];
+      buffers_of(column, buffers, sizes);
+      for (int b = 0; b < num_buffers; ++b) {
+        entry.buffers_[b].offset_ = sizes[b] ? offset : 0;
+        entry.buffers_[b].size_ = sizes[b];
+        offset = align(offset + sizes[b]);
+      }
+    }
+
+    file_writer writer(path);
+    writer.write(&header, sizeof(header));
+    if (!entries.empty())
+      writer.write(&entries[0], entries.size() * sizeof(column_file_entry));
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      const void* buffers[num_buffers];
+      uint64_t sizes[num_buffers];
+      buffers_of(*columns[i], buffers, sizes);
+      for (int b = 0; b < num_buffers; ++b) {
+        if (sizes[b]) {
+          writer.pad_to(entries[i].buffers_[b].offset_);
+          writer.write(buffers[b], sizes[b]);
+        }
+      }
+    }
+    writer.close();
+  }
+
+  column_file_view::column_file_view(const void* content, std::size_t size)
+  {
+    const char* bytes = static_cast<const char*>(content);
+    column_file_header header;
+    if (size < sizeof(header))
+      BOOST_THROW_EXCEPTION(std::runtime_error("truncated column file"));
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic_, column_file_magic, sizeof(column_file_magic)) != 0 ||
+        header.version_ != column_file_version)
+      BOOST_THROW_EXCEPTION(std::runtime_error("not a column file"));
+    if (header.num_entries_ > (size - sizeof(header)) / sizeof(column_file_entry))
+      BOOST_THROW_EXCEPTION(std::runtime_error("truncated column file directory"));
+
+    const column_file_entry* entries = reinterpret_cast<const column_file_entry*>(bytes + sizeof(header));
+    const column_file_entry* entries_end = entries + header.num_entries_;
+    for (const column_file_entry* e = entries; e != entries_end; ++e) {
+      for (int b = 0; b < num_buffers; ++b) {
+        if (e->buffers_[b].offset_ > size || e->buffers_[b].size_ > size - e->buffers_[b].offset_)
+          BOOST_THROW_EXCEPTION(std::runtime_error("column file buffer out of range"));
+      }
+      check_entry(bytes, *e, entries_end - e - 1);
+    }
+
+    num_rows_ = header.num_rows_;
+    const column_file_entry* entry = entries;
+    for (uint32_t i = 0; i < header.num_columns_; ++i)
+      columns_.push_back(read_column(bytes, entry, entries_end));
+    if (entry != entries_end)
+      BOOST_THROW_EXCEPTION(std::runtime_error("inconsistent column file children"));
+  }
+
+}
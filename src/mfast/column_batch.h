@@ -0,0 +1,183 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef COLUMN_BATCH_H_T4HX6PZA
+#define COLUMN_BATCH_H_T4HX6PZA
+
+#include "mfast/message_ref.h"
+#include <boost/container/flat_map.hpp>
+#include <vector>
+
+namespace mfast {
+
+  enum column_type {
+    column_int64,   ///< int32, int64 and the elements of their vectors, in values
+    column_uint64,  ///< uint32, uint64, enum and the elements of their vectors, in values
+    column_decimal, ///< the mantissas in values and the exponents in exponents
+    column_binary,  ///< strings and byte vectors; offsets into data
+    column_list     ///< sequences and integer vectors; offsets into the rows of the children
+  };
+
+  /// The buffers of a column, in the layout of Apache Arrow: a validity bitmap with a bit per
+  /// row, least significant bit first, and value or offset buffers. Pointers that don't apply
+  /// to the column type are null.
+  struct column_view
+  {
+    const char* name;
+    column_type type;
+    std::size_t length;
+    std::size_t null_count;
+    const uint8_t* validity;
+    const void* values;
+    const int16_t* exponents;
+    const int32_t* offsets;
+    const char* data;
+    std::size_t data_size;
+    std::vector<column_view> children;
+
+    bool is_valid(std::size_t row) const
+    {
+      return (validity[row/8] >> (row%8)) & 1;
+    }
+
+    const int64_t* int64_values() const
+    {
+      return static_cast<const int64_t*>(values);
+    }
+
+    const uint64_t* uint64_values() const
+    {
+      return static_cast<const uint64_t*>(values);
+    }
+  };
+
+  namespace detail {
+    class column_builder;
+  }
+
+  /// Accumulates messages of a template into columns, a column per scalar field.
+  ///
+  /// Fields of groups are flattened into columns named "group.field"; the values are null
+  /// when an optional group is absent. A sequence becomes a list column with a child column
+  /// per element field, and an integer vector a list column with a single unnamed child.
+  /// Dynamic templateRefs have no columns.
+  class MFAST_EXPORT column_batch
+  {
+  public:
+    explicit column_batch(const template_instruction* instruction);
+    ~column_batch();
+
+    const template_instruction* instruction() const
+    {
+      return instruction_;
+    }
+
+    /// @throw std::invalid_argument if @a msg is not of the batch template.
+    /// @throw std::logic_error if the batch is sealed.
+    void append(const message_cref& msg);
+
+    std::size_t num_rows() const
+    {
+      return num_rows_;
+    }
+
+    /// Stops accepting messages; the buffers returned by columns() stay valid until the
+    /// batch is destroyed.
+    void seal();
+
+    bool sealed() const
+    {
+      return sealed_;
+    }
+
+    /// @pre sealed()
+    const std::vector<column_view>& columns() const
+    {
+      return views_;
+    }
+
+  private:
+    column_batch(const column_batch&);
+    column_batch& operator = (const column_batch&);
+
+    const template_instruction* instruction_;
+    std::vector<detail::column_builder*> columns_;
+    std::vector<column_view> views_;
+    std::size_t num_rows_;
+    bool sealed_;
+  };
+
+  /// Dispatches messages to a column_batch per template.
+  class MFAST_EXPORT column_batch_builder
+  {
+  public:
+    column_batch_builder()
+    {
+    }
+
+    ~column_batch_builder();
+
+    void append(const message_cref& msg);
+
+    /// Seals and returns the batch of @a instruction, or 0 if no message of it was appended;
+    /// the caller owns the batch. The next message of the template starts a new batch.
+    column_batch* release(const template_instruction* instruction);
+
+    /// Returns the batch of @a instruction being built, or 0.
+    const column_batch* batch(const template_instruction* instruction) const;
+
+  private:
+    column_batch_builder(const column_batch_builder&);
+    column_batch_builder& operator = (const column_batch_builder&);
+
+    typedef boost::container::flat_map<const template_instruction*, column_batch*> batches_t;
+    batches_t batches_;
+  };
+
+  /// Writes the columns of a sealed batch into a file that can be memory mapped and read by
+  /// column_file_view. Every buffer starts at a 64 bytes aligned offset.
+  ///
+  /// @throw std::runtime_error if the file cannot be written.
+  MFAST_EXPORT void write_column_file(const column_batch& batch, const char* path);
+
+  /// Reads the columns of a column file in memory, typically memory mapped, without copying
+  /// the buffers.
+  class MFAST_EXPORT column_file_view
+  {
+  public:
+    /// @throw std::runtime_error if the content is not a valid column file.
+    column_file_view(const void* content, std::size_t size);
+
+    std::size_t num_rows() const
+    {
+      return num_rows_;
+    }
+
+    const std::vector<column_view>& columns() const
+    {
+      return columns_;
+    }
+
+  private:
+    std::size_t num_rows_;
+    std::vector<column_view> columns_;
+  };
+
+}
+
+#endif /* end of include guard: COLUMN_BATCH_H_T4HX6PZA */
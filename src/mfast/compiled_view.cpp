@@ -0,0 +1,153 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "compiled_view.h"
+#include <boost/exception/all.hpp>
+#include <cstring>
+#include <stdexcept>
+
+namespace mfast {
+
+  compiled_view::compiled_view(const aggregate_view_info& info)
+    : name_(info.name_)
+    , instruction_(info.instruction_)
+    , field_names_(info.field_names_.begin(), info.field_names_.end())
+  {
+    // the last entry of info.data_ is a terminator
+    for (std::size_t i = 0; i + 1 < info.data_.size(); ++i) {
+      const field_view_info& reference = info.data_[i];
+      if (i == 0 || !info.data_[i-1].cont())
+        fields_.push_back(paths_.size());
+
+      path p = { steps_.size(), 0 };
+      const group_field_instruction* parent = instruction_;
+      const field_view_info::nest_index_t* indices = reference.nest_indices;
+      for (;;) {
+        const field_instruction* inst = parent->subinstruction(*indices);
+        step s = { static_cast<uint32_t>(*indices), leaf_step, 0, 0 };
+        ++indices;
+        if (*indices == -1) {
+          steps_.push_back(s);
+          p.leaf_ = inst;
+          break;
+        }
+
+        switch (inst->field_type()) {
+        case field_type_sequence:
+          parent = static_cast<const group_field_instruction*>(inst);
+          s.kind_ = sequence_step;
+          s.element_index_ = static_cast<uint32_t>(*indices++);
+          s.element_size_ = static_cast<uint32_t>(parent->subinstructions().size());
+          steps_.push_back(s);
+          if (*indices == -1) {
+            // a reference to an element stands for its first field, as in view_iterator
+            step first = { 0, leaf_step, 0, 0 };
+            steps_.push_back(first);
+            p.leaf_ = parent->subinstruction(0);
+          }
+          break;
+        case field_type_group:
+        case field_type_template:
+          parent = static_cast<const group_field_instruction*>(inst);
+          s.kind_ = inst->optional() ? optional_group_step : group_step;
+          steps_.push_back(s);
+          break;
+        default:
+          {
+            std::string msg("the view references a subfield of field ");
+            msg += inst->name();
+            BOOST_THROW_EXCEPTION(std::invalid_argument(msg));
+          }
+        }
+        if (p.leaf_)
+          break;
+      }
+      paths_.push_back(p);
+    }
+    path sentinel = { steps_.size(), 0 };
+    paths_.push_back(sentinel);
+    fields_.push_back(paths_.size() - 1);
+  }
+
+  const char*
+  compiled_view::field_name(std::size_t index) const
+  {
+    return index < field_names_.size() ? field_names_[index] : "";
+  }
+
+  std::size_t
+  compiled_view::field_index(const char* name) const
+  {
+    for (std::size_t i = 0; i < field_names_.size(); ++i) {
+      if (std::strcmp(field_names_[i], name) == 0)
+        return i;
+    }
+    std::string msg("no view field named ");
+    msg += name;
+    BOOST_THROW_EXCEPTION(std::invalid_argument(msg));
+  }
+
+  const value_storage*
+  compiled_view::resolve(const value_storage* fields, const path& p) const
+  {
+    const step* s = &steps_[p.first_step_];
+    const step* last = &steps_[(&p)[1].first_step_ - 1];
+    for (; s != last; ++s) {
+      const value_storage& storage = fields[s->index_];
+      switch (s->kind_) {
+      case optional_group_step:
+        if (storage.of_group.present_ == 0)
+          return 0;
+      // fall through
+      case group_step:
+        fields = storage.group_content();
+        break;
+      case sequence_step:
+        if (s->element_index_ >= storage.array_length())
+          return 0;
+        fields = static_cast<const value_storage*>(storage.of_array.content_) + s->element_index_ * s->element_size_;
+        break;
+      }
+    }
+    return &fields[last->index_];
+  }
+
+  field_cref
+  compiled_view::get(const aggregate_cref& ref, std::size_t index) const
+  {
+    const value_storage* fields = aggregate_cref_core_access::storage_of(ref);
+    const path* p = &paths_[fields_[index]];
+    const path* end = &paths_[fields_[index+1]];
+
+    const value_storage* storage = 0;
+    const field_instruction* inst = 0;
+    for (; p != end; ++p) {
+      const value_storage* candidate = resolve(fields, *p);
+      if (candidate) {
+        storage = candidate;
+        inst = p->leaf_;
+        if (!inst->optional() || !candidate->is_empty())
+          break;
+      }
+    }
+    if (storage == 0)
+      return field_cref();
+    return field_cref(storage, inst);
+  }
+
+}
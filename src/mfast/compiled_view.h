@@ -0,0 +1,135 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef COMPILED_VIEW_H_K3VQ8ZRD
+#define COMPILED_VIEW_H_K3VQ8ZRD
+
+#include "mfast/view_iterator.h"
+#include <vector>
+
+namespace mfast {
+
+  /// A view whose references are resolved once into storage paths.
+  ///
+  /// Every reference of an aggregate_view_info becomes a list of steps holding the index of
+  /// the field in its parent storage, the element index and the element size of sequences,
+  /// and whether a group is optional. Reading a view field is then a sequence of indexed
+  /// loads from the aggregate storage, without the iterator stack of view_iterator and
+  /// without constructing intermediate field references.
+  class MFAST_EXPORT compiled_view
+  {
+  public:
+    /// @throw std::invalid_argument if a reference goes through a field which is neither
+    ///        a group, a static templateRef nor a sequence.
+    explicit compiled_view(const aggregate_view_info& info);
+
+    const char* name() const
+    {
+      return name_;
+    }
+
+    const group_field_instruction* instruction() const
+    {
+      return instruction_;
+    }
+
+    /// Returns the number of fields of the view.
+    std::size_t size() const
+    {
+      return fields_.size() - 1;
+    }
+
+    /// Returns the name of the view field at @a index, or an empty string if the view was
+    /// built without names.
+    const char* field_name(std::size_t index) const;
+
+    /// @throw std::invalid_argument if the view has no field named @a name.
+    std::size_t field_index(const char* name) const;
+
+    /// Returns the number of references the field at @a index may be taken from.
+    std::size_t alternative_count(std::size_t index) const
+    {
+      return fields_[index+1] - fields_[index];
+    }
+
+    /// Returns the instruction of a reference of the field at @a index.
+    const field_instruction* alternative_instruction(std::size_t index, std::size_t alternative = 0) const
+    {
+      return paths_[fields_[index] + alternative].leaf_;
+    }
+
+    /// Returns the view field at @a index of @a ref, taken from the first of its references
+    /// which is present. If none is, the result is the field of the last reference that
+    /// could be reached, or a field without instruction when an optional group is absent or
+    /// an element index is out of range for every reference.
+    ///
+    /// @pre @a ref is of the instruction() of the view.
+    field_cref get(const aggregate_cref& ref, std::size_t index) const;
+
+    /// Visits the fields of the view in order, like the accept_accessor() of the views
+    /// generated by fast_type_gen. Fields that cannot be reached are skipped.
+    template <typename FieldAccessor>
+    void accept_accessor(const aggregate_cref& ref, FieldAccessor& accessor) const;
+
+  private:
+    enum step_kind {
+      leaf_step,
+      group_step,
+      optional_group_step,
+      sequence_step
+    };
+
+    struct step
+    {
+      uint32_t index_;
+      uint32_t kind_;
+      uint32_t element_index_;
+      uint32_t element_size_;
+    };
+
+    struct path
+    {
+      std::size_t first_step_;
+      const field_instruction* leaf_;
+    };
+
+    const value_storage* resolve(const value_storage* fields, const path& p) const;
+
+    const char* name_;
+    const group_field_instruction* instruction_;
+    std::vector<step> steps_;
+    // a path per reference, followed by a sentinel marking the end of the last one
+    std::vector<path> paths_;
+    // the index of the first path of every field, followed by paths_.size()-1
+    std::vector<std::size_t> fields_;
+    std::vector<const char*> field_names_;
+  };
+
+  template <typename FieldAccessor>
+  void compiled_view::accept_accessor(const aggregate_cref& ref, FieldAccessor& accessor) const
+  {
+    for (std::size_t i = 0; i < size(); ++i) {
+      field_cref f = get(ref, i);
+      if (f.instruction() && (FieldAccessor::visit_absent || f.present()))
+        f.accept_accessor(accessor);
+    }
+  }
+
+}
+
+#endif /* end of include guard: COMPILED_VIEW_H_K3VQ8ZRD */
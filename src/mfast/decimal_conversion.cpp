@@ -0,0 +1,115 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "decimal_conversion.h"
+#include <boost/exception/all.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace mfast {
+
+  namespace {
+
+    void strip_trailing_zeros(int64_t& mantissa, int& exponent)
+    {
+      if (mantissa == 0) {
+        exponent = 0;
+        return;
+      }
+      while (mantissa % 10 == 0) {
+        mantissa /= 10;
+        ++exponent;
+      }
+    }
+
+    // Parses the output of "%.*e"; the decimal point is skipped whatever the locale makes it.
+    void parse_scientific(const char* str, int precision, int64_t& mantissa, int& exponent)
+    {
+      bool negative = (*str == '-');
+      if (negative)
+        ++str;
+      int64_t digits = 0;
+      for (; *str != 'e'; ++str) {
+        if (*str >= '0' && *str <= '9')
+          digits = digits * 10 + (*str - '0');
+      }
+      mantissa = negative ? -digits : digits;
+      exponent = std::atoi(str + 1) - (precision - 1);
+    }
+
+  }
+
+  namespace detail {
+
+    double decimal_to_double_slow(int64_t mantissa, int16_t exponent)
+    {
+      // strtod() is correctly rounded for any number of digits and any exponent
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%lldE%d", static_cast<long long>(mantissa), static_cast<int>(exponent));
+      return std::strtod(buf, 0);
+    }
+
+  }
+
+  void double_to_decimal(double value, int64_t& mantissa, int16_t& exponent)
+  {
+    if (!std::isfinite(value))
+      BOOST_THROW_EXCEPTION(std::range_error("a non-finite double cannot be converted to decimal"));
+
+    int64_t m = 0;
+    int exp = 0;
+    bool found = (value == 0);
+
+    // Try the decimals with 0, 1, 2... digits after the decimal point while the scaled
+    // value stays within the exact integer range of a double; dividing such a mantissa by an
+    // exact power of ten is correctly rounded, so the round trip check is exact.
+    for (unsigned k = 0; !found && k <= 22; ++k) {
+      double scaled = value * detail::exact_power10(k);
+      if (std::fabs(scaled) >= static_cast<double>(detail::max_exact_double_integer))
+        break;
+      m = std::llround(scaled);
+      if (static_cast<double>(m) / detail::exact_power10(k) == value) {
+        exp = -static_cast<int>(k);
+        found = true;
+      }
+    }
+
+    if (!found) {
+      // Values needing more than 15 digits or out of the fast path range; 17 significant
+      // digits always round trip.
+      char buf[32];
+      for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*e", precision - 1, value);
+        if (precision == 17 || std::strtod(buf, 0) == value) {
+          parse_scientific(buf, precision, m, exp);
+          break;
+        }
+      }
+    }
+
+    strip_trailing_zeros(m, exp);
+    if (exp < -63 || exp > 63)
+      BOOST_THROW_EXCEPTION(std::range_error("the exponent of the double is out of the decimal range"));
+
+    mantissa = m;
+    exponent = static_cast<int16_t>(exp);
+  }
+
+}
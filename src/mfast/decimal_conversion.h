@@ -0,0 +1,128 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef DECIMAL_CONVERSION_H_Q7RM3XTD
+#define DECIMAL_CONVERSION_H_Q7RM3XTD
+
+#include "mfast_export.h"
+#include <boost/cstdint.hpp>
+#include <limits>
+
+namespace mfast {
+
+  namespace detail {
+
+    /// Returns 10^n for n <= 22; these are the powers of ten a double represents exactly.
+    inline double exact_power10(unsigned n)
+    {
+      static const double table[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+      return table[n];
+    }
+
+    /// Returns 10^n for n <= 18.
+    inline int64_t int_power10(unsigned n)
+    {
+      static const int64_t table[] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+        100000000LL, 1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL,
+        10000000000000LL, 100000000000000LL, 1000000000000000LL, 10000000000000000LL,
+        100000000000000000LL, 1000000000000000000LL
+      };
+      return table[n];
+    }
+
+    const int64_t max_exact_double_integer = 9007199254740992LL; // 2^53
+
+    MFAST_EXPORT double decimal_to_double_slow(int64_t mantissa, int16_t exponent);
+  }
+
+  /// Returns the double nearest to mantissa * 10^exponent.
+  inline double decimal_to_double(int64_t mantissa, int16_t exponent)
+  {
+    // Both the mantissa and the power of ten are exact doubles here, so a single
+    // multiplication or division is correctly rounded.
+    if (mantissa <= detail::max_exact_double_integer &&
+        mantissa >= -detail::max_exact_double_integer) {
+      if (exponent >= 0 && exponent <= 22)
+        return static_cast<double>(mantissa) * detail::exact_power10(exponent);
+      if (exponent < 0 && exponent >= -22)
+        return static_cast<double>(mantissa) / detail::exact_power10(-exponent);
+    }
+    return detail::decimal_to_double_slow(mantissa, exponent);
+  }
+
+  /// Converts @a value to the decimal with the fewest significant digits that converts
+  /// back to the same double. The mantissa has no trailing zeros.
+  ///
+  /// @throw std::range_error if @a value is not finite or its exponent is not within [-63, 63].
+  MFAST_EXPORT void double_to_decimal(double value, int64_t& mantissa, int16_t& exponent);
+
+  /// Converts mantissa * 10^exponent to a fixed point integer with @a scale digits after
+  /// the decimal point, i.e. mantissa * 10^(exponent + scale).
+  ///
+  /// @returns false if the result would overflow or lose digits; @a result is unchanged then.
+  inline bool decimal_to_fixed(int64_t mantissa, int16_t exponent, int scale, int64_t& result)
+  {
+    int shift = exponent + scale;
+    if (mantissa == 0 || shift == 0) {
+      result = mantissa;
+    }
+    else if (shift > 0) {
+      if (shift > 18)
+        return false;
+      int64_t factor = detail::int_power10(shift);
+      int64_t limit = std::numeric_limits<int64_t>::max() / factor;
+      if (mantissa > limit || mantissa < -limit)
+        return false;
+      result = mantissa * factor;
+    }
+    else {
+      if (shift < -18)
+        return false;
+      int64_t divisor = detail::int_power10(-shift);
+      if (mantissa % divisor != 0)
+        return false;
+      result = mantissa / divisor;
+    }
+    return true;
+  }
+
+  /// Converts the fixed point integer @a value with @a scale digits after the decimal point
+  /// to a decimal whose mantissa has no trailing zeros.
+  inline void fixed_to_decimal(int64_t value, int scale, int64_t& mantissa, int16_t& exponent)
+  {
+    int exp = -scale;
+    if (value == 0) {
+      exp = 0;
+    }
+    else {
+      while (value % 10 == 0) {
+        value /= 10;
+        ++exp;
+      }
+    }
+    mantissa = value;
+    exponent = static_cast<int16_t>(exp);
+  }
+
+}
+
+#endif /* end of include guard: DECIMAL_CONVERSION_H_Q7RM3XTD */
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <cfloat>
+#include <stdexcept>
 #include <boost/utility/string_ref.hpp>
 #include <boost/array.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -29,6 +30,7 @@
 #include "mfast/field_ref.h"
 #include "mfast/int_ref.h"
 #include "mfast/type_category.h"
+#include "mfast/decimal_conversion.h"
 
 #include <boost/multiprecision/cpp_dec_float.hpp>
 
@@ -191,8 +193,15 @@ namespace mfast {
 
     operator double() const
     {
-      double x = static_cast<double>(mantissa());
-      return x * std::pow(10, exponent());
+      return decimal_to_double(mantissa(), exponent());
+    }
+
+    /// Converts the value to a fixed point integer with @a scale digits after the decimal point.
+    ///
+    /// @returns false if the value cannot be represented exactly.
+    bool to_fixed(int scale, int64_t& result) const
+    {
+      return decimal_to_fixed(mantissa(), exponent(), scale, result);
     }
 
     std::string to_string() const
@@ -415,6 +424,19 @@ namespace mfast {
       this->storage()->present(1);
     }
 
+    /// Assigns the fixed point integer @a value with @a scale digits after the decimal point.
+    void as_fixed(int64_t value, int scale) const
+    {
+      int64_t mant;
+      int16_t exp;
+      fixed_to_decimal(value, scale, mant, exp);
+      this->storage()->of_decimal.mantissa_ = mant;
+      this->storage()->of_decimal.exponent_ = exp;
+      this->storage()->present(1);
+      if (has_const_exponent())
+        normalize();
+    }
+
     void set_mantissa(int64_t v) const
     {
       this->storage()->present(1);
@@ -457,14 +479,18 @@ namespace mfast {
         // we need to adjust the mantissa and exponent if the exponent is required to be const
 
         int16_t fixed_exponent = instruction()->initial_value().of_decimal.exponent_;
-        int16_t exponent_diff = exponent() - fixed_exponent;
-        for (; exponent_diff > 0; --exponent_diff)
-        {
-          this->storage()->of_decimal.mantissa_ *= 10;
+        int exponent_diff = exponent() - fixed_exponent;
+        if (exponent_diff > 0) {
+          int64_t mantissa;
+          if (!decimal_to_fixed(this->mantissa(), exponent(), -fixed_exponent, mantissa))
+            BOOST_THROW_EXCEPTION(std::range_error("decimal value is not representable with the constant exponent"));
+          this->storage()->of_decimal.mantissa_ = mantissa;
         }
-        for (; exponent_diff < 0; ++exponent_diff)
-        {
-          this->storage()->of_decimal.mantissa_ /= 10;
+        else if (exponent_diff < 0) {
+          if (exponent_diff < -18)
+            this->storage()->of_decimal.mantissa_ = 0;
+          else
+            this->storage()->of_decimal.mantissa_ /= detail::int_power10(-exponent_diff);
         }
         this->storage()->of_decimal.exponent_ = fixed_exponent;
       }
@@ -472,6 +498,18 @@ namespace mfast {
 
   private:
 
+    void as_i (double d) const
+    {
+      int64_t mant;
+      int16_t exp;
+      double_to_decimal(d, mant, exp);
+      this->storage()->of_decimal.mantissa_ = mant;
+      this->storage()->of_decimal.exponent_ = exp;
+      this->storage()->present(1);
+      if (has_const_exponent())
+        normalize();
+    }
+
     void as_i (decimal d) const
 #ifndef _MSC_VER
     {
@@ -0,0 +1,260 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "field_comparator.h"
+#include "field_instructions.h"
+#include "aggregate_ref.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mfast {
+
+  namespace {
+
+    bool equal_fields(const group_field_instruction* lhs_inst,
+                      const value_storage*           lhs,
+                      const group_field_instruction* rhs_inst,
+                      const value_storage*           rhs);
+
+    bool equal_value(const field_instruction* inst,
+                     const value_storage&     lhs,
+                     const field_instruction* rhs_inst,
+                     const value_storage&     rhs)
+    {
+      switch (inst->field_type())
+      {
+      case field_type_int32:
+      case field_type_uint32:
+      case field_type_int64:
+      case field_type_uint64:
+      case field_type_enum:
+        // the padding and defined bits hold dictionary state rather than the value
+        return lhs.of_uint64.present_ == rhs.of_uint64.present_ &&
+               (lhs.of_uint64.present_ == 0 || lhs.of_uint64.content_ == rhs.of_uint64.content_);
+      case field_type_decimal:
+      case field_type_exponent:
+        return lhs.of_decimal.present_ == rhs.of_decimal.present_ &&
+               (lhs.of_decimal.present_ == 0 ||
+                (lhs.of_decimal.mantissa_ == rhs.of_decimal.mantissa_ &&
+                 lhs.of_decimal.exponent_ == rhs.of_decimal.exponent_));
+      case field_type_ascii_string:
+      case field_type_unicode_string:
+      case field_type_byte_vector:
+      case field_type_int32_vector:
+      case field_type_uint32_vector:
+      case field_type_int64_vector:
+      case field_type_uint64_vector:
+        return lhs.of_array.len_ == rhs.of_array.len_ &&
+               (lhs.of_array.len_ <= 1 ||
+                std::memcmp(lhs.array_content(), rhs.array_content(),
+                            lhs.array_length() *
+                            static_cast<const vector_field_instruction_base*>(inst)->element_size()) == 0);
+      case field_type_sequence:
+        {
+          if (lhs.of_array.len_ != rhs.of_array.len_)
+            return false;
+          const group_field_instruction* lhs_seq = static_cast<const group_field_instruction*>(inst);
+          const group_field_instruction* rhs_seq = static_cast<const group_field_instruction*>(rhs_inst);
+          std::size_t lhs_stride = lhs_seq->subinstructions().size();
+          std::size_t rhs_stride = rhs_seq->subinstructions().size();
+          const value_storage* lhs_elements = static_cast<const value_storage*>(lhs.of_array.content_);
+          const value_storage* rhs_elements = static_cast<const value_storage*>(rhs.of_array.content_);
+          for (std::size_t i = 0; i < lhs.array_length(); ++i) {
+            if (!equal_fields(lhs_seq, lhs_elements + i * lhs_stride, rhs_seq, rhs_elements + i * rhs_stride))
+              return false;
+          }
+          return true;
+        }
+      case field_type_group:
+      case field_type_template:
+        if (inst->optional()) {
+          if (lhs.of_group.present_ != rhs.of_group.present_)
+            return false;
+          if (lhs.of_group.present_ == 0)
+            return true;
+        }
+        return equal_fields(static_cast<const group_field_instruction*>(inst), lhs.group_content(),
+                            static_cast<const group_field_instruction*>(rhs_inst), rhs.group_content());
+      case field_type_templateref:
+        {
+          const template_instruction* target = lhs.of_templateref.of_instruction.instruction_;
+          if (target != rhs.of_templateref.of_instruction.instruction_)
+            return false;
+          return target == 0 ||
+                 equal_fields(target, lhs.of_templateref.content_, target, rhs.of_templateref.content_);
+        }
+      default:
+        return false;
+      }
+    }
+
+    bool equal_fields(const group_field_instruction* lhs_inst,
+                      const value_storage*           lhs,
+                      const group_field_instruction* rhs_inst,
+                      const value_storage*           rhs)
+    {
+      const instructions_view_t& lhs_subinstructions = lhs_inst->subinstructions();
+      std::size_t n = lhs_subinstructions.size();
+
+      if (lhs_inst == rhs_inst) {
+        for (std::size_t i = 0; i < n; ++i) {
+          if (!equal_value(lhs_subinstructions[i], lhs[i], lhs_subinstructions[i], rhs[i]))
+            return false;
+        }
+        return true;
+      }
+
+      // different instructions of the same shape
+      const instructions_view_t& rhs_subinstructions = rhs_inst->subinstructions();
+      if (n != rhs_subinstructions.size())
+        return false;
+      for (std::size_t i = 0; i < n; ++i) {
+        if (lhs_subinstructions[i]->field_type() != rhs_subinstructions[i]->field_type() ||
+            lhs_subinstructions[i]->optional() != rhs_subinstructions[i]->optional() ||
+            !equal_value(lhs_subinstructions[i], lhs[i], rhs_subinstructions[i], rhs[i]))
+          return false;
+      }
+      return true;
+    }
+
+    // mixed in for absent fields
+    const uint64_t absent_value = 0x6A5D39EAE116586DULL;
+
+    inline uint64_t mix(uint64_t h, uint64_t v)
+    {
+      v *= 0x9E3779B97F4A7C15ULL;
+      v ^= v >> 29;
+      return (h ^ v) * 0x100000001B3ULL;
+    }
+
+    uint64_t hash_bytes(uint64_t h, const char* bytes, std::size_t n)
+    {
+      h = mix(h, n);
+      for (; n >= 8; n -= 8, bytes += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        h = mix(h, word);
+      }
+      if (n) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes, n);
+        h = mix(h, word);
+      }
+      return h;
+    }
+
+    uint64_t hash_fields(uint64_t h, const group_field_instruction* inst, const value_storage* fields);
+
+    uint64_t hash_value(uint64_t h, const field_instruction* inst, const value_storage& v)
+    {
+      switch (inst->field_type())
+      {
+      case field_type_int32:
+      case field_type_uint32:
+      case field_type_int64:
+      case field_type_uint64:
+      case field_type_enum:
+        return v.of_uint64.present_ ? mix(h, v.of_uint64.content_) : mix(h, absent_value);
+      case field_type_decimal:
+      case field_type_exponent:
+        if (v.of_decimal.present_ == 0)
+          return mix(h, absent_value);
+        return mix(mix(h, v.of_decimal.mantissa_), static_cast<uint16_t>(v.of_decimal.exponent_));
+      case field_type_ascii_string:
+      case field_type_unicode_string:
+      case field_type_byte_vector:
+      case field_type_int32_vector:
+      case field_type_uint32_vector:
+      case field_type_int64_vector:
+      case field_type_uint64_vector:
+        if (v.of_array.len_ == 0)
+          return mix(h, absent_value);
+        return hash_bytes(h, static_cast<const char*>(v.array_content()),
+                          v.array_length() * static_cast<const vector_field_instruction_base*>(inst)->element_size());
+      case field_type_sequence:
+        {
+          const group_field_instruction* seq = static_cast<const group_field_instruction*>(inst);
+          std::size_t stride = seq->subinstructions().size();
+          const value_storage* elements = static_cast<const value_storage*>(v.of_array.content_);
+          h = mix(h, v.of_array.len_);
+          for (std::size_t i = 0; i < v.array_length(); ++i)
+            h = hash_fields(h, seq, elements + i * stride);
+          return h;
+        }
+      case field_type_group:
+      case field_type_template:
+        if (inst->optional() && v.of_group.present_ == 0)
+          return mix(h, absent_value);
+        return hash_fields(h, static_cast<const group_field_instruction*>(inst), v.group_content());
+      case field_type_templateref:
+        {
+          const template_instruction* target = v.of_templateref.of_instruction.instruction_;
+          if (target == 0)
+            return mix(h, absent_value);
+          return hash_fields(mix(h, target->id()), target, v.of_templateref.content_);
+        }
+      default:
+        return h;
+      }
+    }
+
+    uint64_t hash_fields(uint64_t h, const group_field_instruction* inst, const value_storage* fields)
+    {
+      const instructions_view_t& subinstructions = inst->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i)
+        h = hash_value(h, subinstructions[i], fields[i]);
+      return h;
+    }
+
+  }
+
+  bool equal(const aggregate_cref& lhs, const aggregate_cref& rhs) BOOST_NOEXCEPT
+  {
+    return equal_fields(lhs.instruction(), aggregate_cref_core_access::storage_of(lhs),
+                        rhs.instruction(), aggregate_cref_core_access::storage_of(rhs));
+  }
+
+  uint64_t hash(const aggregate_cref& value) BOOST_NOEXCEPT
+  {
+    return hash_fields(0xCBF29CE484222325ULL, value.instruction(), aggregate_cref_core_access::storage_of(value));
+  }
+
+  void diff(const aggregate_cref& lhs, const aggregate_cref& rhs, std::vector<std::size_t>& changed)
+  {
+    const instructions_view_t& lhs_subinstructions = lhs.instruction()->subinstructions();
+    const instructions_view_t& rhs_subinstructions = rhs.instruction()->subinstructions();
+    const value_storage* lhs_fields = aggregate_cref_core_access::storage_of(lhs);
+    const value_storage* rhs_fields = aggregate_cref_core_access::storage_of(rhs);
+    std::size_t n = std::min(lhs_subinstructions.size(), rhs_subinstructions.size());
+
+    for (std::size_t i = 0; i < n; ++i) {
+      const field_instruction* lhs_inst = lhs_subinstructions[i];
+      const field_instruction* rhs_inst = rhs_subinstructions[i];
+      if (lhs_inst != rhs_inst &&
+          (lhs_inst->field_type() != rhs_inst->field_type() || lhs_inst->optional() != rhs_inst->optional())) {
+        changed.push_back(i);
+      }
+      else if (!equal_value(lhs_inst, lhs_fields[i], rhs_inst, rhs_fields[i])) {
+        changed.push_back(i);
+      }
+    }
+    for (std::size_t i = n; i < std::max(lhs_subinstructions.size(), rhs_subinstructions.size()); ++i)
+      changed.push_back(i);
+  }
+
+}
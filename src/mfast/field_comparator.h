@@ -1,6 +1,7 @@
 #ifndef FIELD_COMPARATOR_H_NPPC6W1A
 #define FIELD_COMPARATOR_H_NPPC6W1A
 #include <utility>
+#include <vector>
 #include "mfast/field_visitor.h"
 namespace mfast
 {
@@ -100,6 +101,20 @@ namespace mfast
     }
   }
 
+  /// Returns whether two aggregates have the same field types and values, comparing their
+  /// value_storage directly; unlike operator ==, it neither allocates nor throws, and an absent
+  /// optional sequence differs from an empty one.
+  MFAST_EXPORT bool equal(const aggregate_cref& lhs, const aggregate_cref& rhs) BOOST_NOEXCEPT;
+
+  /// Returns a 64 bits hash of the field values of an aggregate; aggregates that are equal()
+  /// have the same hash.
+  MFAST_EXPORT uint64_t hash(const aggregate_cref& value) BOOST_NOEXCEPT;
+
+  /// Appends to @a changed the indices of the top level fields whose values differ, as
+  /// compared by equal(); fields beyond the end of the shorter aggregate, or of different
+  /// types, are reported as changed.
+  MFAST_EXPORT void diff(const aggregate_cref& lhs, const aggregate_cref& rhs, std::vector<std::size_t>& changed);
+
   using namespace std::rel_ops;
 
 }
@@ -0,0 +1,84 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "field_path.h"
+#include "field_instructions.h"
+#include <cstring>
+
+namespace mfast {
+
+  field_path::field_path(const group_field_instruction* root, const char* path)
+    : sequence_count_(0)
+  {
+    const group_field_instruction* parent = root;
+    const char* name = path;
+    for (;;) {
+      if (parent == 0)
+        BOOST_THROW_EXCEPTION(field_path_error(path));
+
+      const char* end = std::strchr(name, '.');
+      std::string segment = end ? std::string(name, end) : std::string(name);
+      int index = parent->find_subinstruction_index_by_name(segment.c_str());
+      if (index < 0)
+        BOOST_THROW_EXCEPTION(field_path_error(path));
+
+      step s = { parent->subinstruction(index), static_cast<uint32_t>(index) };
+      steps_.push_back(s);
+      if (end == 0)
+        break;
+
+      switch (s.instruction_->field_type()) {
+      case field_type_sequence:
+        ++sequence_count_;
+      // fall through
+      case field_type_group:
+      case field_type_template:
+        parent = static_cast<const group_field_instruction*>(s.instruction_);
+        break;
+      default:
+        parent = 0;
+      }
+      name = end + 1;
+    }
+  }
+
+  const value_storage*
+  field_path::resolve(const value_storage* fields, const std::size_t* element_indices) const
+  {
+    assert(sequence_count_ == 0 || element_indices);
+    std::size_t last = steps_.size() - 1;
+    for (std::size_t i = 0; i < last; ++i) {
+      const step& s = steps_[i];
+      const value_storage& storage = fields[s.index_];
+      if (s.instruction_->field_type() == field_type_sequence) {
+        std::size_t element_index = *element_indices++;
+        if (element_index >= storage.array_length())
+          return 0;
+        const sequence_field_instruction* inst = static_cast<const sequence_field_instruction*>(s.instruction_);
+        fields = static_cast<const value_storage*>(storage.of_array.content_) + element_index * inst->subinstructions().size();
+      }
+      else {
+        if (s.instruction_->optional() && storage.of_group.present_ == 0)
+          return 0;
+        fields = storage.group_content();
+      }
+    }
+    return &fields[steps_[last].index_];
+  }
+
+}
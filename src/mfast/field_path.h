@@ -0,0 +1,109 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef FIELD_PATH_H_Q7RM2XCB
+#define FIELD_PATH_H_Q7RM2XCB
+
+#include "mfast/field_mref.h"
+#include "mfast/aggregate_ref.h"
+#include <boost/exception/all.hpp>
+#include <string>
+#include <vector>
+
+namespace mfast {
+
+  struct tag_field_path;
+  typedef boost::error_info<tag_field_path,std::string> field_path_info;
+
+  class field_path_error
+    : public virtual boost::exception, public virtual std::exception
+  {
+  public:
+    field_path_error(const char* path)
+    {
+      *this << field_path_info(path);
+    }
+
+  };
+
+  /// A path of field names separated by '.', like "MDEntries.MDEntryPx", resolved against
+  /// a template or group instruction.
+  ///
+  /// The names are looked up once by the constructor; get() then reaches the field through
+  /// the recorded subinstruction indices. Every sequence along the path takes an element index,
+  /// in order, from the @a element_indices argument of get().
+  class MFAST_EXPORT field_path
+  {
+  public:
+    /// @throw field_path_error if a name is not found, or a name other than the last one is
+    ///        not a group, a static templateRef or a sequence.
+    field_path(const group_field_instruction* root, const char* path);
+
+    /// Returns the instruction of the field the path leads to.
+    const field_instruction* instruction() const
+    {
+      return steps_.back().instruction_;
+    }
+
+    /// Returns the number of sequences along the path, excluding the last field.
+    std::size_t sequence_count() const
+    {
+      return sequence_count_;
+    }
+
+    /// Returns the field in @a root. The result is absent, with a null instruction, when an
+    /// optional group along the path is absent or an element index is out of range.
+    field_cref get(const aggregate_cref& root, const std::size_t* element_indices = 0) const;
+    template <typename ConstRef>
+    field_mref get(const make_aggregate_mref<ConstRef>& root, const std::size_t* element_indices = 0) const;
+
+  private:
+    const value_storage* resolve(const value_storage* fields, const std::size_t* element_indices) const;
+
+    struct step
+    {
+      const field_instruction* instruction_;
+      uint32_t index_;
+    };
+
+    std::vector<step> steps_;
+    std::size_t sequence_count_;
+  };
+
+  inline field_cref
+  field_path::get(const aggregate_cref& root, const std::size_t* element_indices) const
+  {
+    const value_storage* storage = resolve(aggregate_cref_core_access::storage_of(root), element_indices);
+    if (storage == 0)
+      return field_cref();
+    return field_cref(storage, instruction());
+  }
+
+  template <typename ConstRef>
+  inline field_mref
+  field_path::get(const make_aggregate_mref<ConstRef>& root, const std::size_t* element_indices) const
+  {
+    const value_storage* storage = resolve(aggregate_mref_core_access::storage_of(root), element_indices);
+    if (storage == 0)
+      return field_mref();
+    return field_mref(root.allocator(), const_cast<value_storage*>(storage), instruction());
+  }
+
+}
+
+#endif /* end of include guard: FIELD_PATH_H_Q7RM2XCB */
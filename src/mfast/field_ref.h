@@ -302,11 +302,160 @@ namespace mfast {
 
 
 
+  namespace detail {
+
+    // Casts an instruction to InstructionType, returning 0 if it's not of the type. The
+    // instruction types identified by a field_type_enum_t are checked against field_type()
+    // alone; the others, such as the generated instruction types, fall back to dynamic_cast.
+    template <typename InstructionType>
+    struct instruction_caster
+    {
+      static const InstructionType* cast(const field_instruction* inst)
+      {
+        return dynamic_cast<const InstructionType*>(inst);
+      }
+    };
+
+    template <unsigned FieldTypeMask, typename InstructionType>
+    struct field_type_caster
+    {
+      static const InstructionType* cast(const field_instruction* inst)
+      {
+        if (inst && ((FieldTypeMask >> inst->field_type()) & 1))
+          return static_cast<const InstructionType*>(inst);
+        return 0;
+      }
+    };
+
+    template <>
+    struct instruction_caster<field_instruction>
+    {
+      static const field_instruction* cast(const field_instruction* inst)
+      {
+        return inst;
+      }
+    };
+
+    template <>
+    struct instruction_caster<int32_field_instruction>
+      : field_type_caster<1U << field_type_int32, int32_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<uint32_field_instruction>
+      : field_type_caster<1U << field_type_uint32, uint32_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<int64_field_instruction>
+      : field_type_caster<1U << field_type_int64, int64_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<uint64_field_instruction>
+      : field_type_caster<1U << field_type_uint64, uint64_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<decimal_field_instruction>
+      : field_type_caster<(1U << field_type_decimal) | (1U << field_type_exponent), decimal_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<ascii_field_instruction>
+      : field_type_caster<(1U << field_type_ascii_string) | (1U << field_type_unicode_string) |
+                          (1U << field_type_byte_vector), ascii_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<unicode_field_instruction>
+      : field_type_caster<(1U << field_type_unicode_string) | (1U << field_type_byte_vector),
+                          unicode_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<byte_vector_field_instruction>
+      : field_type_caster<1U << field_type_byte_vector, byte_vector_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<int32_vector_field_instruction>
+      : field_type_caster<1U << field_type_int32_vector, int32_vector_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<uint32_vector_field_instruction>
+      : field_type_caster<1U << field_type_uint32_vector, uint32_vector_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<int64_vector_field_instruction>
+      : field_type_caster<1U << field_type_int64_vector, int64_vector_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<uint64_vector_field_instruction>
+      : field_type_caster<1U << field_type_uint64_vector, uint64_vector_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<group_field_instruction>
+      : field_type_caster<(1U << field_type_group) | (1U << field_type_sequence) |
+                          (1U << field_type_template), group_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<sequence_field_instruction>
+      : field_type_caster<1U << field_type_sequence, sequence_field_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<template_instruction>
+      : field_type_caster<1U << field_type_template, template_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<templateref_instruction>
+      : field_type_caster<1U << field_type_templateref, templateref_instruction>
+    {
+    };
+
+    template <>
+    struct instruction_caster<enum_field_instruction>
+      : field_type_caster<1U << field_type_enum, enum_field_instruction>
+    {
+    };
+
+    template <typename InstructionCPtr>
+    inline InstructionCPtr
+    instruction_cast(const field_instruction* inst)
+    {
+      typedef typename std::remove_const<typename std::remove_pointer<InstructionCPtr>::type>::type instruction_type;
+      return instruction_caster<instruction_type>::cast(inst);
+    }
+
+  }
+
   template <typename T1, typename T2>
   typename std::enable_if<! T1::is_mutable, T1>::type
   dynamic_cast_as(const T2& ref)
   {
-    typename T1::instruction_cptr instruction = dynamic_cast<typename T1::instruction_cptr>(ref.instruction());
+    typename T1::instruction_cptr instruction = detail::instruction_cast<typename T1::instruction_cptr>(ref.instruction());
     if (instruction == 0)
       throw std::bad_cast();
     return T1(field_mref_core_access::storage_of(ref), instruction);
@@ -316,7 +465,7 @@ namespace mfast {
   typename std::enable_if< T1::is_mutable, T1>::type
   dynamic_cast_as(const T2& ref)
   {
-    typename T1::instruction_cptr instruction = dynamic_cast<typename T1::instruction_cptr>(ref.instruction());
+    typename T1::instruction_cptr instruction = detail::instruction_cast<typename T1::instruction_cptr>(ref.instruction());
     if (instruction == 0)
       throw std::bad_cast();
     return T1(ref.allocator(), field_mref_core_access::storage_of(ref), instruction);
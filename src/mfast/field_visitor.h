@@ -32,9 +32,11 @@ namespace mfast {
 
   namespace detail {
 
+    // The adaptors dispatch on field_instruction::field_type() with a switch rather than
+    // through the virtual field_instruction::accept(), so that the compiler can turn the
+    // dispatch into a jump table and inline the calls to the accessor or mutator.
     template <class FieldAccessor>
     class field_accessor_adaptor
-      : public field_instruction_visitor
     {
       FieldAccessor& accssor_;
 
@@ -50,7 +52,7 @@ namespace mfast {
         for (field_cref r: ref)
         {
           if (r.present() || FieldAccessor::visit_absent ) {
-            r.instruction()->accept(*this, const_cast<value_storage*>(field_cref_core_access::storage_of(r)));
+            visit_field(r.instruction(), const_cast<value_storage*>(field_cref_core_access::storage_of(r)));
           }
         }
       }
@@ -63,103 +65,158 @@ namespace mfast {
         }
       }
 
-      virtual void visit(const int32_field_instruction* inst, void* storage)
+      void visit_field(const field_instruction* inst, value_storage* storage)
       {
-        int32_cref ref(static_cast<value_storage*>(storage), inst);
-        accssor_.visit(ref);
+        switch (inst->field_type())
+        {
+        case field_type_int32:
+          visit(static_cast<const int32_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint32:
+          visit(static_cast<const uint32_field_instruction*>(inst), storage);
+          break;
+        case field_type_int64:
+          visit(static_cast<const int64_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint64:
+          visit(static_cast<const uint64_field_instruction*>(inst), storage);
+          break;
+        case field_type_decimal:
+        case field_type_exponent:
+          visit(static_cast<const decimal_field_instruction*>(inst), storage);
+          break;
+        case field_type_ascii_string:
+          visit(static_cast<const ascii_field_instruction*>(inst), storage);
+          break;
+        case field_type_unicode_string:
+          visit(static_cast<const unicode_field_instruction*>(inst), storage);
+          break;
+        case field_type_byte_vector:
+          visit(static_cast<const byte_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_int32_vector:
+          visit(static_cast<const int32_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint32_vector:
+          visit(static_cast<const uint32_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_int64_vector:
+          visit(static_cast<const int64_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint64_vector:
+          visit(static_cast<const uint64_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_group:
+          visit(static_cast<const group_field_instruction*>(inst), storage);
+          break;
+        case field_type_sequence:
+          visit(static_cast<const sequence_field_instruction*>(inst), storage);
+          break;
+        case field_type_templateref:
+          visit(static_cast<const templateref_instruction*>(inst), storage);
+          break;
+        case field_type_enum:
+          visit(static_cast<const enum_field_instruction*>(inst), storage);
+          break;
+        default:
+          // the fields of static templateRefs are not visited
+          break;
+        }
       }
 
-      virtual void visit(const uint32_field_instruction* inst, void* storage)
+      void visit(const int32_field_instruction* inst, value_storage* storage)
       {
-        uint32_cref ref(static_cast<value_storage*>(storage), inst);
+        int32_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const int64_field_instruction* inst, void* storage)
+      void visit(const uint32_field_instruction* inst, value_storage* storage)
       {
-        int64_cref ref(static_cast<value_storage*>(storage), inst);
+        uint32_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const uint64_field_instruction* inst, void* storage)
+      void visit(const int64_field_instruction* inst, value_storage* storage)
       {
-        uint64_cref ref(static_cast<value_storage*>(storage), inst);
+        int64_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const decimal_field_instruction* inst, void* storage)
+      void visit(const uint64_field_instruction* inst, value_storage* storage)
       {
-        decimal_cref ref(static_cast<value_storage*>(storage),inst);
+        uint64_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const ascii_field_instruction* inst, void* storage)
+      void visit(const decimal_field_instruction* inst, value_storage* storage)
       {
-        ascii_string_cref ref(static_cast<value_storage*>(storage), inst);
+        decimal_cref ref(storage,inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const unicode_field_instruction* inst, void* storage)
+      void visit(const ascii_field_instruction* inst, value_storage* storage)
       {
-        unicode_string_cref ref(static_cast<value_storage*>(storage), inst);
+        ascii_string_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const byte_vector_field_instruction* inst, void* storage)
+      void visit(const unicode_field_instruction* inst, value_storage* storage)
       {
-        byte_vector_cref ref(static_cast<value_storage*>(storage), inst);
+        unicode_string_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const int32_vector_field_instruction* inst, void* storage)
+      void visit(const byte_vector_field_instruction* inst, value_storage* storage)
       {
-        int32_vector_cref ref(static_cast<value_storage*>(storage), inst);
+        byte_vector_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const uint32_vector_field_instruction* inst, void* storage)
+      void visit(const int32_vector_field_instruction* inst, value_storage* storage)
       {
-        uint32_vector_cref ref(static_cast<value_storage*>(storage), inst);
+        int32_vector_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const int64_vector_field_instruction* inst, void* storage)
+      void visit(const uint32_vector_field_instruction* inst, value_storage* storage)
       {
-        int64_vector_cref ref(static_cast<value_storage*>(storage), inst);
+        uint32_vector_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const uint64_vector_field_instruction* inst, void* storage)
+      void visit(const int64_vector_field_instruction* inst, value_storage* storage)
       {
-        uint64_vector_cref ref(static_cast<value_storage*>(storage), inst);
+        int64_vector_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
-      virtual void visit(const group_field_instruction* inst, void* storage)
+      void visit(const uint64_vector_field_instruction* inst, value_storage* storage)
       {
-        group_cref ref(static_cast<value_storage*>(storage), inst);
-        accssor_.visit(ref, 0);
+        uint64_vector_cref ref(storage, inst);
+        accssor_.visit(ref);
       }
 
-      virtual void visit(const sequence_field_instruction* inst, void* storage)
+      void visit(const group_field_instruction* inst, value_storage* storage)
       {
-        sequence_cref ref(static_cast<value_storage*>(storage), inst);
+        group_cref ref(storage, inst);
         accssor_.visit(ref, 0);
       }
 
-      virtual void visit(const template_instruction*, void* )
+      void visit(const sequence_field_instruction* inst, value_storage* storage)
       {
+        sequence_cref ref(storage, inst);
+        accssor_.visit(ref, 0);
       }
 
-      virtual void visit(const templateref_instruction* inst, void* storage)
+      void visit(const templateref_instruction* inst, value_storage* storage)
       {
-        nested_message_cref ref(static_cast<value_storage*>(storage), inst);
+        nested_message_cref ref(storage, inst);
         accssor_.visit(ref, 0);
       }
 
-      virtual void visit(const enum_field_instruction* inst, void* storage)
+      void visit(const enum_field_instruction* inst, value_storage* storage)
       {
-        enum_cref ref(static_cast<value_storage*>(storage), inst);
+        enum_cref ref(storage, inst);
         accssor_.visit(ref);
       }
 
@@ -168,7 +225,6 @@ namespace mfast {
 
     template <class FieldMutator>
     class field_mutator_adaptor
-      : public field_instruction_visitor
     {
       allocator* alloc_;
       FieldMutator& mutator_;
@@ -186,7 +242,7 @@ namespace mfast {
         for (field_mref r: ref)
         {
           if (r.present() || FieldMutator::visit_absent ) {
-            r.instruction()->accept(*this, field_mref_core_access::storage_of(r));
+            visit_field(r.instruction(), field_mref_core_access::storage_of(r));
           }
         }
       }
@@ -199,103 +255,158 @@ namespace mfast {
         }
       }
 
-      virtual void visit(const int32_field_instruction* inst, void* storage)
+      void visit_field(const field_instruction* inst, value_storage* storage)
       {
-        int32_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
-        mutator_.visit(ref);
+        switch (inst->field_type())
+        {
+        case field_type_int32:
+          visit(static_cast<const int32_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint32:
+          visit(static_cast<const uint32_field_instruction*>(inst), storage);
+          break;
+        case field_type_int64:
+          visit(static_cast<const int64_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint64:
+          visit(static_cast<const uint64_field_instruction*>(inst), storage);
+          break;
+        case field_type_decimal:
+        case field_type_exponent:
+          visit(static_cast<const decimal_field_instruction*>(inst), storage);
+          break;
+        case field_type_ascii_string:
+          visit(static_cast<const ascii_field_instruction*>(inst), storage);
+          break;
+        case field_type_unicode_string:
+          visit(static_cast<const unicode_field_instruction*>(inst), storage);
+          break;
+        case field_type_byte_vector:
+          visit(static_cast<const byte_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_int32_vector:
+          visit(static_cast<const int32_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint32_vector:
+          visit(static_cast<const uint32_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_int64_vector:
+          visit(static_cast<const int64_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_uint64_vector:
+          visit(static_cast<const uint64_vector_field_instruction*>(inst), storage);
+          break;
+        case field_type_group:
+          visit(static_cast<const group_field_instruction*>(inst), storage);
+          break;
+        case field_type_sequence:
+          visit(static_cast<const sequence_field_instruction*>(inst), storage);
+          break;
+        case field_type_templateref:
+          visit(static_cast<const templateref_instruction*>(inst), storage);
+          break;
+        case field_type_enum:
+          visit(static_cast<const enum_field_instruction*>(inst), storage);
+          break;
+        default:
+          // the fields of static templateRefs are not visited
+          break;
+        }
       }
 
-      virtual void visit(const uint32_field_instruction* inst, void* storage)
+      void visit(const int32_field_instruction* inst, value_storage* storage)
       {
-        uint32_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        int32_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const int64_field_instruction* inst, void* storage)
+      void visit(const uint32_field_instruction* inst, value_storage* storage)
       {
-        int64_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        uint32_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const uint64_field_instruction* inst, void* storage)
+      void visit(const int64_field_instruction* inst, value_storage* storage)
       {
-        uint64_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        int64_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const decimal_field_instruction* inst, void* storage)
+      void visit(const uint64_field_instruction* inst, value_storage* storage)
       {
-        decimal_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        uint64_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const ascii_field_instruction* inst, void* storage)
+      void visit(const decimal_field_instruction* inst, value_storage* storage)
       {
-        ascii_string_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        decimal_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const unicode_field_instruction* inst, void* storage)
+      void visit(const ascii_field_instruction* inst, value_storage* storage)
       {
-        unicode_string_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        ascii_string_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const byte_vector_field_instruction* inst, void* storage)
+      void visit(const unicode_field_instruction* inst, value_storage* storage)
       {
-        byte_vector_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        unicode_string_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const int32_vector_field_instruction* inst, void* storage)
+      void visit(const byte_vector_field_instruction* inst, value_storage* storage)
       {
-        int32_vector_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        byte_vector_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const uint32_vector_field_instruction* inst, void* storage)
+      void visit(const int32_vector_field_instruction* inst, value_storage* storage)
       {
-        uint32_vector_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        int32_vector_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const int64_vector_field_instruction* inst, void* storage)
+      void visit(const uint32_vector_field_instruction* inst, value_storage* storage)
       {
-        int64_vector_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        uint32_vector_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const uint64_vector_field_instruction* inst, void* storage)
+      void visit(const int64_vector_field_instruction* inst, value_storage* storage)
       {
-        uint64_vector_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        int64_vector_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
-      virtual void visit(const group_field_instruction* inst, void* storage)
+      void visit(const uint64_vector_field_instruction* inst, value_storage* storage)
       {
-        group_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
-        mutator_.visit(ref, 0);
+        uint64_vector_mref ref(alloc_, storage, inst);
+        mutator_.visit(ref);
       }
 
-      virtual void visit(const sequence_field_instruction* inst, void* storage)
+      void visit(const group_field_instruction* inst, value_storage* storage)
       {
-        sequence_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        group_mref ref(alloc_, storage, inst);
         mutator_.visit(ref, 0);
       }
 
-      virtual void visit(const template_instruction*, void* )
+      void visit(const sequence_field_instruction* inst, value_storage* storage)
       {
+        sequence_mref ref(alloc_, storage, inst);
+        mutator_.visit(ref, 0);
       }
 
-      virtual void visit(const templateref_instruction* inst, void* storage)
+      void visit(const templateref_instruction* inst, value_storage* storage)
       {
-        nested_message_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        nested_message_mref ref(alloc_, storage, inst);
         mutator_.visit(ref, 0);
       }
 
-      virtual void visit(const enum_field_instruction* inst, void* storage)
+      void visit(const enum_field_instruction* inst, value_storage* storage)
       {
-        enum_mref ref(alloc_, static_cast<value_storage*>(storage), inst);
+        enum_mref ref(alloc_, storage, inst);
         mutator_.visit(ref);
       }
 
@@ -310,7 +421,7 @@ namespace mfast {
   field_cref::accept_accessor(FieldAccessor& accessor) const
   {
     detail::field_accessor_adaptor<FieldAccessor> adaptor(accessor);
-    this->instruction()->accept(adaptor, const_cast<value_storage*>(this->storage()));
+    adaptor.visit_field(this->instruction(), const_cast<value_storage*>(this->storage()));
   }
 
   template <typename FieldMutator>
@@ -318,7 +429,7 @@ namespace mfast {
   field_mref::accept_mutator(FieldMutator& mutator) const
   {
     detail::field_mutator_adaptor<FieldMutator> adaptor(mutator, this->alloc_);
-    this->instruction()->accept(adaptor, this->storage());
+    adaptor.visit_field(this->instruction(), this->storage());
   }
 
 //////////////////////////////////////////////////////////
@@ -0,0 +1,199 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "flat_message.h"
+#include "aggregate_ref.h"
+#include <boost/exception/all.hpp>
+#include <cstring>
+#include <stdexcept>
+
+namespace mfast {
+
+  namespace {
+
+    bool is_group(const field_instruction* inst)
+    {
+      return inst->field_type() == field_type_group || inst->field_type() == field_type_template;
+    }
+
+    std::size_t storage_count(const group_field_instruction* instruction)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      std::size_t result = subinstructions.size();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+        if (is_group(subinstructions[i]))
+          result += storage_count(static_cast<const group_field_instruction*>(subinstructions[i]));
+      }
+      return result;
+    }
+
+    // Construct the subfields of instruction in fields; the contents of nested groups are placed
+    // from free_storage on. Returns the first storage not used.
+    value_storage* construct_fields(const group_field_instruction* instruction,
+                                    value_storage*                 fields,
+                                    value_storage*                 free_storage)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+        if (is_group(subinstructions[i])) {
+          const group_field_instruction* group = static_cast<const group_field_instruction*>(subinstructions[i]);
+          value_storage& storage = fields[i];
+          storage = value_storage();
+          storage.of_group.present_ = !group->optional();
+          storage.of_group.is_offset_ = 1;
+          storage.of_group.content_offset_ = reinterpret_cast<char*>(free_storage) - reinterpret_cast<char*>(&storage);
+          value_storage* content = free_storage;
+          free_storage = construct_fields(group, content, free_storage + group->subinstructions().size());
+        }
+        else {
+          // flat fields never allocate memory
+          subinstructions[i]->construct_value(fields[i], 0);
+        }
+      }
+      return free_storage;
+    }
+
+    void assign_fields(const group_field_instruction* instruction,
+                       const value_storage*           src,
+                       value_storage*                 dest)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+        if (is_group(subinstructions[i])) {
+          dest[i].of_group.present_ = src[i].of_group.present_;
+          assign_fields(static_cast<const group_field_instruction*>(subinstructions[i]),
+                        src[i].group_content(),
+                        dest[i].group_content());
+        }
+        else {
+          dest[i] = src[i];
+        }
+      }
+    }
+
+  }
+
+  bool
+  flat_message::is_flat(const group_field_instruction* instruction)
+  {
+    const instructions_view_t& subinstructions = instruction->subinstructions();
+    for (std::size_t i = 0; i < subinstructions.size(); ++i) {
+      switch (subinstructions[i]->field_type()) {
+      case field_type_int32:
+      case field_type_uint32:
+      case field_type_int64:
+      case field_type_uint64:
+      case field_type_decimal:
+      case field_type_exponent:
+      case field_type_enum:
+        break;
+      case field_type_group:
+      case field_type_template:
+        if (!is_flat(static_cast<const group_field_instruction*>(subinstructions[i])))
+          return false;
+        break;
+      default:
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::size_t
+  flat_message::block_size(const group_field_instruction* instruction)
+  {
+    return storage_count(instruction) * sizeof(value_storage);
+  }
+
+  void
+  flat_message::construct(const template_instruction* instruction, void* block)
+  {
+    if (!is_flat(instruction))
+      BOOST_THROW_EXCEPTION(std::invalid_argument("template cannot be stored in a flat message"));
+
+    value_storage* fields = static_cast<value_storage*>(block);
+    construct_fields(instruction, fields, fields + instruction->subinstructions().size());
+  }
+
+  void
+  flat_message::assign(const message_cref& src, void* block)
+  {
+    assign_fields(src.instruction(),
+                  aggregate_cref_core_access::storage_of(src),
+                  static_cast<value_storage*>(block));
+  }
+
+  flat_message::flat_message(const template_instruction* instruction)
+    : instruction_(instruction)
+    , size_(block_size(instruction))
+    , block_(new value_storage[size_/sizeof(value_storage)])
+  {
+    try {
+      construct(instruction_, block_);
+    }
+    catch (...) {
+      delete [] block_;
+      throw;
+    }
+  }
+
+  flat_message::flat_message(const message_cref& other)
+    : instruction_(other.instruction())
+    , size_(block_size(instruction_))
+    , block_(new value_storage[size_/sizeof(value_storage)])
+  {
+    try {
+      construct(instruction_, block_);
+    }
+    catch (...) {
+      delete [] block_;
+      throw;
+    }
+    assign(other, block_);
+  }
+
+  flat_message::flat_message(const flat_message& other)
+    : instruction_(other.instruction_)
+    , size_(other.size_)
+    , block_(new value_storage[size_/sizeof(value_storage)])
+  {
+    std::memcpy(block_, other.block_, size_);
+  }
+
+  flat_message::~flat_message()
+  {
+    delete [] block_;
+  }
+
+  flat_message&
+  flat_message::operator = (const flat_message& other)
+  {
+    if (this != &other) {
+      if (size_ != other.size_) {
+        value_storage* block = new value_storage[other.size_/sizeof(value_storage)];
+        delete [] block_;
+        block_ = block;
+        size_ = other.size_;
+      }
+      instruction_ = other.instruction_;
+      std::memcpy(block_, other.block_, size_);
+    }
+    return *this;
+  }
+
+}
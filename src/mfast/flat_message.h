@@ -0,0 +1,108 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef FLAT_MESSAGE_H_N4HX6TQE
+#define FLAT_MESSAGE_H_N4HX6TQE
+
+#include "mfast/message_ref.h"
+
+namespace mfast {
+
+  /// A message whose fields and nested groups live in one contiguous block without pointers.
+  ///
+  /// Only templates made of int32, uInt32, int64, uInt64, decimal and enum fields, groups
+  /// and static templateRefs can be stored flat; see is_flat(). The groups in the block
+  /// locate their subfields by offsets relative to themselves, so the block stays valid
+  /// wherever it is copied to: a flat message can be copied with memcpy(), published to
+  /// shared memory or persisted, and then accessed in place with cref() and mref() at its
+  /// new address.
+  class MFAST_EXPORT flat_message
+  {
+  public:
+    /// Returns true if the messages of @a instruction can be stored flat.
+    static bool is_flat(const group_field_instruction* instruction);
+
+    /// Returns the number of bytes of the block for @a instruction.
+    static std::size_t block_size(const group_field_instruction* instruction);
+
+    /// Construct the initial field values of @a instruction in @a block, which must be
+    /// block_size(instruction) bytes and aligned as value_storage.
+    ///
+    /// @throw std::invalid_argument if @a instruction is not flat.
+    static void construct(const template_instruction* instruction, void* block);
+
+    /// Copy the field values of @a src into @a block, which has been constructed for the
+    /// template of @a src.
+    static void assign(const message_cref& src, void* block);
+
+    static message_cref cref(const template_instruction* instruction, const void* block)
+    {
+      return message_cref(static_cast<const value_storage*>(block), instruction);
+    }
+
+    /// Flat messages never allocate memory; hence the returned reference has no allocator.
+    static message_mref mref(const template_instruction* instruction, void* block)
+    {
+      return message_mref(0, static_cast<value_storage*>(block), instruction);
+    }
+
+    /// Construct a flat message with the initial values of @a instruction.
+    explicit flat_message(const template_instruction* instruction);
+
+    /// Construct a flat copy of @a other.
+    explicit flat_message(const message_cref& other);
+
+    flat_message(const flat_message& other);
+    ~flat_message();
+
+    flat_message& operator = (const flat_message& other);
+
+    const template_instruction* instruction() const
+    {
+      return instruction_;
+    }
+
+    const void* data() const
+    {
+      return block_;
+    }
+
+    std::size_t size() const
+    {
+      return size_;
+    }
+
+    message_cref cref() const
+    {
+      return cref(instruction_, block_);
+    }
+
+    message_mref mref()
+    {
+      return mref(instruction_, block_);
+    }
+
+  private:
+    const template_instruction* instruction_;
+    std::size_t size_;
+    value_storage* block_;
+  };
+
+}
+
+#endif /* end of include guard: FLAT_MESSAGE_H_N4HX6TQE */
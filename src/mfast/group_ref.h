@@ -80,7 +80,7 @@ namespace mfast {
 
     const value_storage* field_storage(size_t index) const
     {
-      return &(this->storage_->of_group.content_[index]);
+      return &(this->storage_->group_content()[index]);
     }
 
   private:
@@ -155,7 +155,7 @@ namespace mfast {
   inline
   group_cref::operator aggregate_cref() const
   {
-    return aggregate_cref(static_cast<const value_storage*>(storage_->of_array.content_), instruction());
+    return aggregate_cref(storage_->group_content(), instruction());
   }
 
   inline field_cref
@@ -191,7 +191,7 @@ namespace mfast {
   inline
   make_group_mref<ConstGroupRef>::operator aggregate_mref() const
   {
-    return aggregate_mref(this->alloc_, const_cast<value_storage*>(this->storage_->of_group.content_), this->instruction());
+    return aggregate_mref(this->alloc_, const_cast<value_storage*>(this->storage_->group_content()), this->instruction());
   }
 
 }
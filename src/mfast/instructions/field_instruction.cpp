@@ -30,6 +30,7 @@ namespace mfast {
     , has_initial_value_(other.has_initial_value_)
     , field_type_(other.field_type_)
     , previous_value_shared_(other.previous_value_shared_)
+    , max_length_(other.max_length_)
     , id_(other.id_)
     , name_(other.name_)
     , ns_(other.ns_)
@@ -268,6 +268,18 @@ namespace mfast {
       previous_value_shared_ = shared;
     }
 
+    /// @returns the capacity given by the mfast:maxLength attribute, in characters or bytes
+    ///          for strings and byte vectors, in elements for sequences; 0 if unbounded.
+    uint16_t max_length() const
+    {
+      return max_length_;
+    }
+
+    void max_length(uint16_t v)
+    {
+      max_length_ = v;
+    }
+
   protected:
 
     virtual void update_invariant()
@@ -285,6 +297,7 @@ namespace mfast {
     uint16_t has_initial_value_ : 1;
     uint16_t field_type_ : 7;
     uint16_t previous_value_shared_ : 1;
+    uint16_t max_length_;
     uint32_t id_;
     const char* name_;
     const char* ns_;
@@ -338,6 +351,7 @@ namespace mfast {
     , has_initial_value_(false)
     , field_type_(field_type)
     , previous_value_shared_(false)
+    , max_length_(0)
     , id_(id)
     , name_(name)
     , ns_(ns)
@@ -17,9 +17,74 @@
 //     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "group_instruction.h"
+#include <cstring>
 
 namespace mfast
 {
+  namespace {
+
+    inline uint32_t hash_of(const char* name)
+    {
+      // FNV-1a
+      uint32_t h = 2166136261U;
+      for (; *name; ++name)
+        h = (h ^ static_cast<unsigned char>(*name)) * 16777619U;
+      return h;
+    }
+
+    inline uint32_t hash_of(uint32_t id)
+    {
+      return id;
+    }
+
+    inline uint32_t slot_of(uint32_t hash, uint32_t bits)
+    {
+      return (hash * 2654435761U) >> (32 - bits);
+    }
+
+    inline bool same_key(const field_instruction* inst, const char* name)
+    {
+      return std::strcmp(inst->name(), name) == 0;
+    }
+
+    inline bool same_key(const field_instruction* inst, uint32_t id)
+    {
+      return inst->id() == id;
+    }
+
+    template <typename Key>
+    int find_in_index(const uint16_t*             table,
+                      uint32_t                    bits,
+                      const instructions_view_t& subinstructions,
+                      Key                         key)
+    {
+      uint32_t mask = (1U << bits) - 1;
+      for (uint32_t slot = slot_of(hash_of(key), bits); table[slot]; slot = (slot + 1) & mask) {
+        if (same_key(subinstructions[table[slot]-1], key))
+          return table[slot]-1;
+      }
+      return -1;
+    }
+
+    template <typename Key>
+    void add_to_index(uint16_t*                   table,
+                      uint32_t                    bits,
+                      const instructions_view_t& subinstructions,
+                      Key                         key,
+                      uint16_t                    index)
+    {
+      uint32_t mask = (1U << bits) - 1;
+      uint32_t slot = slot_of(hash_of(key), bits);
+      for (; table[slot]; slot = (slot + 1) & mask) {
+        // keep the first one of the duplicated keys, as a linear search would find
+        if (same_key(subinstructions[table[slot]-1], key))
+          return;
+      }
+      table[slot] = index + 1;
+    }
+
+  }
+
   void group_field_instruction::construct_group_subfields(value_storage* subfields,
                                                           allocator*     alloc) const
   {
@@ -39,6 +104,12 @@ namespace mfast
 
   int group_field_instruction::find_subinstruction_index_by_id(uint32_t id) const
   {
+    if (subinstruction_index_)
+      return find_in_index(subinstruction_index_ + (1U << subinstruction_index_bits_),
+                           subinstruction_index_bits_,
+                           subinstructions_,
+                           id);
+
     for (uint32_t i = 0; i < this->subinstructions_.size(); ++i) {
       if (this->subinstructions_[i]->id() == id)
         return i;
@@ -48,6 +119,12 @@ namespace mfast
 
   int group_field_instruction::find_subinstruction_index_by_name(const char* name) const
   {
+    if (subinstruction_index_)
+      return find_in_index(subinstruction_index_,
+                           subinstruction_index_bits_,
+                           subinstructions_,
+                           name);
+
     for (uint32_t i = 0; i < this->subinstructions_.size(); ++i) {
       if (std::strcmp(this->subinstructions_[i]->name(), name) ==0)
         return i;
@@ -55,6 +132,31 @@ namespace mfast
     return -1;
   }
 
+  void group_field_instruction::build_subinstruction_index(arena_allocator& alloc)
+  {
+    subinstruction_index_ = 0;
+    std::size_t n = subinstructions_.size();
+    if (n == 0 || n >= 0xFFFF)
+      return;
+
+    // keep the load factor of the tables no more than 1/2
+    uint32_t bits = 1;
+    while ((static_cast<std::size_t>(1) << bits) < 2*n)
+      ++bits;
+
+    std::size_t table_size = static_cast<std::size_t>(1) << bits;
+    uint16_t* tables = static_cast<uint16_t*>(alloc.allocate(2 * table_size * sizeof(uint16_t)));
+    std::memset(tables, 0, 2 * table_size * sizeof(uint16_t));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      add_to_index(tables, bits, subinstructions_, subinstructions_[i]->name(), static_cast<uint16_t>(i));
+      add_to_index(tables + table_size, bits, subinstructions_, subinstructions_[i]->id(), static_cast<uint16_t>(i));
+    }
+
+    subinstruction_index_ = tables;
+    subinstruction_index_bits_ = bits;
+  }
+
 // deep copy
   void group_field_instruction::copy_group_subfields(const value_storage* src_subfields,
                                                      value_storage*       dest_subfields,
@@ -71,6 +173,7 @@ namespace mfast
   {
     storage.of_group.present_ = !optional();
     storage.of_group.is_link_ = 0;
+    storage.of_group.is_offset_ = 0;
     // group field is never used for a dictionary key; so, we won't use this
     // function for reseting a key and thus no memory deallocation is required.
     storage.of_group.content_ =
@@ -85,7 +188,7 @@ namespace mfast
   {
     if (storage.of_group.content_) {
       if (!storage.of_group.is_link_)
-        destruct_group_subfields(storage.of_group.content_, alloc);
+        destruct_group_subfields(storage.group_content(), alloc);
       if (storage.of_group.own_content_) {
         alloc->deallocate(storage.of_group.content_, group_content_byte_count());
       }
@@ -99,6 +202,7 @@ namespace mfast
   {
     storage.of_group.own_content_ = fields_storage == 0;
     storage.of_group.is_link_ = !construct_subfields;
+    storage.of_group.is_offset_ = 0;
     storage.of_group.content_ = fields_storage ? fields_storage :
                                 static_cast<value_storage*>(alloc->allocate(this->group_content_byte_count()));
 
@@ -116,10 +220,11 @@ namespace mfast
     dest.of_group.present_ = src.of_group.present_;
     dest.of_group.own_content_ = dest_fields_storage == 0;
     dest.of_group.is_link_ =  0;
+    dest.of_group.is_offset_ = 0;
     dest.of_group.content_ = dest_fields_storage ? dest_fields_storage :
                              static_cast<value_storage*>(alloc->allocate( group_content_byte_count() ));
 
-    copy_group_subfields(src.of_group.content_, dest.of_group.content_, alloc);
+    copy_group_subfields(src.group_content(), dest.of_group.content_, alloc);
   }
 
   group_field_instruction*
@@ -136,12 +241,14 @@ namespace mfast
     storage.of_group.present_ = 1;
     storage.of_group.own_content_ = 0;
     storage.of_group.is_link_ = 1;
+    storage.of_group.is_offset_ = 0;
     storage.of_group.content_ = fields_storage;
   }
 
   void  group_field_instruction::set_subinstructions(instructions_view_t instructions)
   {
     subinstructions_ = instructions;
+    subinstruction_index_ = 0;
     segment_pmap_size_ = 0;
     for (const field_instruction* inst: instructions)
     {
@@ -55,6 +55,8 @@ namespace mfast
       , typeref_ns_(typeref_ns)
       , segment_pmap_size_(0)
       , subinstructions_(0,0)
+      , subinstruction_index_(0)
+      , subinstruction_index_bits_(0)
     {
       set_subinstructions(subinstructions);
     }
@@ -82,6 +84,11 @@ namespace mfast
     /// or -1 if not found.
     int find_subinstruction_index_by_name(const char* name) const;
 
+    /// Build a hash index of the subinstructions by name and by id, so that the above
+    /// two functions don't need to scan the subinstructions. The index is allocated
+    /// from @a alloc and is discarded by set_subinstructions().
+    void build_subinstruction_index(arena_allocator& alloc);
+
 
     const field_instruction* subinstruction(std::size_t index) const
     {
@@ -173,6 +180,10 @@ namespace mfast
 #ifdef _MSC_VER
 #pragma warning( pop )
 #endif
+    // two open addressing tables of (subinstruction index + 1), by name and then by id,
+    // each of which has (1 << subinstruction_index_bits_) slots
+    const uint16_t* subinstruction_index_;
+    uint32_t subinstruction_index_bits_;
   };
 
   template <typename T>
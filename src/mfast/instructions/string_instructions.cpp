@@ -71,10 +71,17 @@ namespace mfast
                                                      value_storage*) const
   {
     dest.of_array.defined_bit_ = 1;
+    dest.of_array.inline_ = 0;
     size_t len = src.of_array.len_;
-    if (len && src.of_array.content_ != initial_value_.of_array.content_) {
+    if (src.is_inline_array() || (len && len <= value_storage::inline_array_capacity)) {
+      // short strings are copied into the storage itself
+      dest.of_array.capacity_in_bytes_ = 0;
+      dest.of_array.inline_ = 1;
+      std::memcpy(&dest.of_array.content_, src.array_content(), len);
+    }
+    else if (len && src.of_array.content_ != initial_value_.of_array.content_) {
       dest.of_array.content_ = 0;
-      dest.of_array.capacity_in_bytes_ = alloc->reallocate(dest.of_array.content_, 0, len * element_size_);
+      dest.of_array.capacity_in_bytes_ = reallocate_array(alloc, dest.of_array.content_, 0, len * element_size_);
       std::memcpy(dest.of_array.content_, src.of_array.content_, len * element_size_);
     }
     else {
@@ -33,8 +33,9 @@ namespace mfast
       dest_fields_storage = static_cast<value_storage*>(
         alloc->allocate(this->group_content_byte_count()));
     }
+    dest.of_group.is_offset_ = 0;
     dest.of_group.content_ = dest_fields_storage;
-    copy_group_subfields(src.of_group.content_,
+    copy_group_subfields(src.group_content(),
                          dest_fields_storage,
                          alloc);
 
@@ -42,10 +42,17 @@ namespace mfast
   {
     dest.of_array.defined_bit_ = 1;
     dest.of_array.len_ = src.of_array.len_;
-    if (src.of_array.len_) {
+    dest.of_array.inline_ = 0;
+    if (element_size_ == 1 && src.of_array.len_ <= value_storage::inline_array_capacity) {
+      // short byte vectors are copied into the storage itself
+      dest.of_array.capacity_in_bytes_ = 0;
+      dest.of_array.inline_ = 1;
+      std::memcpy(&dest.of_array.content_, src.array_content(), src.of_array.len_);
+    }
+    else if (src.of_array.len_) {
       dest.of_array.content_ = 0;
-      dest.of_array.capacity_in_bytes_ = alloc->reallocate(dest.of_array.content_, 0, src.of_array.len_ * element_size_);
-      std::memcpy(dest.of_array.content_, src.of_array.content_, src.of_array.len_ * element_size_);
+      dest.of_array.capacity_in_bytes_ = reallocate_array(alloc, dest.of_array.content_, 0, src.of_array.len_ * element_size_);
+      std::memcpy(dest.of_array.content_, src.array_content(), src.of_array.len_ * element_size_);
     }
     else {
       dest.of_array.capacity_in_bytes_ = 0;
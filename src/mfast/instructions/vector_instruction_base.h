@@ -65,6 +65,11 @@ namespace mfast
                                       allocator*           alloc,
                                       value_storage*       fields_storage=0) const;
 
+    std::size_t element_size() const
+    {
+      return element_size_;
+    }
+
   protected:
     std::size_t element_size_;
   };
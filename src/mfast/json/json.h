@@ -21,12 +21,17 @@ namespace mfast
     MFAST_JSON_EXPORT bool encode(std::ostream&                 is,
                                   const ::mfast::sequence_cref& seq,
                                   unsigned json_object_tag_mask=0);
+
+    /// @param validate_utf8 Whether to check that the values of unicode string fields are
+    ///        valid UTF-8; a std::runtime_error is thrown for those which are not.
     MFAST_JSON_EXPORT void decode(std::istream&                  is,
                                   const ::mfast::aggregate_mref& msg,
-                                  unsigned json_object_tag_mask=0);
+                                  unsigned json_object_tag_mask=0,
+                                  bool validate_utf8=false);
     MFAST_JSON_EXPORT void decode(std::istream&                 is,
                                   const ::mfast::sequence_mref& seq,
-                                  unsigned json_object_tag_mask=0);
+                                  unsigned json_object_tag_mask=0,
+                                  bool validate_utf8=false);
   } // namespace json
 } // namespace mfast
 
@@ -329,15 +329,18 @@ namespace mfast {
     {
       std::istream& strm_;
       unsigned json_object_tag_mask_;
+      bool validate_utf8_;
 
       enum {
         visit_absent = true
       };
 
       decode_visitor(std::istream& strm,
-                     unsigned      json_object_tag_mask)
+                     unsigned      json_object_tag_mask,
+                     bool          validate_utf8)
         : strm_(strm)
         , json_object_tag_mask_(json_object_tag_mask)
+        , validate_utf8_(validate_utf8)
       {
       }
 
@@ -408,10 +411,22 @@ namespace mfast {
       {
         std::string str;
         if (get_quoted_string(strm_, &str, 0)) {
+          check_utf8(ref, str);
           ref.as(str);
         }
       }
 
+      void check_utf8(const mfast::ascii_string_mref&, const std::string&)
+      {
+      }
+
+      void check_utf8(const mfast::unicode_string_mref&, const std::string& str)
+      {
+        // raw bytes and unpaired \u surrogates both end up here
+        if (validate_utf8_ && !is_valid_utf8(str.data(), str.size()))
+          BOOST_THROW_EXCEPTION(json_decode_error(strm_, "Not a valid UTF-8 string"));
+      }
+
       void visit(const mfast::byte_vector_mref& ref)
       {
         if (ref.instruction()->tag().to_uint64() & json_object_tag_mask_) {
@@ -595,17 +610,19 @@ namespace mfast {
 
     void decode(std::istream&                is,
                 const mfast::aggregate_mref& msg,
-                unsigned                     json_object_tag_mask)
+                unsigned                     json_object_tag_mask,
+                bool                         validate_utf8)
     {
-      decode_visitor visitor(is, json_object_tag_mask);
+      decode_visitor visitor(is, json_object_tag_mask, validate_utf8);
       visitor.visit_impl(msg);
     }
 
     void decode(std::istream&               is,
                 const mfast::sequence_mref& seq,
-                unsigned                    json_object_tag_mask)
+                unsigned                    json_object_tag_mask,
+                bool                        validate_utf8)
     {
-      decode_visitor visitor(is, json_object_tag_mask);
+      decode_visitor visitor(is, json_object_tag_mask, validate_utf8);
       visitor.visit(seq, 0);
     }
 
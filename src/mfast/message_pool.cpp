@@ -0,0 +1,231 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "message_pool.h"
+#include "sequence_ref.h"
+#include <cstring>
+
+namespace mfast {
+
+  namespace {
+
+    void assign_subfields(const group_field_instruction* instruction,
+                          const value_storage*           src,
+                          value_storage*                 dest,
+                          allocator*                     alloc);
+
+    // Copy the array content of src into dest, keeping the memory dest already owns.
+    void assign_array(const value_storage& src,
+                      value_storage&       dest,
+                      std::size_t          element_size,
+                      allocator*           alloc)
+    {
+      std::size_t bytes = src.of_array.len_ * element_size;
+      if (bytes > dest.of_array.capacity_in_bytes_) {
+        if (element_size == 1 &&
+            bytes <= value_storage::inline_array_capacity &&
+            dest.of_array.capacity_in_bytes_ == 0) {
+          dest.of_array.inline_ = 1;
+        }
+        else {
+          // the old content needs not be preserved
+          if (dest.of_array.capacity_in_bytes_)
+            alloc->deallocate(dest.of_array.content_, dest.of_array.capacity_in_bytes_);
+          dest.of_array.content_ = 0;
+          dest.of_array.capacity_in_bytes_ = reallocate_array(alloc, dest.of_array.content_, 0, bytes);
+          dest.of_array.inline_ = 0;
+        }
+      }
+      if (bytes)
+        std::memcpy(dest.array_content(), src.array_content(), bytes);
+      dest.of_array.len_ = src.of_array.len_;
+      dest.of_array.defined_bit_ = 1;
+    }
+
+    void assign_sequence(const sequence_field_instruction* instruction,
+                         const value_storage&              src,
+                         value_storage&                    dest,
+                         allocator*                        alloc)
+    {
+      std::size_t length = src.array_length();
+      // reserve() keeps the elements constructed beyond the length, so they are reused here
+      detail::sequence_mref_helper::reserve(instruction, &dest, alloc, length);
+
+      std::size_t num_fields = instruction->subinstructions().size();
+      const value_storage* src_elements = static_cast<const value_storage*>(src.of_array.content_);
+      value_storage* dest_elements = static_cast<value_storage*>(dest.of_array.content_);
+      for (std::size_t i = 0; i < length; ++i) {
+        assign_subfields(instruction,
+                         &src_elements[i*num_fields],
+                         &dest_elements[i*num_fields],
+                         alloc);
+      }
+      dest.of_array.len_ = src.of_array.len_;
+    }
+
+    void assign_value(const field_instruction* instruction,
+                      const value_storage&     src,
+                      value_storage&           dest,
+                      allocator*               alloc)
+    {
+      switch (instruction->field_type())
+      {
+      case field_type_int32:
+      case field_type_uint32:
+      case field_type_int64:
+      case field_type_uint64:
+      case field_type_decimal:
+      case field_type_exponent:
+      case field_type_enum:
+        dest = src;
+        return;
+      case field_type_ascii_string:
+      case field_type_unicode_string:
+      case field_type_byte_vector:
+      case field_type_int32_vector:
+      case field_type_uint32_vector:
+      case field_type_int64_vector:
+      case field_type_uint64_vector:
+        assign_array(src,
+                     dest,
+                     static_cast<const vector_field_instruction_base*>(instruction)->element_size(),
+                     alloc);
+        return;
+      case field_type_sequence:
+        assign_sequence(static_cast<const sequence_field_instruction*>(instruction), src, dest, alloc);
+        return;
+      case field_type_group:
+      case field_type_template:
+        if (dest.of_group.content_ && !dest.of_group.is_link_ && src.group_content()) {
+          dest.of_group.present_ = src.of_group.present_;
+          assign_subfields(static_cast<const group_field_instruction*>(instruction),
+                           src.group_content(),
+                           dest.group_content(),
+                           alloc);
+          return;
+        }
+        break;
+      case field_type_templateref:
+        if (src.of_templateref.of_instruction.instruction_ &&
+            src.of_templateref.of_instruction.instruction_ == dest.of_templateref.of_instruction.instruction_) {
+          assign_subfields(src.of_templateref.of_instruction.instruction_,
+                           src.of_templateref.content_,
+                           dest.of_templateref.content_,
+                           alloc);
+          return;
+        }
+        break;
+      default:
+        break;
+      }
+
+      // the layout of dest doesn't match; fall back to a fresh copy
+      instruction->destruct_value(dest, alloc);
+      instruction->copy_construct_value(src, dest, alloc);
+    }
+
+    void assign_subfields(const group_field_instruction* instruction,
+                          const value_storage*           src,
+                          value_storage*                 dest,
+                          allocator*                     alloc)
+    {
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i)
+        assign_value(subinstructions[i], src[i], dest[i], alloc);
+    }
+
+  }
+
+  message_pool::message_pool(mfast::allocator* alloc)
+    : alloc_(alloc)
+  {
+  }
+
+  message_pool::~message_pool()
+  {
+    clear();
+  }
+
+  pooled_message
+  message_pool::copy(const message_cref& msg)
+  {
+    const template_instruction* instruction = msg.instruction();
+    detail::pooled_message_entry* entry = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      idle_map_t::iterator itr = idle_entries_.find(instruction);
+      if (itr != idle_entries_.end() && itr->second) {
+        entry = itr->second;
+        itr->second = entry->next_;
+      }
+    }
+
+    if (entry == 0)
+      entry = new detail::pooled_message_entry(alloc_, instruction, this);
+
+    entry->next_ = 0;
+    // the entry goes back to the pool if the copy throws
+    pooled_message result(entry);
+    assign_subfields(instruction,
+                     aggregate_cref_core_access::storage_of(msg),
+                     aggregate_mref_core_access::storage_of(entry->message_.mref()),
+                     alloc_);
+    return result;
+  }
+
+  std::size_t
+  message_pool::idle_count(const template_instruction* instruction) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_map_t::const_iterator itr = idle_entries_.find(instruction);
+    std::size_t result = 0;
+    if (itr != idle_entries_.end()) {
+      for (detail::pooled_message_entry* entry = itr->second; entry; entry = entry->next_)
+        ++result;
+    }
+    return result;
+  }
+
+  void
+  message_pool::clear()
+  {
+    idle_map_t entries;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries.swap(idle_entries_);
+    }
+    for (idle_map_t::iterator itr = entries.begin(); itr != entries.end(); ++itr) {
+      detail::pooled_message_entry* entry = itr->second;
+      while (entry) {
+        detail::pooled_message_entry* next = entry->next_;
+        delete entry;
+        entry = next;
+      }
+    }
+  }
+
+  void
+  message_pool::recycle(detail::pooled_message_entry* entry)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    detail::pooled_message_entry*& head = idle_entries_[entry->message_.instruction()];
+    entry->next_ = head;
+    head = entry;
+  }
+
+}
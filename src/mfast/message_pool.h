@@ -0,0 +1,181 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef MESSAGE_POOL_H_W3KQ8ZPD
+#define MESSAGE_POOL_H_W3KQ8ZPD
+
+#include "mfast/composite_type.h"
+#include "mfast/malloc_allocator.h"
+#include <boost/container/flat_map.hpp>
+#include <atomic>
+#include <mutex>
+
+namespace mfast {
+
+  class message_pool;
+
+  namespace detail {
+
+    struct pooled_message_entry
+    {
+      pooled_message_entry(mfast::allocator*           alloc,
+                           const template_instruction* instruction,
+                           message_pool*               pool)
+        : message_(alloc, instruction)
+        , ref_count_(0)
+        , pool_(pool)
+        , next_(0)
+      {
+      }
+
+      message_type message_;
+      std::atomic<long> ref_count_;
+      message_pool* pool_;
+      pooled_message_entry* next_;
+    };
+
+  }
+
+  /// A reference counted handle to a message owned by a message_pool.
+  ///
+  /// Copies of a handle share the same message, which goes back to its pool when the last
+  /// handle is destroyed. Handles to the same message can be copied and destroyed by different
+  /// threads concurrently; the access to the message itself is not synchronized.
+  class MFAST_EXPORT pooled_message
+  {
+  public:
+    pooled_message()
+      : entry_(0)
+    {
+    }
+
+    pooled_message(const pooled_message& other)
+      : entry_(other.entry_)
+    {
+      if (entry_)
+        entry_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    pooled_message(pooled_message&& other) BOOST_NOEXCEPT
+      : entry_(other.entry_)
+    {
+      other.entry_ = 0;
+    }
+
+    ~pooled_message()
+    {
+      reset();
+    }
+
+    pooled_message& operator = (pooled_message other) BOOST_NOEXCEPT
+    {
+      std::swap(entry_, other.entry_);
+      return *this;
+    }
+
+    /// Release the message; it goes back to the pool if this is the last handle to it.
+    void reset();
+
+    bool empty() const
+    {
+      return entry_ == 0;
+    }
+
+    /// Returns the number of handles sharing the message.
+    long use_count() const
+    {
+      return entry_ ? entry_->ref_count_.load(std::memory_order_relaxed) : 0;
+    }
+
+    message_cref cref() const
+    {
+      assert(entry_);
+      return entry_->message_.cref();
+    }
+
+    message_mref mref() const
+    {
+      assert(entry_);
+      return entry_->message_.mref();
+    }
+
+  private:
+    friend class message_pool;
+
+    explicit pooled_message(detail::pooled_message_entry* entry)
+      : entry_(entry)
+    {
+      entry_->ref_count_.store(1, std::memory_order_relaxed);
+    }
+
+    detail::pooled_message_entry* entry_;
+  };
+
+  /// A pool which recycles message_type objects per template.
+  ///
+  /// copy() is the recycling counterpart of <tt>message_type(msg, alloc)</tt>: the returned
+  /// message is a deep copy of @a msg which no longer refers to the decoder, so it can be
+  /// handed to other threads. The message is taken from the idle messages of the same template
+  /// when there is one, and the copy reuses the string, byte vector and sequence buffers the
+  /// message has grown in earlier uses. Thus, once the pool has warmed up, copying a message
+  /// whose fields are not longer than before makes no allocation.
+  ///
+  /// The pool must outlive all the handles it has given out. @a alloc must be thread safe when
+  /// copy() is called from more than one thread.
+  class MFAST_EXPORT message_pool
+  {
+  public:
+    explicit message_pool(mfast::allocator* alloc = malloc_allocator::instance());
+    ~message_pool();
+
+    /// Returns a pooled deep copy of @a msg.
+    pooled_message copy(const message_cref& msg);
+
+    /// Returns the number of idle messages kept for the template @a instruction.
+    std::size_t idle_count(const template_instruction* instruction) const;
+
+    /// Destroy all the idle messages.
+    void clear();
+
+  private:
+    message_pool(const message_pool&);
+    message_pool& operator = (const message_pool&);
+
+    friend class pooled_message;
+    void recycle(detail::pooled_message_entry* entry);
+
+    typedef boost::container::flat_map<const template_instruction*, detail::pooled_message_entry*> idle_map_t;
+
+    mfast::allocator* alloc_;
+    mutable std::mutex mutex_;
+    idle_map_t idle_entries_;
+  };
+
+  inline void
+  pooled_message::reset()
+  {
+    if (entry_) {
+      if (entry_->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        entry_->pool_->recycle(entry_);
+      entry_ = 0;
+    }
+  }
+
+}
+
+#endif /* end of include guard: MESSAGE_POOL_H_W3KQ8ZPD */
@@ -0,0 +1,214 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "message_snapshot.h"
+#include "aggregate_ref.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace mfast {
+
+  namespace detail {
+
+    struct snapshot_header
+    {
+      std::atomic<long> ref_count_;
+      const template_instruction* instruction_;
+      std::size_t size_;
+      value_storage storage_;
+    };
+
+  }
+
+  namespace {
+
+    inline std::size_t aligned(std::size_t n)
+    {
+      return (n + 15) & ~static_cast<std::size_t>(15);
+    }
+
+    // Hands out the memory of a preallocated block; nothing is freed individually.
+    class snapshot_allocator
+      : public allocator
+    {
+    public:
+      snapshot_allocator(char* begin, char* end)
+        : next_(begin)
+        , end_(end)
+      {
+      }
+
+      virtual void* allocate(std::size_t n)
+      {
+        n = aligned(n);
+        if (n > static_cast<std::size_t>(end_ - next_))
+          throw std::bad_alloc();
+        void* result = next_;
+        next_ += n;
+        return result;
+      }
+
+      virtual std::size_t reallocate(void*& pointer, std::size_t old_size, std::size_t new_size)
+      {
+        void* new_ptr = allocate(new_size);
+        if (pointer)
+          std::memcpy(new_ptr, pointer, old_size);
+        pointer = new_ptr;
+        return aligned(new_size);
+      }
+
+      virtual void deallocate(void*, std::size_t)
+      {
+      }
+
+    private:
+      char* next_;
+      char* end_;
+    };
+
+    std::size_t subfields_bound(const group_field_instruction* instruction,
+                                const value_storage*           fields);
+
+    // Returns an upper bound of the memory copy_construct_value() allocates for the value.
+    std::size_t value_bound(const field_instruction* instruction,
+                            const value_storage&     storage)
+    {
+      switch (instruction->field_type())
+      {
+      case field_type_ascii_string:
+      case field_type_unicode_string:
+      case field_type_byte_vector:
+      case field_type_int32_vector:
+      case field_type_uint32_vector:
+      case field_type_int64_vector:
+      case field_type_uint64_vector:
+        return aligned(storage.of_array.len_ *
+                       static_cast<const vector_field_instruction_base*>(instruction)->element_size());
+      case field_type_sequence:
+        {
+          const sequence_field_instruction* inst = static_cast<const sequence_field_instruction*>(instruction);
+          std::size_t length = storage.array_length();
+          std::size_t result = aligned(length * inst->group_content_byte_count());
+          const value_storage* elements = static_cast<const value_storage*>(storage.of_array.content_);
+          for (std::size_t i = 0; i < length; ++i)
+            result += subfields_bound(inst, elements + i * inst->subinstructions().size());
+          return result;
+        }
+      case field_type_group:
+      case field_type_template:
+        {
+          const group_field_instruction* inst = static_cast<const group_field_instruction*>(instruction);
+          return aligned(inst->group_content_byte_count()) + subfields_bound(inst, storage.group_content());
+        }
+      case field_type_templateref:
+        {
+          const template_instruction* inst = storage.of_templateref.of_instruction.instruction_;
+          if (inst == 0)
+            return 0;
+          return aligned(inst->group_content_byte_count()) + subfields_bound(inst, storage.of_templateref.content_);
+        }
+      default:
+        return 0;
+      }
+    }
+
+    std::size_t subfields_bound(const group_field_instruction* instruction,
+                                const value_storage*           fields)
+    {
+      std::size_t result = 0;
+      const instructions_view_t& subinstructions = instruction->subinstructions();
+      for (std::size_t i = 0; i < subinstructions.size(); ++i)
+        result += value_bound(subinstructions[i], fields[i]);
+      return result;
+    }
+
+  }
+
+  message_snapshot::message_snapshot(const message_cref& msg)
+  {
+    const template_instruction* instruction = msg.instruction();
+    const value_storage* fields = aggregate_cref_core_access::storage_of(msg);
+
+    std::size_t header_size = aligned(sizeof(detail::snapshot_header));
+    std::size_t size = header_size +
+                       aligned(instruction->group_content_byte_count()) +
+                       subfields_bound(instruction, fields);
+
+    char* block = static_cast<char*>(std::malloc(size));
+    if (block == 0)
+      throw std::bad_alloc();
+
+    header_ = new (block) detail::snapshot_header;
+    header_->ref_count_.store(1, std::memory_order_relaxed);
+    header_->instruction_ = instruction;
+    header_->size_ = size;
+
+    snapshot_allocator alloc(block + header_size, block + size);
+    value_storage src;
+    src.of_group.content_ = const_cast<value_storage*>(fields);
+    try {
+      instruction->copy_construct_value(src, header_->storage_, &alloc);
+    }
+    catch (...) {
+      header_->~snapshot_header();
+      std::free(block);
+      throw;
+    }
+  }
+
+  message_snapshot::message_snapshot(const message_snapshot& other)
+    : header_(other.header_)
+  {
+    if (header_)
+      header_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void
+  message_snapshot::reset()
+  {
+    if (header_) {
+      if (header_->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // all the memory of the message is in the block, so the fields need no destruction
+        header_->~snapshot_header();
+        std::free(header_);
+      }
+      header_ = 0;
+    }
+  }
+
+  long
+  message_snapshot::use_count() const
+  {
+    return header_ ? header_->ref_count_.load(std::memory_order_relaxed) : 0;
+  }
+
+  message_cref
+  message_snapshot::cref() const
+  {
+    assert(header_);
+    return message_cref(header_->storage_.of_group.content_, header_->instruction_);
+  }
+
+  std::size_t
+  message_snapshot::size() const
+  {
+    return header_ ? header_->size_ : 0;
+  }
+
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef MESSAGE_SNAPSHOT_H_K2VF9WJS
+#define MESSAGE_SNAPSHOT_H_K2VF9WJS
+
+#include "mfast/message_ref.h"
+#include <atomic>
+
+namespace mfast {
+
+  namespace detail {
+    struct snapshot_header;
+  }
+
+  /// An immutable, reference counted deep copy of a message held in a single allocation.
+  ///
+  /// Freezing a decoded message once lets any number of threads read it through cref(),
+  /// instead of copying it for every consumer. Copies of a snapshot share the same memory,
+  /// which is freed when the last copy is destroyed; they can be copied and destroyed by
+  /// different threads concurrently.
+  class MFAST_EXPORT message_snapshot
+  {
+  public:
+    message_snapshot()
+      : header_(0)
+    {
+    }
+
+    /// Freeze a deep copy of @a msg.
+    explicit message_snapshot(const message_cref& msg);
+
+    message_snapshot(const message_snapshot& other);
+
+    message_snapshot(message_snapshot&& other) BOOST_NOEXCEPT
+      : header_(other.header_)
+    {
+      other.header_ = 0;
+    }
+
+    ~message_snapshot()
+    {
+      reset();
+    }
+
+    message_snapshot& operator = (message_snapshot other) BOOST_NOEXCEPT
+    {
+      std::swap(header_, other.header_);
+      return *this;
+    }
+
+    /// Release this reference; the memory is freed if it is the last one.
+    void reset();
+
+    bool empty() const
+    {
+      return header_ == 0;
+    }
+
+    /// Returns the number of snapshots sharing the memory.
+    long use_count() const;
+
+    message_cref cref() const;
+
+    /// Returns the backing allocation.
+    const void* data() const
+    {
+      return header_;
+    }
+
+    /// Returns the number of bytes of the backing allocation.
+    std::size_t size() const;
+
+  private:
+    detail::snapshot_header* header_;
+  };
+
+}
+
+#endif /* end of include guard: MESSAGE_SNAPSHOT_H_K2VF9WJS */
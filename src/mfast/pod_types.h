@@ -0,0 +1,148 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef POD_TYPES_H_W7KD3MQA
+#define POD_TYPES_H_W7KD3MQA
+
+#include "mfast/decimal_ref.h"
+#include "mfast/string_ref.h"
+#include "mfast/vector_ref.h"
+#include "mfast/message_ref.h"
+#include <boost/throw_exception.hpp>
+#include <stdexcept>
+#include <cstring>
+
+namespace mfast {
+
+  // The building blocks of the plain structs fast_type_gen emits for the templates whose
+  // strings, byte vectors and sequences are bounded by an mfast:maxLength attribute.
+  // They are trivially copyable and hold their content inline. fast_pod_decoder and
+  // fast_pod_encoder code them straight from and to the FAST stream; load() and store()
+  // convert them from and to the message types.
+
+  struct pod_decimal
+  {
+    int64_t mantissa;
+    // FAST limits exponents to [-63, 63]
+    int8_t exponent;
+  };
+
+  template <std::size_t N>
+  struct pod_string
+  {
+    uint32_t length;
+    char data[N];
+
+    boost::string_ref value() const
+    {
+      return boost::string_ref(data, length);
+    }
+
+  };
+
+  template <typename T, std::size_t N>
+  struct pod_array
+  {
+    uint32_t size;
+    T elements[N];
+
+    static std::size_t capacity()
+    {
+      return N;
+    }
+
+  };
+
+  namespace detail {
+
+    inline void check_pod_capacity(std::size_t size, std::size_t capacity, const char* name)
+    {
+      if (size > capacity) {
+        std::string msg("the value exceeds the maxLength of field ");
+        msg += name;
+        BOOST_THROW_EXCEPTION(std::length_error(msg));
+      }
+    }
+
+  }
+
+  inline void pod_load(const decimal_cref& ref, pod_decimal& pod)
+  {
+    pod.mantissa = ref.mantissa();
+    pod.exponent = static_cast<int8_t>(ref.exponent());
+  }
+
+  inline void pod_store(const pod_decimal& pod, const decimal_mref& ref)
+  {
+    ref.as(pod.mantissa, pod.exponent);
+  }
+
+  /// @throw std::length_error if the string is longer than N.
+  template <std::size_t N, typename Instruction>
+  void pod_load(const string_cref_base<Instruction>& ref, pod_string<N>& pod)
+  {
+    detail::check_pod_capacity(ref.size(), N, ref.name());
+    pod.length = static_cast<uint32_t>(ref.size());
+    std::memcpy(pod.data, ref.data(), ref.size());
+  }
+
+  template <std::size_t N, typename T>
+  void pod_store(const pod_string<N>& pod, const string_mref_base<T>& ref)
+  {
+    ref.as(pod.value());
+  }
+
+  /// @throw std::length_error if the byte vector is longer than N.
+  template <std::size_t N>
+  void pod_load(const byte_vector_cref& ref, pod_array<unsigned char, N>& pod)
+  {
+    detail::check_pod_capacity(ref.size(), N, ref.name());
+    pod.size = static_cast<uint32_t>(ref.size());
+    std::memcpy(pod.elements, ref.data(), ref.size());
+  }
+
+  template <std::size_t N>
+  void pod_store(const pod_array<unsigned char, N>& pod, const byte_vector_mref& ref)
+  {
+    ref.assign(pod.elements, pod.elements + pod.size);
+  }
+
+  /// Loads the elements of a sequence with the load() member of the element structs.
+  ///
+  /// @throw std::length_error if the sequence has more than N elements.
+  template <typename SequenceCRef, typename T, std::size_t N>
+  void pod_load_sequence(const SequenceCRef& ref, pod_array<T, N>& pod)
+  {
+    detail::check_pod_capacity(ref.size(), N, ref.name());
+    pod.size = ref.size();
+    for (uint32_t i = 0; i < pod.size; ++i)
+      pod.elements[i].load(ref[i]);
+  }
+
+  /// Stores the elements of a sequence with the store() member of the element structs.
+  template <typename SequenceMRef, typename T, std::size_t N>
+  void pod_store_sequence(const pod_array<T, N>& pod, const SequenceMRef& ref)
+  {
+    ref.resize(pod.size);
+    for (uint32_t i = 0; i < pod.size; ++i)
+      pod.elements[i].store(ref[i]);
+  }
+
+}
+
+#endif /* end of include guard: POD_TYPES_H_W7KD3MQA */
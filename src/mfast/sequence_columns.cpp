@@ -0,0 +1,185 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "sequence_columns.h"
+#include <boost/exception/all.hpp>
+#include <cstring>
+#include <stdexcept>
+
+namespace mfast {
+
+  namespace {
+
+    template <typename T>
+    void extract_integers(const value_storage* fields,
+                          std::size_t          stride,
+                          std::size_t          n,
+                          int64_t*             values)
+    {
+      for (std::size_t i = 0; i < n; ++i) {
+        const value_storage& v = fields[i*stride];
+        values[i] = v.of_uint64.present_ ? static_cast<int64_t>(v.get<T>()) : 0;
+      }
+    }
+
+    void extract_decimals(const value_storage* fields,
+                          std::size_t          stride,
+                          std::size_t          n,
+                          int64_t*             mantissas,
+                          int16_t*             exponents)
+    {
+      for (std::size_t i = 0; i < n; ++i) {
+        const value_storage& v = fields[i*stride];
+        bool present = v.of_decimal.present_ != 0;
+        mantissas[i] = present ? v.of_decimal.mantissa_ : 0;
+        exponents[i] = present ? v.of_decimal.exponent_ : 0;
+      }
+    }
+
+    void extract_presence(const value_storage* fields,
+                          std::size_t          stride,
+                          std::size_t          n,
+                          uint8_t*             present)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        present[i] = fields[i*stride].of_array.len_ != 0;
+    }
+
+    std::size_t string_size(const value_storage* fields,
+                            std::size_t          stride,
+                            std::size_t          n)
+    {
+      std::size_t result = 0;
+      for (std::size_t i = 0; i < n; ++i)
+        result += fields[i*stride].array_length();
+      return result;
+    }
+
+    void extract_strings(const value_storage* fields,
+                         std::size_t          stride,
+                         std::size_t          n,
+                         uint32_t*            offsets,
+                         char*                data)
+    {
+      uint32_t offset = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        const value_storage& v = fields[i*stride];
+        uint32_t len = v.array_length();
+        std::memcpy(data + offset, v.array_content(), len);
+        offsets[i] = offset;
+        offset += len;
+      }
+      offsets[n] = offset;
+    }
+
+    bool is_string(field_type_enum_t type)
+    {
+      return type == field_type_ascii_string ||
+             type == field_type_unicode_string ||
+             type == field_type_byte_vector;
+    }
+
+    void throw_mismatch(const field_instruction* inst)
+    {
+      std::string msg("the column doesn't match the type of field ");
+      msg += inst->name();
+      BOOST_THROW_EXCEPTION(std::invalid_argument(msg));
+    }
+
+  }
+
+  sequence_column_extractor::sequence_column_extractor(const sequence_field_instruction* instruction)
+    : instruction_(instruction)
+  {
+  }
+
+  std::size_t
+  sequence_column_extractor::field_index(const char* name) const
+  {
+    int index = instruction_->find_subinstruction_index_by_name(name);
+    if (index < 0) {
+      std::string msg("no sequence element field named ");
+      msg += name;
+      BOOST_THROW_EXCEPTION(std::invalid_argument(msg));
+    }
+    return index;
+  }
+
+  std::size_t
+  sequence_column_extractor::string_data_size(const sequence_cref& seq, std::size_t field_index) const
+  {
+    const value_storage* elements =
+      static_cast<const value_storage*>(field_cref_core_access::storage_of(seq)->of_array.content_);
+    return string_size(elements + field_index, instruction_->subinstructions().size(), seq.size());
+  }
+
+  void
+  sequence_column_extractor::extract(const sequence_cref&   seq,
+                                     const sequence_column* columns,
+                                     std::size_t            num_columns) const
+  {
+    const value_storage* elements =
+      static_cast<const value_storage*>(field_cref_core_access::storage_of(seq)->of_array.content_);
+    const std::size_t stride = instruction_->subinstructions().size();
+    const std::size_t n = seq.size();
+
+    for (std::size_t c = 0; c < num_columns; ++c) {
+      const sequence_column& column = columns[c];
+      const field_instruction* inst = instruction_->subinstruction(column.field_index_);
+      const value_storage* fields = elements + column.field_index_;
+
+      switch (column.kind_) {
+      case sequence_column::integer_column:
+        switch (inst->field_type()) {
+        case field_type_int32:
+          extract_integers<int32_t>(fields, stride, n, column.values_);
+          break;
+        case field_type_uint32:
+          extract_integers<uint32_t>(fields, stride, n, column.values_);
+          break;
+        case field_type_int64:
+          extract_integers<int64_t>(fields, stride, n, column.values_);
+          break;
+        case field_type_uint64:
+        case field_type_enum:
+          extract_integers<uint64_t>(fields, stride, n, column.values_);
+          break;
+        default:
+          throw_mismatch(inst);
+        }
+        break;
+      case sequence_column::decimal_column:
+        if (inst->field_type() != field_type_decimal && inst->field_type() != field_type_exponent)
+          throw_mismatch(inst);
+        extract_decimals(fields, stride, n, column.values_, column.exponents_);
+        break;
+      case sequence_column::string_column:
+        if (!is_string(inst->field_type()))
+          throw_mismatch(inst);
+        if (string_size(fields, stride, n) > column.data_capacity_)
+          BOOST_THROW_EXCEPTION(std::length_error("insufficient string column capacity"));
+        extract_strings(fields, stride, n, column.offsets_, column.data_);
+        break;
+      }
+
+      if (column.present_)
+        extract_presence(fields, stride, n, column.present_);
+    }
+  }
+
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef SEQUENCE_COLUMNS_H_B5WN8QLE
+#define SEQUENCE_COLUMNS_H_B5WN8QLE
+
+#include "mfast/sequence_ref.h"
+
+namespace mfast {
+
+  /// The caller provided arrays one field of a sequence element is extracted into; every
+  /// array holds an entry per element, except that @a offsets holds one more.
+  class sequence_column
+  {
+  public:
+    enum kind_t {
+      integer_column,
+      decimal_column,
+      string_column
+    };
+
+    /// A column of an integer or enum field.
+    static sequence_column integers(std::size_t field_index, int64_t* values, uint8_t* present = 0)
+    {
+      sequence_column result(integer_column, field_index, present);
+      result.values_ = values;
+      return result;
+    }
+
+    /// A column of a decimal field, as mantissas and exponents.
+    static sequence_column decimals(std::size_t field_index,
+                                    int64_t*    mantissas,
+                                    int16_t*    exponents,
+                                    uint8_t*    present = 0)
+    {
+      sequence_column result(decimal_column, field_index, present);
+      result.values_ = mantissas;
+      result.exponents_ = exponents;
+      return result;
+    }
+
+    /// A column of a string or byte vector field. The values are concatenated in @a data;
+    /// the value of element i is [data + offsets[i], data + offsets[i+1]).
+    static sequence_column strings(std::size_t field_index,
+                                   uint32_t*   offsets,
+                                   char*       data,
+                                   std::size_t data_capacity,
+                                   uint8_t*    present = 0)
+    {
+      sequence_column result(string_column, field_index, present);
+      result.offsets_ = offsets;
+      result.data_ = data;
+      result.data_capacity_ = data_capacity;
+      return result;
+    }
+
+  private:
+    friend class sequence_column_extractor;
+
+    sequence_column(kind_t kind, std::size_t field_index, uint8_t* present)
+      : kind_(kind)
+      , field_index_(field_index)
+      , present_(present)
+      , values_(0)
+      , exponents_(0)
+      , offsets_(0)
+      , data_(0)
+      , data_capacity_(0)
+    {
+    }
+
+    kind_t kind_;
+    std::size_t field_index_;
+    uint8_t* present_;
+    int64_t* values_;
+    int16_t* exponents_;
+    uint32_t* offsets_;
+    char* data_;
+    std::size_t data_capacity_;
+  };
+
+  /// Extracts fields of the elements of a sequence into contiguous arrays, a column per field,
+  /// instead of visiting the sequence element by element.
+  ///
+  /// Each column is filled by a loop specialized for the field type, which reads the field
+  /// at a fixed stride from the element storage. Absent values are extracted as zero, or as
+  /// empty strings, and flagged by 0 in the optional @a present array.
+  class MFAST_EXPORT sequence_column_extractor
+  {
+  public:
+    explicit sequence_column_extractor(const sequence_field_instruction* instruction);
+
+    /// Returns the index of the element field named @a name, to be passed to sequence_column.
+    ///
+    /// @throw std::invalid_argument if there's no such field.
+    std::size_t field_index(const char* name) const;
+
+    /// Returns the number of bytes the string column of @a field_index needs for @a seq.
+    std::size_t string_data_size(const sequence_cref& seq, std::size_t field_index) const;
+
+    /// Fills @a columns with the elements of @a seq.
+    ///
+    /// @throw std::invalid_argument if a column doesn't match the type of its field.
+    /// @throw std::length_error if the data of a string column exceeds its capacity.
+    void extract(const sequence_cref&   seq,
+                 const sequence_column* columns,
+                 std::size_t            num_columns) const;
+
+  private:
+    const sequence_field_instruction* instruction_;
+  };
+
+}
+
+#endif /* end of include guard: SEQUENCE_COLUMNS_H_B5WN8QLE */
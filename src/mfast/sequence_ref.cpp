@@ -19,6 +19,7 @@
 #include "mfast/sequence_ref.h"
 #include "mfast/allocator.h"
 #include <limits>
+#include <cstring>
 
 namespace mfast {
   namespace detail {
@@ -39,9 +40,10 @@ namespace mfast {
       {
 
         std::size_t new_capacity =
-          alloc->reallocate (storage->of_array.content_,
-                             storage->of_array.capacity_in_bytes_,
-                             reserve_size);
+          reallocate_array (alloc,
+                            storage->of_array.content_,
+                            storage->of_array.capacity_in_bytes_,
+                            reserve_size);
 
         std::size_t old_num_elements = storage->of_array.capacity_in_bytes_/element_size;
         std::size_t new_num_elements = new_capacity/element_size;
@@ -55,9 +57,41 @@ namespace mfast {
         // It would cause differet value when either storage->of_array.capacity_in_bytes_
         // or new_capacity is not the multiple of element_size.
 
-        storage->of_array.capacity_in_bytes_ = static_cast<uint32_t>(new_capacity);
+        storage->of_array.capacity_in_bytes_ = new_capacity;
       }
     }
 
+    void sequence_mref_helper::shrink_to_fit(const sequence_field_instruction* instruction,
+                                             value_storage*                    storage,
+                                             allocator*                        alloc)
+    {
+      std::size_t element_size = instruction->group_content_byte_count ();
+      std::size_t capacity = storage->of_array.capacity_in_bytes_/element_size;
+      std::size_t size = storage->array_length();
+
+      if (size >= capacity)
+        return;
+
+      // Acquire and fill the new block before touching the old one, so that a throwing
+      // allocate() leaves the sequence exactly as it was.
+      void* new_content = 0;
+      if (size > 0) {
+        // The elements are moved bitwise, the same as reallocate() does when the sequence grows.
+        new_content = alloc->allocate(size*element_size);
+        std::memcpy(new_content, storage->of_array.content_, size*element_size);
+      }
+
+      instruction->destruct_sequence_elements (*storage, size, capacity - size, alloc);
+
+      void* old_content = storage->of_array.content_;
+      std::size_t old_capacity_in_bytes = storage->of_array.capacity_in_bytes_;
+
+      storage->of_array.content_ = new_content;
+      storage->of_array.capacity_in_bytes_ = array_capacity(size*element_size);
+
+      if (old_capacity_in_bytes)
+        alloc->deallocate(old_content, old_capacity_in_bytes);
+    }
+
   }
 }
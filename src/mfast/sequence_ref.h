@@ -445,6 +445,10 @@ namespace mfast {
                           value_storage*                    storage,
                           allocator*                        alloc,
                           std::size_t                       n);
+
+      static void shrink_to_fit(const sequence_field_instruction* instruction,
+                                value_storage*                    storage,
+                                allocator*                        alloc);
     };
 
   }
@@ -527,9 +531,26 @@ namespace mfast {
       return this->operator [] (this->size()-1);
     }
 
+    /// Change the number of elements.
+    ///
+    /// Elements removed by shrinking the sequence are not destructed; they are kept along
+    /// with the memory of their subfields and become visible again, with the values they
+    /// had, when the sequence grows. Thus, growing within capacity() never allocates memory.
+    ///
+    /// @throw std::length_error if the elements would take more than
+    ///        value_storage::max_array_capacity bytes; so does reserve().
     void resize(size_t n) const;
     void reserve(size_t n) const;
 
+    /// Returns the number of elements the sequence can hold without allocating memory.
+    size_t capacity() const
+    {
+      return this->storage()->of_array.capacity_in_bytes_/this->instruction()->group_content_byte_count();
+    }
+
+    /// Destruct the elements beyond size() and release the memory they occupy.
+    void shrink_to_fit() const;
+
 
     template <typename FieldMutator>
     void accept_mutator(FieldMutator&) const;
@@ -658,6 +679,13 @@ namespace mfast {
     detail::sequence_mref_helper::reserve(static_cast<const sequence_field_instruction*>(this->instruction()), this->storage(), this->alloc_, n);
   }
 
+  template <typename ElementType, typename SequenceTrait, typename SequenceInstructionType>
+  inline void
+  make_sequence_mref<ElementType, SequenceTrait, SequenceInstructionType>::shrink_to_fit() const
+  {
+    detail::sequence_mref_helper::shrink_to_fit(static_cast<const sequence_field_instruction*>(this->instruction()), this->storage(), this->alloc_);
+  }
+
   template <typename ElementType, typename SequenceTrait, typename SequenceInstructionType>
   inline void
   make_sequence_mref<ElementType, SequenceTrait, SequenceInstructionType>::as(const cref_type& src) const
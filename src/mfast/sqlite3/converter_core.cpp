@@ -182,7 +182,7 @@ namespace mfast
         bind(info, column, ref.mantissa());
       else
       {
-        double value = pow(10, ref.exponent()) * ref.mantissa();
+        double value = ref;
 
         info.binding_[column] = boost::lexical_cast<std::string>(value);
         if (sqlite3_bind_double(info.insert_stmt_, column, value)!= SQLITE_OK)
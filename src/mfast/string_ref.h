@@ -142,7 +142,7 @@ namespace mfast {
 
     const char* c_str() const
     {
-      if (this->storage()->of_array.capacity_in_bytes_ > 0) {
+      if (this->storage()->of_array.capacity_in_bytes_ > 0 || this->storage()->is_inline_array()) {
         const_cast<char&>(*this->end()) = '\0';
         return this->data();
       }
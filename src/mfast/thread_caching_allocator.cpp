@@ -0,0 +1,321 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "thread_caching_allocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <mutex>
+#include <vector>
+
+namespace mfast {
+
+  namespace {
+
+    const std::size_t num_size_classes = 13; // 16 bytes to 64K bytes
+
+    inline std::size_t size_class_of(std::size_t n)
+    {
+      std::size_t index = 0;
+      while ((static_cast<std::size_t>(thread_caching_allocator::min_block_size) << index) < n)
+        ++index;
+      return index;
+    }
+
+    inline std::size_t block_size_of(std::size_t index)
+    {
+      return static_cast<std::size_t>(thread_caching_allocator::min_block_size) << index;
+    }
+
+    struct magazine
+    {
+      std::size_t count_;
+      void* blocks_[thread_caching_allocator::magazine_capacity];
+
+      magazine()
+        : count_(0)
+      {
+      }
+
+      bool empty() const
+      {
+        return count_ == 0;
+      }
+
+      bool full() const
+      {
+        return count_ == thread_caching_allocator::magazine_capacity;
+      }
+
+      void release_blocks()
+      {
+        for (std::size_t i = 0; i < count_; ++i)
+          std::free(blocks_[i]);
+        count_ = 0;
+      }
+
+    };
+
+    class depot
+    {
+    public:
+      ~depot()
+      {
+        for (std::size_t i = 0; i < num_size_classes; ++i) {
+          for (std::size_t j = 0; j < full_[i].size(); ++j) {
+            full_[i][j]->release_blocks();
+            delete full_[i][j];
+          }
+          for (std::size_t j = 0; j < empty_[i].size(); ++j)
+            delete empty_[i][j];
+        }
+      }
+
+      // Exchange an empty magazine for a full one; returns 0 if there's no full magazine.
+      magazine* exchange_empty(std::size_t index, magazine* mag)
+      {
+        std::lock_guard<std::mutex> lock(mutex_[index]);
+        if (full_[index].empty())
+          return 0;
+        magazine* result = full_[index].back();
+        full_[index].pop_back();
+        empty_[index].push_back(mag);
+        return result;
+      }
+
+      // Exchange a full magazine for an empty one.
+      magazine* exchange_full(std::size_t index, magazine* mag)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex_[index]);
+          if (full_[index].size() < thread_caching_allocator::max_depot_magazines) {
+            full_[index].push_back(mag);
+            if (empty_[index].empty())
+              return new magazine;
+            magazine* result = empty_[index].back();
+            empty_[index].pop_back();
+            return result;
+          }
+        }
+        // the depot is at its capacity
+        mag->release_blocks();
+        return mag;
+      }
+
+      void give_back(std::size_t index, magazine* mag)
+      {
+        if (mag->empty()) {
+          delete mag;
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_[index]);
+          if (full_[index].size() < thread_caching_allocator::max_depot_magazines) {
+            full_[index].push_back(mag);
+            return;
+          }
+        }
+        mag->release_blocks();
+        delete mag;
+      }
+
+    private:
+      std::mutex mutex_[num_size_classes];
+      std::vector<magazine*> full_[num_size_classes];
+      std::vector<magazine*> empty_[num_size_classes];
+    };
+
+    depot& global_depot()
+    {
+      static depot instance;
+      return instance;
+    }
+
+    struct thread_cache
+    {
+      magazine* loaded_[num_size_classes];
+      magazine* previous_[num_size_classes];
+      // set once the cache has been destroyed; the destructors of other
+      // thread_local and static objects may still free blocks afterwards
+      bool torn_down_;
+
+      thread_cache()
+        : torn_down_(false)
+      {
+        // make sure the depot outlives the caches of all threads
+        global_depot();
+        for (std::size_t i = 0; i < num_size_classes; ++i) {
+          loaded_[i] = 0;
+          previous_[i] = 0;
+        }
+      }
+
+      ~thread_cache()
+      {
+        depot& d = global_depot();
+        for (std::size_t i = 0; i < num_size_classes; ++i) {
+          if (loaded_[i])
+            d.give_back(i, loaded_[i]);
+          if (previous_[i])
+            d.give_back(i, previous_[i]);
+          loaded_[i] = 0;
+          previous_[i] = 0;
+        }
+        torn_down_ = true;
+      }
+
+      void* allocate(std::size_t index)
+      {
+        if (torn_down_) {
+          void* result = std::malloc(block_size_of(index));
+          if (result == 0)
+            throw std::bad_alloc();
+          return result;
+        }
+
+        magazine*& loaded = loaded_[index];
+        magazine*& previous = previous_[index];
+
+        if (loaded == 0) {
+          loaded = new magazine;
+          previous = new magazine;
+        }
+
+        if (loaded->empty()) {
+          if (!previous->empty()) {
+            std::swap(loaded, previous);
+          }
+          else {
+            magazine* mag = global_depot().exchange_empty(index, loaded);
+            if (mag == 0) {
+              void* result = std::malloc(block_size_of(index));
+              if (result == 0)
+                throw std::bad_alloc();
+              return result;
+            }
+            loaded = mag;
+          }
+        }
+        return loaded->blocks_[--loaded->count_];
+      }
+
+      void deallocate(std::size_t index, void* pointer)
+      {
+        if (torn_down_) {
+          std::free(pointer);
+          return;
+        }
+
+        magazine*& loaded = loaded_[index];
+        magazine*& previous = previous_[index];
+
+        if (loaded == 0) {
+          loaded = new magazine;
+          previous = new magazine;
+        }
+
+        if (loaded->full()) {
+          if (!previous->full()) {
+            std::swap(loaded, previous);
+          }
+          else {
+            previous = global_depot().exchange_full(index, previous);
+            std::swap(loaded, previous);
+          }
+        }
+        loaded->blocks_[loaded->count_++] = pointer;
+      }
+
+    };
+
+    thread_local thread_cache local_cache;
+  }
+
+  thread_caching_allocator*
+  thread_caching_allocator::instance()
+  {
+    static thread_caching_allocator alloc;
+    return &alloc;
+  }
+
+  void*
+  thread_caching_allocator::allocate(std::size_t n)
+  {
+    if (n > max_block_size) {
+      void* pointer = std::malloc(n);
+      if (pointer == 0) throw std::bad_alloc();
+      return pointer;
+    }
+    return local_cache.allocate(size_class_of(n));
+  }
+
+  std::size_t
+  thread_caching_allocator::reallocate(void*&      pointer,
+                                       std::size_t old_size,
+                                       std::size_t new_size)
+  {
+    if (new_size > max_block_size) {
+      // make the new_size at least 64 bytes
+      new_size = std::max<std::size_t>(2*new_size, 64) & (~63);
+      if (old_size > max_block_size) {
+        void* old_ptr = pointer;
+        pointer = std::realloc(pointer, new_size);
+        if (pointer == 0) {
+          std::free(old_ptr);
+          throw std::bad_alloc();
+        }
+        return new_size;
+      }
+      void* new_ptr = std::malloc(new_size);
+      if (new_ptr == 0) throw std::bad_alloc();
+      if (pointer) {
+        std::memcpy(new_ptr, pointer, old_size);
+        deallocate(pointer, old_size);
+      }
+      pointer = new_ptr;
+      return new_size;
+    }
+
+    std::size_t index = size_class_of(std::max<std::size_t>(new_size, 64));
+    std::size_t capacity = block_size_of(index);
+    if (pointer && old_size >= capacity)
+      return old_size;
+
+    void* new_ptr = local_cache.allocate(index);
+    if (pointer) {
+      std::memcpy(new_ptr, pointer, old_size);
+      deallocate(pointer, old_size);
+    }
+    pointer = new_ptr;
+    return capacity;
+  }
+
+  void
+  thread_caching_allocator::deallocate(void* pointer, std::size_t n)
+  {
+    if (pointer == 0)
+      return;
+
+    if (n > max_block_size) {
+      std::free(pointer);
+      return;
+    }
+    local_cache.deallocate(size_class_of(n), pointer);
+  }
+
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef THREAD_CACHING_ALLOCATOR_H_R6TB2XKD
+#define THREAD_CACHING_ALLOCATOR_H_R6TB2XKD
+#include "allocator.h"
+
+namespace mfast {
+
+  /// An allocator which caches freed memory blocks per thread.
+  ///
+  /// Block sizes are rounded up to a power of 2 between min_block_size and max_block_size;
+  /// larger blocks are obtained from malloc() directly. Every thread keeps, for each size class,
+  /// two magazines of up to magazine_capacity blocks. When both are full, one of them is handed
+  /// to a global depot as a whole, where other threads pick it up once their own magazines run
+  /// dry. Thus, blocks freed by a thread other than the allocating one flow back in batches, and
+  /// the lock of the depot is only taken once every magazine_capacity operations. The depot keeps
+  /// at most max_depot_magazines magazines per size class, the surplus is returned to the system.
+  ///
+  /// This is a drop-in replacement of malloc_allocator for messages owned by several threads.
+  class MFAST_EXPORT thread_caching_allocator
+    : public allocator
+  {
+  public:
+    enum {
+      min_block_size = 16,
+      max_block_size = 64*1024,
+      magazine_capacity = 64,
+      max_depot_magazines = 64
+    };
+
+    static thread_caching_allocator* instance();
+
+    virtual void* allocate(std::size_t n);
+    virtual std::size_t reallocate(void*& pointer, std::size_t old_size, std::size_t new_size);
+    virtual void deallocate(void* pointer, std::size_t n);
+  };
+
+}
+
+#endif /* end of include guard: THREAD_CACHING_ALLOCATOR_H_R6TB2XKD */
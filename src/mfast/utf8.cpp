@@ -0,0 +1,105 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "utf8.h"
+#include <cstring>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MFAST_UTF8_SSE2
+#endif
+
+namespace mfast {
+
+  namespace {
+
+    // returns the first byte of [first, last) that is not ASCII, or last
+    inline const unsigned char* skip_ascii(const unsigned char* first, const unsigned char* last)
+    {
+#ifdef MFAST_UTF8_SSE2
+      for (; last - first >= 16; first += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        if (_mm_movemask_epi8(block))
+          break;
+      }
+#else
+      for (; last - first >= 8; first += 8) {
+        uint64_t word;
+        std::memcpy(&word, first, 8);
+        if (word & 0x8080808080808080ULL)
+          break;
+      }
+#endif
+      while (first != last && *first < 0x80)
+        ++first;
+      return first;
+    }
+
+    inline bool is_continuation(unsigned char c)
+    {
+      return (c & 0xC0) == 0x80;
+    }
+
+  }
+
+  bool is_valid_utf8(const char* str, std::size_t len)
+  {
+    const unsigned char* first = reinterpret_cast<const unsigned char*>(str);
+    const unsigned char* last = first + len;
+
+    for (;;) {
+      first = skip_ascii(first, last);
+      if (first == last)
+        return true;
+
+      unsigned char c = *first;
+      std::ptrdiff_t avail = last - first;
+      if (c < 0xC2) {
+        // a continuation byte or the lead of an overlong two byte form
+        return false;
+      }
+      else if (c < 0xE0) {
+        if (avail < 2 || !is_continuation(first[1]))
+          return false;
+        first += 2;
+      }
+      else if (c < 0xF0) {
+        // E0 must not be overlong, ED must not encode a surrogate
+        unsigned char lower = (c == 0xE0) ? 0xA0 : 0x80;
+        unsigned char upper = (c == 0xED) ? 0x9F : 0xBF;
+        if (avail < 3 || first[1] < lower || first[1] > upper || !is_continuation(first[2]))
+          return false;
+        first += 3;
+      }
+      else if (c < 0xF5) {
+        // F0 must not be overlong, F4 must not exceed U+10FFFF
+        unsigned char lower = (c == 0xF0) ? 0x90 : 0x80;
+        unsigned char upper = (c == 0xF4) ? 0x8F : 0xBF;
+        if (avail < 4 || first[1] < lower || first[1] > upper ||
+            !is_continuation(first[2]) || !is_continuation(first[3]))
+          return false;
+        first += 4;
+      }
+      else {
+        return false;
+      }
+    }
+  }
+
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef UTF8_H_R2PX8KNE
+#define UTF8_H_R2PX8KNE
+
+#include "mfast/mfast_export.h"
+#include <cstddef>
+
+namespace mfast {
+
+  /// Returns whether [str, str+len) is a well-formed UTF-8 sequence as defined by table 3-7
+  /// of the Unicode standard; overlong forms, surrogates and code points above U+10FFFF are
+  /// rejected.
+  ///
+  /// Runs of ASCII characters are skipped 16 bytes at a time with SSE2 where available, or a
+  /// word at a time otherwise; only the multibyte characters are examined one by one.
+  MFAST_EXPORT bool is_valid_utf8(const char* str, std::size_t len);
+
+}
+
+#endif /* end of include guard: UTF8_H_R2PX8KNE */
@@ -21,9 +21,13 @@
 #define VALUE_STORAGE_H_OMNNMOZX
 
 #include "mfast/mfast_export.h"
+#include "mfast/allocator.h"
 #include <stdint.h>
 #include <cstring>
+#include <cstddef>
+#include <stdexcept>
 #include <boost/array.hpp>
+#include <boost/throw_exception.hpp>
 
 namespace mfast
 {
@@ -58,17 +62,25 @@ namespace mfast
       uint32_t present_;                ///< indicate if the value is present,
       uint32_t own_content_ : 1;        ///< indicate if \a content_ should be deallocated
       uint32_t is_link_ : 1;           ///< indicate wheter this is a link so that we shouldn't destruct subfields.
-      uint32_t padding_ : 29;
+      uint32_t is_offset_ : 1;         ///< indicate the subfields are located by \a content_offset_, in bytes
+                                       ///< relative to this object, rather than \a content_; used by flat_message.
+      uint32_t padding_ : 28;
       uint32_t defined_bit_ : 1;
-      value_storage* content_;
+      union {
+        value_storage* content_;
+        std::ptrdiff_t content_offset_;
+      };
     } of_group; ///< used for group or template
 
     struct {
       uint32_t len_; ///< the length+1 of content; it represents null value or content is absent when len==0.
                      /// In the case of empty string, len == 1 and content_[0]= '\0'.
-      uint32_t capacity_in_bytes_ : 31; ///< used to track the length of memory that has been reserved
+      uint32_t capacity_in_bytes_ : 30; ///< used to track the length of memory that has been reserved
                                         ///< for \a content_. if <tt>.capacity_in_bytes_ == 0</tt> and <tt>len_ > 0</tt>,
                                         ///< it means the object does not own the memory in \a content_.
+                                        ///< At most \a max_array_capacity, see reallocate_array().
+      uint32_t inline_ : 1;      ///< indicate the elements are stored in place of \a content_ rather than
+                                 ///< the memory \a content_ points to; \a capacity_in_bytes_ is 0 in this case.
       uint32_t defined_bit_ : 1; ///< used by FAST coder/encoder/decoder for tracking if a dictionary
                                  ///< value is defined or not.
       void* content_;
@@ -85,6 +97,16 @@ namespace mfast
     } of_templateref;
 
 
+    enum {
+      /// The number of bytes available for inline array elements, i.e. the \a content_ slot
+      /// of \a of_array plus the padding after it in 32 bits environments.
+      inline_array_capacity = 8,
+      /// The largest array, in bytes, whose capacity \a of_array can record; this is 1 GiB
+      /// less one byte since \a capacity_in_bytes_ shares its 32 bits with \a inline_ and
+      /// \a defined_bit_.
+      max_array_capacity = (1 << 30) - 1
+    };
+
     // construct an undefined value
     value_storage()
     {
@@ -107,6 +129,7 @@ namespace mfast
       of_array.content_ = const_cast<char*>("");
       of_array.len_ = 1;
       of_array.capacity_in_bytes_ = 0;
+      of_array.inline_ = 0;
       of_array.defined_bit_ = 1;
     };
 
@@ -140,6 +163,39 @@ namespace mfast
       of_array.len_ = n+1;
     }
 
+    bool is_inline_array() const
+    {
+      return of_array.inline_;
+    }
+
+    const void* array_content() const
+    {
+      if (of_array.inline_)
+        return &of_array.content_;
+      return of_array.content_;
+    }
+
+    void* array_content()
+    {
+      if (of_array.inline_)
+        return &of_array.content_;
+      return of_array.content_;
+    }
+
+    const value_storage* group_content() const
+    {
+      if (of_group.is_offset_)
+        return reinterpret_cast<const value_storage*>(reinterpret_cast<const char*>(this) + of_group.content_offset_);
+      return of_group.content_;
+    }
+
+    value_storage* group_content()
+    {
+      if (of_group.is_offset_)
+        return reinterpret_cast<value_storage*>(reinterpret_cast<char*>(this) + of_group.content_offset_);
+      return of_group.content_;
+    }
+
 #if SIZEOF_VOID_P == 4
     template <typename T>
     typename std::enable_if<!std::is_pointer<T>::value && sizeof(T)<=4, T>::type
@@ -166,7 +222,7 @@ namespace mfast
     typename std::enable_if< std::is_pointer<T>::value, T>::type
     get() const
     {
-      return reinterpret_cast<T>(of_array.content_);
+      return reinterpret_cast<T>(const_cast<void*>(array_content()));
     }
 
 #if SIZEOF_VOID_P == 4
@@ -343,6 +399,30 @@ namespace mfast
     const value_storage* data() const { return reinterpret_cast<const value_storage*>(this); }
   };
 
+  /// Returns @a bytes as the capacity of an array in value_storage::of_array.
+  ///
+  /// @throw std::length_error if @a bytes exceeds value_storage::max_array_capacity.
+  inline uint32_t array_capacity(std::size_t bytes)
+  {
+    if (bytes > value_storage::max_array_capacity)
+      BOOST_THROW_EXCEPTION(std::length_error("array exceeds value_storage::max_array_capacity"));
+    return static_cast<uint32_t>(bytes);
+  }
+
+  /// Reallocates the content of an array in value_storage::of_array, see allocator::reallocate().
+  ///
+  /// @return The capacity to record in \a capacity_in_bytes_. When the allocator gives more
+  ///         than value_storage::max_array_capacity, only that much is recorded; the
+  ///         allocators of mFAST don't depend on the size passed to deallocate() for such
+  ///         large blocks.
+  /// @throw std::length_error if @a new_size exceeds value_storage::max_array_capacity.
+  inline uint32_t reallocate_array(allocator* alloc, void*& content, std::size_t old_size, std::size_t new_size)
+  {
+    array_capacity(new_size);
+    std::size_t capacity = alloc->reallocate(content, old_size, new_size);
+    return static_cast<uint32_t>((std::min<std::size_t>)(capacity, value_storage::max_array_capacity));
+  }
+
   MFAST_EXPORT std::istream& operator >> (std::istream& strm, decimal_value_storage& storage);
   MFAST_EXPORT std::ostream& operator << (std::ostream& os, const decimal_value_storage& storage);
 
@@ -93,7 +93,7 @@ namespace mfast {
      **/
     const T* data() const
     {
-      return static_cast<const T*>(storage_->of_array.content_);
+      return static_cast<const T*>(storage_->array_content());
     }
 
     size_t size() const
@@ -168,9 +168,16 @@ namespace mfast {
 
     void save_to(value_storage& v) const
     {
-      v.of_array.content_ = this->storage()->of_array.content_;
-      v.of_array.len_ = this->storage()->of_array.len_;
-      v.of_array.capacity_in_bytes_ = 0;
+      // inline elements are copied along with the storage
+      if (this->storage()->is_inline_array()) {
+        v = *this->storage();
+      }
+      else {
+        v.of_array.content_ = this->storage()->of_array.content_;
+        v.of_array.len_ = this->storage()->of_array.len_;
+        v.of_array.capacity_in_bytes_ = 0;
+        v.of_array.inline_ = 0;
+      }
       v.defined(true);
     }
 
@@ -329,7 +336,7 @@ namespace mfast {
 
     value_type* data() const
     {
-      return static_cast<value_type*>(this->storage()->of_array.content_);
+      return static_cast<value_type*>(this->storage()->array_content());
     }
 
     iterator begin() const
@@ -371,6 +378,7 @@ namespace mfast {
       this->storage()->array_length(static_cast<uint32_t>(n));
     }
 
+    /// @throw std::length_error if @a n elements take more than value_storage::max_array_capacity bytes.
     void reserve(size_t n) const;
 
     void push_back(char c) const
@@ -431,6 +439,7 @@ namespace mfast {
       this->storage()->of_array.content_ = const_cast<void*>(static_cast<const void*>(addr));
       this->storage()->array_length(static_cast<uint32_t>(n));
       this->storage()->of_array.capacity_in_bytes_ = 0;
+      this->storage()->of_array.inline_ = 0;
     }
 
     void shallow_assign(const value_type* addr, size_t n) const
@@ -452,7 +461,7 @@ namespace mfast {
     friend class mfast::detail::codec_helper;
     void copy_from(const value_storage& v) const
     {
-      const char* ptr = static_cast<const char*>(v.of_array.content_);
+      const value_type* ptr = static_cast<const value_type*>(v.array_content());
       this->assign(ptr,
                    ptr+ v.array_length());
     }
@@ -505,9 +514,17 @@ namespace mfast {
     // This behavior is different from the @c std::vector::capacity().
     size_t capacity() const
     {
+      if (this->storage()->is_inline_array())
+        return value_storage::inline_array_capacity / sizeof(T);
       return this->storage()->of_array.capacity_in_bytes_ / sizeof(T);
     }
 
+    // Only the elements of strings and byte vectors are stored inline.
+    static bool fits_inline(std::size_t bytes)
+    {
+      return sizeof(T) == 1 && bytes <= value_storage::inline_array_capacity;
+    }
+
     iterator shift(iterator position, size_t n) const;
   };
 
@@ -676,23 +693,42 @@ namespace mfast {
     if (capacity() > n)
       return;
     std::size_t reserve_size = (n+1)*sizeof(value_type);
+    value_storage* storage = this->storage();
 
-    if (capacity() > 0) {
-      this->storage()->of_array.capacity_in_bytes_
-        = this->alloc_->reallocate(this->storage()->of_array.content_, capacity(), reserve_size);
+    if (storage->of_array.capacity_in_bytes_ > 0) {
+      storage->of_array.capacity_in_bytes_
+        = reallocate_array(this->alloc_,
+                           storage->of_array.content_,
+                           storage->of_array.capacity_in_bytes_,
+                           reserve_size);
     }
     else {
-      void* old_addr = this->storage()->of_array.content_;
-      this->storage()->of_array.content_ = 0;
-      this->storage()->of_array.capacity_in_bytes_
-        = this->alloc_->reallocate(this->storage()->of_array.content_, 0, reserve_size);
+      // The old content is either referenced or inline; in the latter case, it would be
+      // overwritten by the new buffer address and has to be saved first.
+      char inline_content[value_storage::inline_array_capacity];
+      const void* old_addr = storage->of_array.content_;
+      if (storage->is_inline_array()) {
+        std::memcpy(inline_content, &storage->of_array.content_, sizeof(inline_content));
+        old_addr = inline_content;
+      }
+
+      if (!storage->is_inline_array() && fits_inline(reserve_size)) {
+        // short strings and byte vectors are kept in the storage itself
+        storage->of_array.inline_ = 1;
+      }
+      else {
+        storage->of_array.inline_ = 0;
+        storage->of_array.content_ = 0;
+        storage->of_array.capacity_in_bytes_
+          = reallocate_array(this->alloc_, storage->of_array.content_, 0, reserve_size);
+      }
       // Copy the old content to the new buffer.
       // In the case when the this->capacity == 0 && this->size() > 0,
       // reserve() could be invoked with n < this->size(). Thus, we can
       // only copy min(size(), n) elements to the new buffer.
-      if (this->storage()->of_array.len_ > 1) {
+      if (storage->of_array.len_ > 1) {
         if (n > 0)
-          std::memcpy(this->storage()->of_array.content_,
+          std::memcpy(storage->array_content(),
                       old_addr,
                       std::min<size_t>(this->size(), n)*sizeof(value_type) );
       }
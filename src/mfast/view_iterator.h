@@ -36,15 +36,19 @@ namespace mfast
     const group_field_instruction* instruction_;
     mfast::array_view<const field_view_info> data_;
     unsigned max_depth_;
+    // the names of the view fields; empty for views built without them
+    mfast::array_view<const char* const> field_names_;
     aggregate_view_info(){}
     aggregate_view_info(const char*                              name,
                         const group_field_instruction*           inst,
                         mfast::array_view<const field_view_info> data,
-                        unsigned                                 max_depth)
+                        unsigned                                 max_depth,
+                        mfast::array_view<const char* const>     field_names = mfast::array_view<const char* const>())
       : name_(name)
       , instruction_(inst)
       , data_(data)
       , max_depth_(max_depth)
+      , field_names_(field_names)
     {
     }
 
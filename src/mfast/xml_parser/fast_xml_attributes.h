@@ -40,6 +40,7 @@ namespace mfast
       const char* presence_;
       const char* charset_;
       const char* tag_;
+      const char* max_length_;
 
       fast_xml_attributes()
         : name_(0)
@@ -50,6 +51,7 @@ namespace mfast
         , presence_(0)
         , charset_(0)
         , tag_(0)
+        , max_length_(0)
       {
       }
 
@@ -62,6 +64,7 @@ namespace mfast
         , presence_(0)
         , charset_(0)
         , tag_(0)
+        , max_length_(0)
       {
       }
 
@@ -75,6 +78,7 @@ namespace mfast
         presence_ = 0;
         charset_ = 0;
         tag_ = 0;
+        max_length_ = 0;
 
         set(attr);
       }
@@ -101,6 +105,8 @@ namespace mfast
             charset_ = attr->Value();
           else if (std::strcmp(name, "mfast:tag") == 0)
             tag_ = attr->Value();
+          else if (std::strcmp(name, "mfast:maxLength") == 0)
+            max_length_ = attr->Value();
           attr = attr->Next();
         }
       }
@@ -126,6 +132,11 @@ namespace mfast
         return ns_ ? string_dup(ns_, alloc) : inst->ns();
       }
 
+      uint16_t get_max_length(const field_instruction* inst) const
+      {
+        return max_length_ ? boost::lexical_cast<uint16_t>(max_length_) : inst->max_length();
+      }
+
     };
 
   }
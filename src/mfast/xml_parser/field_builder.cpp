@@ -283,6 +283,7 @@ namespace mfast
         string_value_storage(fop.initial_value_),
         parse_tag(inst)
         );
+      instruction->max_length(get_max_length(inst));
       parent_->add_instruction(instruction);
     }
 
@@ -312,6 +313,7 @@ namespace mfast
         get_length_ns(inst, length_attrs),
         parse_tag(inst)
         );
+      instruction->max_length(get_max_length(inst));
       parent_->add_instruction(instruction);
     }
 
@@ -341,6 +343,7 @@ namespace mfast
         get_length_ns(inst, length_attrs),
         parse_tag(inst)
         );
+      instruction->max_length(get_max_length(inst));
       parent_->add_instruction(instruction);
     }
 
@@ -592,6 +595,7 @@ namespace mfast
         );
 
 
+      instruction->max_length(get_max_length(inst));
       parent_->add_instruction(instruction);
     }
 
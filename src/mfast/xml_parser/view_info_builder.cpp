@@ -265,11 +265,16 @@ namespace mfast
                                  name);
 
       std::deque<field_view_info> fields;
+      std::vector<const char*> field_names;
 
       const tinyxml2::XMLElement* child = element.FirstChildElement();
       while (child != 0) {
         if (std::strcmp(child->Name(), "field") == 0)
         {
+          const char* field_name = get_optional_attr(*child, "name", "");
+          field_names.push_back(std::strcpy(new (alloc_) char[std::strlen(field_name) + 1],
+                                            field_name));
+
           const tinyxml2::XMLElement* grandchild = child->FirstChildElement();
           while (grandchild != 0) {
             build_field_view(*grandchild, result.max_depth_, fields);
@@ -286,6 +291,10 @@ namespace mfast
       field_view_info* data = new (alloc_) field_view_info[ fields.size() ];
       std::copy(fields.begin(), fields.end(), data);
       result.data_ = mfast::array_view<const field_view_info>(data, fields.size());
+
+      const char** names = new (alloc_) const char*[field_names.size()];
+      std::copy(field_names.begin(), field_names.end(), names);
+      result.field_names_ = mfast::array_view<const char* const>(names, field_names.size());
       result.instruction_ = inst;
       return result;
     }
@@ -21,6 +21,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <sstream>
+#include <cstring>
+#include <stdexcept>
 #include "mfast.h"
 #include <mfast/xml_parser/dynamic_templates_description.h>
 #include "test5.h"
@@ -212,4 +214,81 @@ BOOST_AUTO_TEST_CASE(codegen_view_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(compiled_view_test)
+{
+  dynamic_templates_description description(xml_content);
+  compiled_view view(description.view_infos()[0]);
+
+  BOOST_CHECK_EQUAL(view.size(), 6U);
+  BOOST_CHECK_EQUAL(view.field_name(2), "postalCode");
+  BOOST_CHECK_EQUAL(view.field_index("phoneNumber"), 4U);
+  BOOST_CHECK_THROW(view.field_index("age"), std::invalid_argument);
+  BOOST_CHECK_EQUAL(view.alternative_count(5), 2U);
+
+  const template_instruction* person_instruction = 0;
+  for (std::size_t i = 0; i < description.size(); ++i) {
+    if (std::strcmp(description[i]->name(), "Person") == 0)
+      person_instruction = description[i];
+  }
+  BOOST_REQUIRE(person_instruction);
+
+  debug_allocator alloc;
+  message_type person(&alloc, person_instruction);
+  message_mref ref = person.ref();
+  ref[0].as("John");
+  ref[1].as("Doe");
+
+  BOOST_CHECK_EQUAL(ascii_string_cref(view.get(person.cref(), 0)).value(), "Doe");
+  // the address is absent and the phone number has no element 0
+  BOOST_CHECK(view.get(person.cref(), 2).absent());
+  BOOST_CHECK(view.get(person.cref(), 4).absent());
+  // login is absent, so userName is taken from firstName
+  BOOST_CHECK_EQUAL(ascii_string_cref(view.get(person.cref(), 5)).value(), "John");
+
+  group_mref address(ref[3]);
+  address[1].as("St. Louis");
+  address[3].as(63141);
+  sequence_mref phone_numbers(ref[4]);
+  phone_numbers.resize(2);
+  phone_numbers[0][1].as("1234567");
+  group_mref(ref[6])[0].as("John123");
+
+  BOOST_CHECK_EQUAL(uint32_cref(view.get(person.cref(), 2)).value(), 63141U);
+  BOOST_CHECK_EQUAL(ascii_string_cref(view.get(person.cref(), 3)).value(), "St. Louis");
+  BOOST_CHECK_EQUAL(ascii_string_cref(view.get(person.cref(), 4)).value(), "1234567");
+  BOOST_CHECK_EQUAL(ascii_string_cref(view.get(person.cref(), 5)).value(), "John123");
+
+  std::stringstream strm;
+  simple_visitor visitor(strm);
+  view.accept_accessor(person.cref(), visitor);
+  BOOST_CHECK_EQUAL( strm.str(), std::string("Doe\tJohn\t63141\tSt. Louis\t1234567\tJohn123\t") );
+}
+
+BOOST_AUTO_TEST_CASE(codegen_compiled_view_test)
+{
+  using namespace test5;
+
+  Person person_holder;
+  Person_mref person = person_holder.mref();
+  person.set_firstName().as("John");
+  person.set_lastName().as("Doe");
+
+  PersonView view(person_holder.cref());
+  BOOST_CHECK_EQUAL(view.get_lastName().value(), "Doe");
+  BOOST_CHECK(!view.get_postalCode().present());
+  BOOST_CHECK(!view.get_phoneNumber().present());
+  BOOST_CHECK_EQUAL(view.get_userName().value(), "John");
+
+  person.set_address().set_postalCode().as(63141);
+  person.set_phoneNumbers().resize(1);
+  person.set_phoneNumbers()[0].set_number().as("1234567");
+  person.set_login().set_userName().as("John123");
+
+  mfast::uint32_cref postal_code = view.get_postalCode();
+  BOOST_CHECK_EQUAL(postal_code.value(), 63141U);
+  BOOST_CHECK_EQUAL(view.get_phoneNumber().value(), "1234567");
+  BOOST_CHECK_EQUAL(view.get_userName().value(), "John123");
+  BOOST_CHECK_EQUAL(PersonView::compiled().field_name(1), "firstName");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -57,4 +57,76 @@ BOOST_AUTO_TEST_CASE(arena_allocatore_test)
   memset(block7, 0, 3*arena_allocator::default_chunk_size);
 }
 
+BOOST_AUTO_TEST_CASE(arena_allocator_reallocate_test)
+{
+  arena_allocator alloc;
+
+  void* block1 = 0;
+  std::size_t capacity1 = alloc.reallocate(block1, 0, 10);
+  BOOST_CHECK_EQUAL(capacity1, 64U);
+  memset(block1, 'a', capacity1);
+
+  // the last allocated block grows in place
+  void* pointer = block1;
+  std::size_t capacity2 = alloc.reallocate(pointer, capacity1, 100);
+  BOOST_CHECK_EQUAL(pointer, block1);
+  BOOST_CHECK_EQUAL(capacity2, 256U);
+  capacity1 = capacity2;
+
+  void* block2 = 0;
+  capacity2 = alloc.reallocate(block2, 0, 10);
+
+  // block1 is no longer the last one; it has to move
+  capacity1 = alloc.reallocate(pointer, capacity1, 200);
+  BOOST_CHECK(pointer != block1);
+  BOOST_CHECK_EQUAL(static_cast<char*>(pointer)[63], 'a');
+
+  // the space left behind by block1 is reused
+  void* block3 = block2;
+  alloc.reallocate(block3, capacity2, 100);
+  BOOST_CHECK_EQUAL(block3, block1);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_growth_test)
+{
+  arena_allocator::chunk_policy policy;
+  policy.chunk_size = 3000; // rounded up to default_chunk_size
+  policy.growth_factor = 2;
+
+  arena_allocator alloc(policy);
+
+  // fill up the first chunk
+  alloc.allocate(arena_allocator::chunk_user_size);
+
+  // the second chunk is twice as big, both blocks come from it
+  void* block2 = alloc.allocate(arena_allocator::chunk_user_size);
+  void* block3 = alloc.allocate(arena_allocator::default_chunk_size/2);
+  BOOST_CHECK_EQUAL(block3, static_cast<void*>(static_cast<char*>(block2) + arena_allocator::chunk_user_size));
+
+  // the most recent chunk is kept as the current one
+  alloc.reset();
+  BOOST_CHECK_EQUAL(alloc.allocate(arena_allocator::chunk_user_size), block2);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_mapped_test)
+{
+  // huge pages and NUMA binding are only hints; the allocator must work without them
+  arena_allocator::chunk_policy policy;
+  policy.chunk_size = 64*1024;
+  policy.huge_pages = true;
+  policy.numa_node = 0;
+  policy.prefault = true;
+
+  arena_allocator alloc(policy);
+
+  void* block1 = alloc.allocate(1000);
+  memset(block1, 0, 1000);
+
+  void* block2 = alloc.allocate(3*policy.chunk_size);
+  memset(block2, 0, 3*policy.chunk_size);
+
+  alloc.reset();
+  BOOST_CHECK_EQUAL(alloc.allocate(3*policy.chunk_size), block2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
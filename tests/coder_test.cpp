@@ -27,6 +27,8 @@
 #include <mfast/coder/fast_decoder.h>
 #include <cstring>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "byte_stream.h"
 #include "debug_allocator.h"
@@ -348,5 +350,143 @@ BOOST_AUTO_TEST_CASE(auto_reset_coder_test)
   BOOST_CHECK(test_case.decoding("\x80", msg_ref));
 }
 
+BOOST_AUTO_TEST_CASE(auto_reset_arenas_test)
+{
+  dynamic_templates_description description(
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\" id=\"1\">\n"
+    "<string name=\"field1\" id=\"11\"></string>\n"
+    "<string name=\"field2\" id=\"12\"><copy/></string>\n"
+    "<string name=\"field3\" id=\"13\"><delta/></string>\n"
+    "</template>\n"
+    "</templates>\n");
+
+  const templates_description* descriptions[] = { &description };
+
+  fast_encoder encoder;
+  encoder.include(descriptions);
+  fast_decoder decoder;
+  decoder.include(descriptions);
+  decoder.auto_reset_arenas(true);
+
+  debug_allocator alloc;
+  message_type msg(&alloc, encoder.template_with_id(1));
+  message_mref msg_ref = msg.mref();
+  msg_ref[1].as("ABC");
+  msg_ref[2].as("DEFGH");
+
+  const char* field1_values[] = {
+    "a", "b", "a much longer value which is meant to take up the space where the earlier messages were", "d", "e"
+  };
+
+  std::vector<message_cref> results;
+
+  for (int i = 0; i < 5; ++i) {
+    msg_ref[0].as(field1_values[i]);
+
+    char buffer[128];
+    std::size_t encoded_size = encoder.encode(msg_ref, buffer, sizeof(buffer));
+
+    const char* first = buffer;
+    message_cref result = decoder.decode(first, buffer+encoded_size);
+    BOOST_CHECK(first == buffer+encoded_size);
+    BOOST_CHECK(result == msg_ref);
+
+    // the message from the previous call is still alive
+    if (i > 0) {
+      const message_cref& prev_result = results.back();
+      BOOST_CHECK(prev_result.field_storage(0) != result.field_storage(0));
+      BOOST_CHECK_EQUAL(std::string(ascii_string_cref(prev_result[0]).c_str()), field1_values[i-1]);
+      BOOST_CHECK_EQUAL(std::string(ascii_string_cref(prev_result[1]).c_str()), "ABC");
+    }
+    results.push_back(result);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sequence_length_hints_test)
+{
+  dynamic_templates_description description(
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\" id=\"1\">\n"
+    "<uInt32 name=\"field1\" id=\"11\"><copy/></uInt32>\n"
+    "<sequence name=\"sequence1\" presence=\"optional\">"
+    "<uInt32 name=\"field2\" id=\"12\"></uInt32>\n"
+    "</sequence>"
+    "</template>\n"
+    "</templates>\n");
+
+  const templates_description* descriptions[] = { &description };
+
+  fast_encoder encoder;
+  encoder.include(descriptions);
+  fast_decoder decoder;
+  decoder.include(descriptions);
+  decoder.sequence_length_hints(true);
+
+  debug_allocator alloc;
+  message_type msg(&alloc, encoder.template_with_id(1));
+  message_mref msg_ref = msg.mref();
+
+  msg_ref[0].as(1);
+
+  const unsigned lengths[] = { 2, 5, 3 };
+  for (int i = 0; i < 3; ++i) {
+    sequence_mref seq(msg_ref[1]);
+    seq.resize(lengths[i]);
+    for (unsigned j = 0; j < lengths[i]; ++j)
+      seq[j][0].as(j);
+
+    char buffer[128];
+    std::size_t encoded_size = encoder.encode(msg_ref, buffer, sizeof(buffer));
+    const char* first = buffer;
+    message_cref result = decoder.decode(first, buffer+encoded_size);
+    BOOST_CHECK(result == msg_ref);
+  }
+
+  std::vector<sequence_length_stats> stats = decoder.sequence_statistics();
+  BOOST_REQUIRE_EQUAL(stats.size(), 1U);
+  BOOST_CHECK_EQUAL(stats[0].instruction->name(), std::string("sequence1"));
+  BOOST_CHECK_EQUAL(stats[0].count, 3U);
+  BOOST_CHECK_EQUAL(stats[0].high_water_mark, 5U);
+  // 2, then 2 + (5-2)/8, then 2.375 + (3-2.375)/8
+  BOOST_CHECK_CLOSE(stats[0].average, 2.453125, 0.0001);
+}
+
+
+BOOST_AUTO_TEST_CASE(utf8_validation_test)
+{
+  dynamic_templates_description description(
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\" id=\"1\">\n"
+    "<string name=\"field1\" id=\"11\" charset=\"unicode\"><copy/></string>\n"
+    "</template>\n"
+    "</templates>\n");
+
+  const templates_description* descriptions[] = { &description };
+
+  fast_decoder decoder;
+  decoder.include(descriptions);
+
+  // without validation, the bytes are taken as they are
+  const char malformed[] = "\xE0\x81\x82\xC3\x28";
+  const char* first = malformed;
+  decoder.decode(first, malformed + 5, true);
+
+  decoder.validate_utf8(true);
+  const char valid[] = "\xE0\x81\x82\xC3\xA9";
+  first = valid;
+  message_cref result = decoder.decode(first, valid + 5, true);
+  BOOST_CHECK_EQUAL(unicode_string_cref(result[0]).value(), boost::string_ref("\xC3\xA9"));
+
+  first = malformed;
+  BOOST_CHECK_THROW(decoder.decode(first, malformed + 5, true), fast_reportable_error);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
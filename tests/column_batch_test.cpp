@@ -0,0 +1,231 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/column_batch.h>
+#include <mfast/xml_parser/dynamic_templates_description.h>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "debug_allocator.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( column_batch_test_suite )
+
+namespace {
+
+  std::string binary_value(const column_view& column, std::size_t row)
+  {
+    return std::string(column.data + column.offsets[row], column.data + column.offsets[row+1]);
+  }
+
+  void check_columns(const std::vector<column_view>& columns)
+  {
+    BOOST_REQUIRE_EQUAL(columns.size(), 6U);
+
+    const column_view& id = columns[0];
+    BOOST_CHECK_EQUAL(std::string(id.name), "id");
+    BOOST_CHECK_EQUAL(id.type, column_uint64);
+    BOOST_CHECK_EQUAL(id.length, 2U);
+    BOOST_CHECK_EQUAL(id.null_count, 0U);
+    BOOST_CHECK_EQUAL(id.uint64_values()[0], 1U);
+    BOOST_CHECK_EQUAL(id.uint64_values()[1], 2U);
+
+    const column_view& qty = columns[1];
+    BOOST_CHECK_EQUAL(qty.type, column_int64);
+    BOOST_CHECK_EQUAL(qty.null_count, 1U);
+    BOOST_CHECK(!qty.is_valid(0));
+    BOOST_CHECK(qty.is_valid(1));
+    BOOST_CHECK_EQUAL(qty.int64_values()[1], -5);
+
+    const column_view& px = columns[2];
+    BOOST_CHECK_EQUAL(px.type, column_decimal);
+    BOOST_CHECK_EQUAL(px.int64_values()[0], 12345);
+    BOOST_CHECK_EQUAL(px.exponents[0], -2);
+
+    const column_view& trader = columns[3];
+    BOOST_CHECK_EQUAL(std::string(trader.name), "parties.trader");
+    BOOST_CHECK_EQUAL(trader.type, column_binary);
+    BOOST_CHECK(!trader.is_valid(0));
+    BOOST_CHECK(trader.is_valid(1));
+    BOOST_CHECK_EQUAL(binary_value(trader, 1), "alice");
+
+    const column_view& legs = columns[5];
+    BOOST_CHECK_EQUAL(std::string(legs.name), "legs");
+    BOOST_CHECK_EQUAL(legs.type, column_list);
+    BOOST_CHECK_EQUAL(legs.offsets[0], 0);
+    BOOST_CHECK_EQUAL(legs.offsets[1], 2);
+    BOOST_CHECK_EQUAL(legs.offsets[2], 3);
+    BOOST_REQUIRE_EQUAL(legs.children.size(), 2U);
+    const column_view& symbol = legs.children[1];
+    BOOST_CHECK_EQUAL(symbol.length, 3U);
+    BOOST_CHECK_EQUAL(binary_value(symbol, 0), "AAPL");
+    BOOST_CHECK_EQUAL(binary_value(symbol, 1), "MSFT");
+    BOOST_CHECK_EQUAL(binary_value(symbol, 2), "IBM");
+    BOOST_CHECK_EQUAL(legs.children[0].uint64_values()[2], 30U);
+  }
+
+}
+
+BOOST_AUTO_TEST_CASE(column_batch_build_test)
+{
+  dynamic_templates_description description(
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Order\" id=\"1\">\n"
+    "  <uInt32 name=\"id\" id=\"11\"/>\n"
+    "  <int64 name=\"qty\" id=\"12\" presence=\"optional\"/>\n"
+    "  <decimal name=\"px\" id=\"13\"/>\n"
+    "  <group name=\"parties\" presence=\"optional\">\n"
+    "    <string name=\"trader\" id=\"14\"/>\n"
+    "    <uInt32 name=\"desk\" id=\"15\"/>\n"
+    "  </group>\n"
+    "  <sequence name=\"legs\">\n"
+    "    <length name=\"noLegs\" id=\"16\"/>\n"
+    "    <uInt32 name=\"ratio\" id=\"17\"/>\n"
+    "    <string name=\"symbol\" id=\"18\"/>\n"
+    "  </sequence>\n"
+    "</template>\n"
+    "</templates>\n");
+
+  const template_instruction* inst = description[0];
+  debug_allocator alloc;
+  column_batch_builder builder;
+
+  {
+    message_type msg(&alloc, inst);
+    message_mref ref = msg.mref();
+    ref[0].as(1);
+    decimal_mref(ref[2]).as(12345, -2);
+    sequence_mref legs(ref[4]);
+    legs.resize(2);
+    legs[0][0].as(10);
+    ascii_string_mref(legs[0][1]).as("AAPL");
+    legs[1][0].as(20);
+    ascii_string_mref(legs[1][1]).as("MSFT");
+    builder.append(msg.cref());
+  }
+  {
+    message_type msg(&alloc, inst);
+    message_mref ref = msg.mref();
+    ref[0].as(2);
+    ref[1].as(-5);
+    decimal_mref(ref[2]).as(7, 0);
+    group_mref parties(ref[3]);
+    ascii_string_mref(parties[0]).as("alice");
+    parties[1].as(3);
+    sequence_mref legs(ref[4]);
+    legs.resize(1);
+    legs[0][0].as(30);
+    ascii_string_mref(legs[0][1]).as("IBM");
+    builder.append(msg.cref());
+  }
+
+  BOOST_CHECK_EQUAL(builder.batch(inst)->num_rows(), 2U);
+  column_batch* batch = builder.release(inst);
+  BOOST_REQUIRE(batch);
+  BOOST_CHECK(builder.batch(inst) == 0);
+  BOOST_CHECK(batch->sealed());
+  check_columns(batch->columns());
+
+  message_type another(&alloc, inst);
+  BOOST_CHECK_THROW(batch->append(another.cref()), std::logic_error);
+
+  const char* path = "column_batch_test.col";
+  write_column_file(*batch, path);
+  delete batch;
+
+  std::vector<uint64_t> content;
+  std::FILE* file = std::fopen(path, "rb");
+  BOOST_REQUIRE(file);
+  std::fseek(file, 0, SEEK_END);
+  std::size_t size = std::ftell(file);
+  std::fseek(file, 0, SEEK_SET);
+  content.resize((size + 7)/8);
+  BOOST_CHECK_EQUAL(std::fread(&content[0], 1, size, file), size);
+  std::fclose(file);
+  std::remove(path);
+
+  column_file_view view(&content[0], size);
+  BOOST_CHECK_EQUAL(view.num_rows(), 2U);
+  check_columns(view.columns());
+  BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(view.columns()[2].values) % 64,
+                    reinterpret_cast<std::size_t>(&content[0]) % 64);
+
+  BOOST_CHECK_THROW(column_file_view(&content[0], 16), std::runtime_error);
+
+  // the first directory entry follows the 32 byte file header; its length
+  // is at offset 8 and its name buffer offset and size at offset 24
+  char* first_entry = reinterpret_cast<char*>(&content[0]) + 32;
+  std::vector<uint64_t> corrupt(content);
+  uint64_t length = 1000;
+  std::memcpy(reinterpret_cast<char*>(&corrupt[0]) + 32 + 8, &length, sizeof(length));
+  BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+
+  corrupt = content;
+  uint64_t name_offset, name_size;
+  std::memcpy(&name_offset, first_entry + 24, sizeof(name_offset));
+  std::memcpy(&name_size, first_entry + 32, sizeof(name_size));
+  reinterpret_cast<char*>(&corrupt[0])[name_offset + name_size - 1] = 'x';
+  BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+
+  // the entries are 120 bytes, in the order id, qty, px, parties.trader, parties.desk,
+  // legs, legs.ratio and legs.symbol; num_children_ is at offset 4 and the offset of the
+  // offsets buffer at offset 88
+  const std::size_t trader_entry = 32 + 3*120, legs_entry = 32 + 5*120;
+  uint64_t trader_offsets, legs_offsets;
+  std::memcpy(&trader_offsets, reinterpret_cast<char*>(&content[0]) + trader_entry + 88, sizeof(uint64_t));
+  std::memcpy(&legs_offsets, reinterpret_cast<char*>(&content[0]) + legs_entry + 88, sizeof(uint64_t));
+
+  // the trader offsets are 0, 0, 5; the data has 5 bytes
+  const int32_t trader_corruptions[][3] = { { 1, 1, 5 }, { 0, 3, 2 }, { 0, 0, 6 } };
+  for (int i = 0; i < 3; ++i) {
+    corrupt = content;
+    std::memcpy(reinterpret_cast<char*>(&corrupt[0]) + trader_offsets, trader_corruptions[i], 3*sizeof(int32_t));
+    BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+  }
+
+  // the legs offsets are 0, 2, 3; the children have 3 rows
+  corrupt = content;
+  int32_t legs_end = 4;
+  std::memcpy(reinterpret_cast<char*>(&corrupt[0]) + legs_offsets + 2*sizeof(int32_t), &legs_end, sizeof(legs_end));
+  BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+
+  // legs has 2 children, which are the last entries
+  const uint32_t num_children[] = { 1, 3 };
+  for (int i = 0; i < 2; ++i) {
+    corrupt = content;
+    std::memcpy(reinterpret_cast<char*>(&corrupt[0]) + legs_entry + 4, &num_children[i], sizeof(uint32_t));
+    BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+  }
+
+  // only list columns have children
+  corrupt = content;
+  std::memcpy(reinterpret_cast<char*>(&corrupt[0]) + 32 + 4, &num_children[0], sizeof(uint32_t));
+  BOOST_CHECK_THROW(column_file_view(&corrupt[0], size), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include <mfast/coder/encoder/fast_ostream.h>
 #include <mfast/coder/encoder/fast_ostream_inserter.h>
 #include <mfast/coder/encoder/encoder_presence_map.h>
+#include <mfast/coder/encoder/pooled_fast_ostreambuf.h>
 #include <mfast/output.h>
 #include "debug_allocator.h"
 #include <stdexcept>
@@ -67,6 +68,9 @@ BOOST_AUTO_TEST_CASE(int_test)
   BOOST_CHECK(encode_integer(INT32_C(-7942755), false, "\x7c\x1b\x1b\x9d"));
   BOOST_CHECK(encode_integer(INT32_C(8193), false, "\x00\x40\x81"));
   BOOST_CHECK(encode_integer(INT32_C(-8193), false, "\x7F\x3f\xff"));
+  BOOST_CHECK(encode_integer(INT32_C(-1), false, "\xFF"));
+  BOOST_CHECK(encode_integer(INT32_C(-1), true, "\xFF"));
+  BOOST_CHECK(encode_integer(INT64_C(-1), false, "\xFF"));
 
   BOOST_CHECK(encode_integer(UINT32_C(0), true, "\x81"));
   BOOST_CHECK(encode_integer(UINT32_C(1), true, "\x82"));
@@ -337,4 +341,39 @@ BOOST_AUTO_TEST_CASE(non_overlong_encoder_presence_map_test)
 
 
 
+BOOST_AUTO_TEST_CASE(pooled_ostreambuf_test)
+{
+  const char* first_buffer;
+  {
+    pooled_fast_ostreambuf sb(300);
+    BOOST_CHECK_EQUAL(sb.capacity(), 512U);
+    first_buffer = sb.data();
+  }
+  {
+    // a released buffer is reused by the next one of the same size class
+    pooled_fast_ostreambuf sb(500);
+    BOOST_CHECK(sb.data() == first_buffer);
+
+    debug_allocator alloc;
+    fast_ostream strm(&alloc);
+    strm.rdbuf(&sb);
+
+    std::string value(1000, 'A');
+    strm.encode(value.c_str(),
+                static_cast<uint32_t>(value.size()),
+                static_cast<const ascii_field_instruction*>(0),
+                false);
+    strm.encode(0, false, false);
+
+    value[999] = '\xC1';
+    value += '\x80';
+    BOOST_CHECK_EQUAL(sb.length(), value.size());
+    BOOST_CHECK(std::equal(value.begin(), value.end(), sb.data()));
+    BOOST_CHECK(sb.capacity() >= 1024U);
+
+    sb.clear();
+    BOOST_CHECK_EQUAL(sb.length(), 0U);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -282,5 +282,137 @@ BOOST_AUTO_TEST_CASE(dynamic_templateref_compare_test)
   BOOST_CHECK(m3.cref() == m1ref);
 }
 
+BOOST_AUTO_TEST_CASE(equal_and_hash_test)
+{
+  debug_allocator alloc;
+
+  const char* xml_content =
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\">\n"
+    "<int32 name=\"field1\" id=\"11\"><copy/></int32>\n"
+    "<decimal name=\"field2\" id=\"12\"><copy/></decimal>\n"
+    "<string name=\"field3\" id=\"13\"><copy/></string>\n"
+    "<group name=\"group1\" presence=\"optional\">"
+    "<uInt32 name=\"field4\" id=\"14\"><copy/></uInt32>\n"
+    "</group>"
+    "<sequence name=\"sequence1\" presence=\"optional\">"
+    "<uInt64 name=\"field5\" id=\"15\"><copy/></uInt64>\n"
+    "</sequence>"
+    "</template>\n"
+    "</templates>\n";
+
+  dynamic_templates_description description(xml_content);
+  dynamic_templates_description another_description(xml_content);
+
+  message_type m1(&alloc, description[0]);
+  message_type m2(&alloc, another_description[0]);
+
+  message_mref refs[] = { m1.ref(), m2.ref() };
+  for (int i = 0; i < 2; ++i) {
+    refs[i][0].as(-1);
+    refs[i][1].as(decimal(123));
+    refs[i][2].as("a longer string value");
+    sequence_mref seq(refs[i][4]);
+    seq.resize(2);
+    seq[0][0].as(5);
+    seq[1][0].as(6);
+  }
+
+  BOOST_CHECK(equal(m1.cref(), m2.cref()));
+  BOOST_CHECK_EQUAL(hash(m1.cref()), hash(m2.cref()));
+  BOOST_CHECK(equal(m1.cref(), m1.cref()));
+
+  group_mref(refs[1][3])[0].as(7);
+  BOOST_CHECK(!equal(m1.cref(), m2.cref()));
+  refs[1][3].omit();
+  BOOST_CHECK(equal(m1.cref(), m2.cref()));
+
+  refs[1][2].as("a longer string valuf");
+  BOOST_CHECK(!equal(m1.cref(), m2.cref()));
+  BOOST_CHECK(hash(m1.cref()) != hash(m2.cref()));
+  refs[1][2].as("a longer string value");
+
+  sequence_mref(refs[1][4])[1][0].as(60);
+  BOOST_CHECK(!equal(m1.cref(), m2.cref()));
+  BOOST_CHECK(hash(m1.cref()) != hash(m2.cref()));
+
+  // an absent sequence differs from an empty one
+  sequence_mref(refs[0][4]).resize(0);
+  refs[1][4].omit();
+  BOOST_CHECK(!equal(m1.cref(), m2.cref()));
+
+  message_type m3(m1.cref(), &alloc);
+  BOOST_CHECK(equal(m3.cref(), m1.cref()));
+  BOOST_CHECK_EQUAL(hash(m3.cref()), hash(m1.cref()));
+}
+
+BOOST_AUTO_TEST_CASE(diff_test)
+{
+  debug_allocator alloc;
+
+  const char* xml_content =
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\">\n"
+    "<int32 name=\"field1\" id=\"11\"><copy/></int32>\n"
+    "<string name=\"field2\" id=\"12\"><copy/></string>\n"
+    "<group name=\"group1\" presence=\"optional\">"
+    "<uInt32 name=\"field3\" id=\"13\"><copy/></uInt32>\n"
+    "</group>"
+    "<uInt64 name=\"field4\" id=\"14\" presence=\"optional\"><copy/></uInt64>\n"
+    "</template>\n"
+    "<template name=\"Longer\">\n"
+    "<int32 name=\"field1\" id=\"11\"><copy/></int32>\n"
+    "<string name=\"field2\" id=\"12\"><copy/></string>\n"
+    "<group name=\"group1\" presence=\"optional\">"
+    "<uInt32 name=\"field3\" id=\"13\"><copy/></uInt32>\n"
+    "</group>"
+    "<int64 name=\"field4\" id=\"14\" presence=\"optional\"><copy/></int64>\n"
+    "<int64 name=\"field5\" id=\"15\"><copy/></int64>\n"
+    "</template>\n"
+    "</templates>\n";
+
+  dynamic_templates_description description(xml_content);
+
+  message_type m1(&alloc, description[0]);
+  message_type m2(&alloc, description[0]);
+
+  message_mref refs[] = { m1.ref(), m2.ref() };
+  for (int i = 0; i < 2; ++i) {
+    refs[i][0].as(1);
+    refs[i][1].as("abc");
+    group_mref(refs[i][2])[0].as(3);
+  }
+
+  std::vector<std::size_t> changed;
+  diff(m1.cref(), m2.cref(), changed);
+  BOOST_CHECK(changed.empty());
+
+  refs[1][1].as("abd");
+  group_mref(refs[1][2])[0].as(4);
+  refs[1][3].as(4);
+  diff(m1.cref(), m2.cref(), changed);
+  BOOST_REQUIRE_EQUAL(changed.size(), 3U);
+  BOOST_CHECK_EQUAL(changed[0], 1U);
+  BOOST_CHECK_EQUAL(changed[1], 2U);
+  BOOST_CHECK_EQUAL(changed[2], 3U);
+
+  // the fourth field differs in type and the fifth one is missing in m1
+  message_type m3(&alloc, description[1]);
+  message_mref ref3 = m3.ref();
+  ref3[0].as(1);
+  ref3[1].as("abc");
+  group_mref(ref3[2])[0].as(3);
+
+  changed.clear();
+  diff(m1.cref(), m3.cref(), changed);
+  BOOST_REQUIRE_EQUAL(changed.size(), 2U);
+  BOOST_CHECK_EQUAL(changed[0], 3U);
+  BOOST_CHECK_EQUAL(changed[1], 4U);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
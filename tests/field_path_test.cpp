@@ -0,0 +1,105 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/field_path.h>
+
+#include "test2.h"
+#include "test3.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( field_path_test_suite )
+
+BOOST_AUTO_TEST_CASE(subinstruction_index_test)
+{
+  arena_allocator alloc;
+  const template_instruction* original = test2::MDRefreshSample::instruction();
+  const group_field_instruction* entries =
+    static_cast<const group_field_instruction*>(original->subinstruction(1));
+
+  group_field_instruction indexed(*entries);
+  indexed.build_subinstruction_index(alloc);
+
+  for (std::size_t i = 0; i < entries->subinstructions().size(); ++i) {
+    const field_instruction* inst = entries->subinstruction(i);
+    BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_name(inst->name()),
+                      entries->find_subinstruction_index_by_name(inst->name()));
+    BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_id(inst->id()),
+                      entries->find_subinstruction_index_by_id(inst->id()));
+  }
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_name("Symbol"), 2);
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_id(55), 2);
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_name("NoSuchField"), -1);
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_id(9999), -1);
+
+  // the index is dropped with the subinstructions it was built for
+  indexed.set_subinstructions(original->subinstructions());
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_name("MDEntries"), 1);
+  BOOST_CHECK_EQUAL(indexed.find_subinstruction_index_by_name("Symbol"), -1);
+}
+
+BOOST_AUTO_TEST_CASE(field_path_sequence_test)
+{
+  test2::MDRefreshSample sample;
+  test2::MDRefreshSample_mref::MDEntries_mref entries = sample.mref().set_MDEntries();
+  entries.resize(2);
+  entries[0].set_Symbol().as("MSFT");
+  entries[1].set_Symbol().as("IBM");
+  entries[1].set_NumberOfOrders().as(7);
+
+  field_path symbol(test2::MDRefreshSample::instruction(), "MDEntries.Symbol");
+  BOOST_CHECK_EQUAL(symbol.sequence_count(), 1U);
+  BOOST_CHECK_EQUAL(symbol.instruction()->id(), 55U);
+
+  std::size_t index = 1;
+  ascii_string_cref symbol1(symbol.get(sample.cref(), &index));
+  BOOST_CHECK(symbol1 == "IBM");
+  index = 0;
+  BOOST_CHECK(ascii_string_cref(symbol.get(sample.cref(), &index)) == "MSFT");
+
+  // out of range elements are absent
+  index = 2;
+  BOOST_CHECK(symbol.get(sample.cref(), &index).absent());
+
+  field_path orders(test2::MDRefreshSample::instruction(), "MDEntries.NumberOfOrders");
+  index = 1;
+  uint32_mref(orders.get(sample.mref(), &index)).as(9);
+  BOOST_CHECK_EQUAL(sample.cref().get_MDEntries()[1].get_NumberOfOrders().value(), 9U);
+
+  BOOST_CHECK_THROW(field_path(test2::MDRefreshSample::instruction(), "MDEntries.NoSuchField"), field_path_error);
+  BOOST_CHECK_THROW(field_path(test2::MDRefreshSample::instruction(), "MDEntries.Symbol.Length"), field_path_error);
+}
+
+BOOST_AUTO_TEST_CASE(field_path_group_test)
+{
+  test3::Person person;
+  field_path city(test3::Person::instruction(), "address.city");
+  BOOST_CHECK_EQUAL(city.sequence_count(), 0U);
+
+  // the optional group is absent
+  BOOST_CHECK(city.get(person.cref()).absent());
+
+  person.mref().set_address().set_city().as("Saint Louis");
+  BOOST_CHECK(ascii_string_cref(city.get(person.cref())) == "Saint Louis");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,7 @@
 #include <mfast/sequence_ref.h>
 #include <mfast/coder/common/codec_helper.h>
 #include "debug_allocator.h"
+#include <typeinfo>
 
 using namespace mfast;
 
@@ -434,6 +435,19 @@ BOOST_AUTO_TEST_CASE(decimal_field_test2)
     BOOST_CHECK_EQUAL(ref.mantissa(), 123);
     BOOST_CHECK_EQUAL(ref.exponent(), -1);
 
+    ref.as(98.76);
+    BOOST_CHECK_EQUAL(ref.mantissa(), 987);
+    BOOST_CHECK_EQUAL(ref.exponent(), -1);
+
+    ref.as_fixed(-25, 0);
+    BOOST_CHECK_EQUAL(ref.mantissa(), -250);
+    BOOST_CHECK_EQUAL(ref.exponent(), -1);
+
+    // values which do not fit into the mantissa with the constant exponent
+    ref.as(1, 30);
+    BOOST_CHECK_THROW(ref.normalize(), std::range_error);
+    ref.as(INT64_MAX/10, 1);
+    BOOST_CHECK_THROW(ref.normalize(), std::range_error);
   }
   {
     mfast::decimal_type x;
@@ -448,6 +462,66 @@ BOOST_AUTO_TEST_CASE(decimal_field_test2)
 
 }
 
+BOOST_AUTO_TEST_CASE(decimal_conversion_test)
+{
+  int64_t mantissa;
+  int16_t exponent;
+
+  double_to_decimal(9664.3, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, 96643);
+  BOOST_CHECK_EQUAL(exponent, -1);
+
+  double_to_decimal(-0.000125, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, -125);
+  BOOST_CHECK_EQUAL(exponent, -6);
+
+  double_to_decimal(1.5e20, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, 15);
+  BOOST_CHECK_EQUAL(exponent, 19);
+
+  double_to_decimal(0.1 + 0.2, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, 30000000000000004LL);
+  BOOST_CHECK_EQUAL(exponent, -17);
+
+  double_to_decimal(0.0, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, 0);
+  BOOST_CHECK_EQUAL(exponent, 0);
+
+  BOOST_CHECK_THROW(double_to_decimal(1e100, mantissa, exponent), std::range_error);
+
+  // shortest decimals convert back to the same double
+  const double values[] = { 1.0/3, 2.0/3, 123456.789, 5e-324 * 1e300, 1.7976931348623157e50, 0.07 };
+  for (std::size_t i = 0; i < sizeof(values)/sizeof(values[0]); ++i) {
+    double_to_decimal(values[i], mantissa, exponent);
+    BOOST_CHECK_EQUAL(decimal_to_double(mantissa, exponent), values[i]);
+  }
+
+  BOOST_CHECK_EQUAL(decimal_to_double(12345, -2), 123.45);
+  BOOST_CHECK_EQUAL(decimal_to_double(7, 30), 7e30);
+  BOOST_CHECK_EQUAL(decimal_to_double(INT64_MAX, -40), 9223372036854775807e-40);
+
+  int64_t fixed = 0;
+  BOOST_CHECK(decimal_to_fixed(12345, -2, 4, fixed));
+  BOOST_CHECK_EQUAL(fixed, 1234500);
+  BOOST_CHECK(decimal_to_fixed(1234500, -4, 2, fixed));
+  BOOST_CHECK_EQUAL(fixed, 12345);
+  BOOST_CHECK(!decimal_to_fixed(12345, -3, 2, fixed));
+  BOOST_CHECK(!decimal_to_fixed(INT64_MAX/5, 0, 1, fixed));
+  BOOST_CHECK_EQUAL(fixed, 12345);
+
+  fixed_to_decimal(1234500, 4, mantissa, exponent);
+  BOOST_CHECK_EQUAL(mantissa, 12345);
+  BOOST_CHECK_EQUAL(exponent, -2);
+
+  decimal_type x;
+  x.mref().as_fixed(-990, 3);
+  BOOST_CHECK_EQUAL(x.cref().mantissa(), -99);
+  BOOST_CHECK_EQUAL(x.cref().exponent(), -2);
+  BOOST_CHECK(x.cref().to_fixed(2, fixed));
+  BOOST_CHECK_EQUAL(fixed, -99);
+  BOOST_CHECK(!x.cref().to_fixed(1, fixed));
+}
+
 BOOST_AUTO_TEST_CASE(string_field_instruction_test)
 {
   debug_allocator alloc;
@@ -689,6 +763,113 @@ BOOST_AUTO_TEST_CASE(string_delta_test)
 }
 
 
+BOOST_AUTO_TEST_CASE(small_string_inline_test)
+{
+  debug_allocator alloc;
+  value_storage storage;
+  ascii_field_instruction inst(operator_copy,
+                               presence_mandatory,
+                               1,
+                               "test_ascii","",
+                               0,
+                               string_value_storage());
+
+  inst.construct_value(storage, &alloc);
+
+  {
+    ascii_string_mref mref(&alloc, &storage, &inst);
+    mref.as("IBM");
+    BOOST_CHECK(storage.is_inline_array());
+    BOOST_CHECK_EQUAL(storage.of_array.capacity_in_bytes_, 0U);
+    BOOST_CHECK_EQUAL(static_cast<const void*>(mref.data()), static_cast<const void*>(&storage.of_array.content_));
+    BOOST_CHECK(mref == "IBM");
+    BOOST_CHECK_EQUAL(std::string(ascii_string_cref(mref).c_str()), "IBM");
+
+    mref += "USD";
+    BOOST_CHECK(storage.is_inline_array());
+    BOOST_CHECK(mref == "IBMUSD");
+
+    // the copy of a short string doesn't allocate memory either
+    value_storage copy;
+    inst.copy_construct_value(storage, copy, &alloc);
+    BOOST_CHECK(copy.is_inline_array());
+    BOOST_CHECK(ascii_string_cref(&copy, &inst) == "IBMUSD");
+    inst.destruct_value(copy, &alloc);
+
+    // grow beyond the inline capacity
+    mref += "abcdefg";
+    BOOST_CHECK(!storage.is_inline_array());
+    BOOST_CHECK_GT(storage.of_array.capacity_in_bytes_, 0U);
+    BOOST_CHECK(mref == "IBMUSDabcdefg");
+
+    // the allocated buffer is kept once it exists
+    mref.as("X");
+    BOOST_CHECK(!storage.is_inline_array());
+    BOOST_CHECK(mref == "X");
+
+    mref.refers_to("external");
+    BOOST_CHECK(!storage.is_inline_array());
+    BOOST_CHECK(mref == "external");
+  }
+
+  {
+    byte_vector_field_instruction byte_inst(operator_none,
+                                            presence_mandatory,
+                                            2,
+                                            "test_bytes","",
+                                            0,
+                                            byte_vector_value_storage(),
+                                            0, 0, 0);
+    value_storage bytes_storage;
+    byte_inst.construct_value(bytes_storage, &alloc);
+    byte_vector_mref mref(&alloc, &bytes_storage, &byte_inst);
+
+    const unsigned char data[] = { 1, 2, 3, 4, 5 };
+    mref.assign(data, data+5);
+    BOOST_CHECK(bytes_storage.is_inline_array());
+    BOOST_CHECK_EQUAL_COLLECTIONS(data, data+5, mref.begin(), mref.end());
+
+    // the elements of a saved value are copied as well
+    detail::codec_helper helper;
+    helper.save_previous_value(mref);
+    mref[0] = 9;
+    const value_storage& prev = helper.previous_value_of(mref);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data, data+5,
+                                  static_cast<const unsigned char*>(prev.array_content()),
+                                  static_cast<const unsigned char*>(prev.array_content()) + prev.array_length());
+
+    byte_inst.destruct_value(bytes_storage, &alloc);
+  }
+
+  inst.destruct_value(storage, &alloc);
+}
+
+BOOST_AUTO_TEST_CASE(array_capacity_limit_test)
+{
+  debug_allocator alloc;
+  value_storage storage;
+  ascii_field_instruction inst(operator_none,
+                               presence_mandatory,
+                               1,
+                               "test_ascii","",
+                               0,
+                               string_value_storage());
+
+  inst.construct_value(storage, &alloc);
+  {
+    ascii_string_mref mref(&alloc, &storage, &inst);
+    mref.as("ABCDEFGHIJ");
+    // capacity_in_bytes_ has 30 bits; the request fails before anything is allocated
+    BOOST_CHECK_THROW(mref.reserve(value_storage::max_array_capacity), std::length_error);
+    BOOST_CHECK(mref == "ABCDEFGHIJ");
+  }
+  inst.destruct_value(storage, &alloc);
+
+  BOOST_CHECK_EQUAL(array_capacity(value_storage::max_array_capacity),
+                    static_cast<uint32_t>(value_storage::max_array_capacity));
+  BOOST_CHECK_THROW(array_capacity(value_storage::max_array_capacity + 1U), std::length_error);
+}
+
 BOOST_AUTO_TEST_CASE(group_field_test)
 {
   debug_allocator alloc;
@@ -749,6 +930,21 @@ BOOST_AUTO_TEST_CASE(group_field_test)
     BOOST_CHECK_EQUAL(cf1.field_type(), field_type_unicode_string);
   }
 
+  {
+    group_cref ref(&storage, &group_inst);
+    field_cref f0( ref[0] );
+    field_cref f1( ref[1] );
+
+    // the casts follow the instruction class hierarchy
+    BOOST_CHECK_EQUAL(dynamic_cast_as<byte_vector_cref>(f0).instruction(), &inst0);
+    BOOST_CHECK_EQUAL(dynamic_cast_as<unicode_string_cref>(f0).instruction(), &inst0);
+    BOOST_CHECK_EQUAL(dynamic_cast_as<ascii_string_cref>(f1).instruction(), &inst1);
+    BOOST_CHECK_THROW(dynamic_cast_as<byte_vector_cref>(f1), std::bad_cast);
+    BOOST_CHECK_THROW(dynamic_cast_as<int32_cref>(f1), std::bad_cast);
+    BOOST_CHECK_THROW(dynamic_cast_as<sequence_cref>(field_cref(&storage, &group_inst)), std::bad_cast);
+    BOOST_CHECK_EQUAL(dynamic_cast_as<group_cref>(field_cref(&storage, &group_inst)).instruction(), &group_inst);
+  }
+
   {
     group_mref ref(&alloc, &storage, &group_inst);
     BOOST_CHECK_EQUAL(ref.present(),    true);
@@ -1032,7 +1228,29 @@ BOOST_AUTO_TEST_CASE(sequence_resize_test)
     ref.resize(1);
     BOOST_CHECK_EQUAL(mock0.construct_value_called_, 2);
     BOOST_CHECK_EQUAL(mock0.destruct_value_called_,  0);
+    BOOST_CHECK_EQUAL(ref.capacity(),                2U);
+
+    // growing within the capacity reuses the constructed elements
+    ref.resize(2);
+    BOOST_CHECK_EQUAL(mock0.construct_value_called_, 2);
+    BOOST_CHECK_EQUAL(mock0.destruct_value_called_,  0);
+
+    ref.resize(1);
+    ref.shrink_to_fit();
+    BOOST_CHECK_EQUAL(ref.size(),                    1U);
+    BOOST_CHECK_EQUAL(ref.capacity(),                1U);
+    BOOST_CHECK_EQUAL(mock0.construct_value_called_, 2);
+    BOOST_CHECK_EQUAL(mock0.destruct_value_called_,  1);
+
+    ref.resize(3);
+    BOOST_CHECK_EQUAL(ref.capacity(),                3U);
+    BOOST_CHECK_EQUAL(mock0.construct_value_called_, 4);
+    BOOST_CHECK_EQUAL(mock0.destruct_value_called_,  1);
 
+    ref.resize(0);
+    ref.shrink_to_fit();
+    BOOST_CHECK_EQUAL(ref.capacity(),                0U);
+    BOOST_CHECK_EQUAL(mock0.destruct_value_called_,  4);
   }
 
   sequence_inst.destruct_value(storage, &alloc);
@@ -0,0 +1,103 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/flat_message.h>
+#include <mfast/field_path.h>
+#include <mfast/xml_parser/dynamic_templates_description.h>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "debug_allocator.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( flat_message_test_suite )
+
+BOOST_AUTO_TEST_CASE(flat_message_relocate_test)
+{
+  dynamic_templates_description description(
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Flat\" id=\"1\">\n"
+    "  <uInt32 name=\"field1\" id=\"11\"/>\n"
+    "  <decimal name=\"field2\" id=\"12\"/>\n"
+    "  <group name=\"group1\" presence=\"optional\">\n"
+    "    <int64 name=\"field3\" id=\"13\"/>\n"
+    "    <group name=\"group2\">\n"
+    "      <uInt32 name=\"field4\" id=\"14\"/>\n"
+    "    </group>\n"
+    "  </group>\n"
+    "</template>\n"
+    "<template name=\"NotFlat\" id=\"2\">\n"
+    "  <uInt32 name=\"field1\" id=\"11\"/>\n"
+    "  <string name=\"field2\" id=\"12\"/>\n"
+    "</template>\n"
+    "</templates>\n");
+
+  const template_instruction* inst = description[0];
+  BOOST_CHECK(flat_message::is_flat(inst));
+  BOOST_CHECK(!flat_message::is_flat(description[1]));
+  BOOST_CHECK_THROW(flat_message msg(description[1]), std::invalid_argument);
+
+  // three top level fields, two in group1 and one in group2
+  BOOST_CHECK_EQUAL(flat_message::block_size(inst), 6*sizeof(value_storage));
+
+  debug_allocator alloc;
+  message_type tree(&alloc, inst);
+  message_mref tree_ref = tree.mref();
+  tree_ref[0].as(10);
+  tree_ref[1].as(decimal(12345, -2));
+
+  flat_message absent_group(tree.cref());
+  BOOST_CHECK(absent_group.cref() == tree.cref());
+  BOOST_CHECK(absent_group.cref()[2].absent());
+
+  group_mref group1(tree_ref[2]);
+  group1[0].as(-7);
+  group_mref(group1[1])[0].as(99);
+
+  flat_message flat(tree.cref());
+  BOOST_CHECK_EQUAL(flat.size(), flat_message::block_size(inst));
+  BOOST_CHECK(flat.cref() == tree.cref());
+
+  // a flat message stays valid after being moved around with memcpy
+  std::vector<value_storage> buffer(flat.size()/sizeof(value_storage));
+  std::memcpy(buffer.data(), flat.data(), flat.size());
+  message_cref relocated = flat_message::cref(inst, buffer.data());
+  BOOST_CHECK(relocated == tree.cref());
+
+  field_path field4(inst, "group1.group2.field4");
+  uint32_mref(field4.get(flat_message::mref(inst, buffer.data()))).as(100);
+  BOOST_CHECK_EQUAL(uint32_cref(field4.get(relocated)).value(), 100U);
+  BOOST_CHECK_EQUAL(uint32_cref(field4.get(flat.cref())).value(), 99U);
+
+  // copy a flat message back into a regular one
+  message_type back(relocated, &alloc);
+  BOOST_CHECK(back.cref() == relocated);
+
+  flat_message::assign(tree.cref(), buffer.data());
+  BOOST_CHECK(relocated == tree.cref());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,10 +23,15 @@
 
 #include <mfast.h>
 #include <mfast/coder/fast_encoder.h>
+#include <mfast/coder/fast_decoder.h>
+#include <mfast/coder/encoder/fast_ostream.h>
+#include <mfast/coder/encoder/resizable_fast_ostreambuf.h>
 #include <mfast/vector_ref.h>
 #include <mfast/coder/common/codec_helper.h>
 #include <mfast/xml_parser/dynamic_templates_description.h>
 #include <boost/mpl/list.hpp>
+#include <limits>
+#include <string>
 
 
 typedef boost::mpl::list<int,long,unsigned char> test_types;
@@ -182,4 +187,100 @@ BOOST_AUTO_TEST_CASE (test_fast_encoding)
     BOOST_CHECK(std::equal(buffer1.begin(), buffer1.end(), buffer2.begin()));
 }
 
+template <typename T>
+struct int_type_name;
+
+template <>
+struct int_type_name<int32_t>
+{
+  static const char* value() { return "int32"; }
+};
+
+template <>
+struct int_type_name<uint32_t>
+{
+  static const char* value() { return "uInt32"; }
+};
+
+template <>
+struct int_type_name<int64_t>
+{
+  static const char* value() { return "int64"; }
+};
+
+template <>
+struct int_type_name<uint64_t>
+{
+  static const char* value() { return "uInt64"; }
+};
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( test_fast_bulk_coding, T, test_types )
+{
+  std::string xml_desc =
+    "<?xml version=\" 1.0 \"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/template-definition\" "
+    "templateNs=\"http://www.fixprotocol.org/ns/templates/sample\" ns=\"http://www.fixprotocol.org/ns/fix\">\n"
+    "<template name=\"Test\" id=\"1\">\n"
+    "<uInt32 name=\"field1\" id=\"11\"><copy/></uInt32>\n"
+    "<" + std::string(int_type_name<T>::value()) + "Vector name=\"field2\" id=\"12\" />\n"
+    "</template>\n"
+    "</templates>\n";
+
+  // every encoded length from 1 to 10 bytes, followed by a long run of mixed lengths
+  std::vector<T> values;
+  for (int b = 0; b < std::numeric_limits<T>::digits; ++b) {
+    T v = static_cast<T>(T(1) << b);
+    values.push_back(v);
+    values.push_back(v-1);
+    if (std::is_signed<T>::value) {
+      values.push_back(-v);
+      values.push_back(-v-1);
+    }
+  }
+  values.push_back((std::numeric_limits<T>::max)());
+  values.push_back((std::numeric_limits<T>::min)());
+  for (uint64_t i = 0; i < 300; ++i)
+    values.push_back(static_cast<T>((i * 0x9E3779B97F4A7C15ULL) >> (i % 64)));
+
+  debug_allocator alloc;
+
+  // the integers encoded one by one
+  std::vector<char> expected;
+  {
+    resizable_fast_ostreambuf sb(expected);
+    fast_ostream strm(&alloc);
+    strm.rdbuf(&sb);
+    for (std::size_t i = 0; i < values.size(); ++i)
+      strm.encode(values[i], false, false);
+    expected.resize(sb.length());
+  }
+
+  dynamic_templates_description desc(xml_desc.c_str());
+  message_type message(&alloc, desc[0]);
+  message.mref()[0].as(1U);
+  int_vector_mref<T> field2(message.mref()[1]);
+  field2.assign(values.begin(), values.end());
+
+  const templates_description* descriptions[] = { &desc };
+  mfast::fast_encoder encoder;
+  encoder.include(descriptions);
+  std::vector<char> buffer;
+  encoder.encode(message.cref(), buffer);
+
+  // the presence map, field1 and the 2 byte length precede the elements
+  BOOST_REQUIRE_EQUAL(buffer.size(), expected.size() + 4);
+  BOOST_CHECK(std::equal(expected.begin(), expected.end(), buffer.begin() + 4));
+
+  mfast::fast_decoder decoder;
+  decoder.include(descriptions);
+  const char* first = &buffer[0];
+  message_cref result = decoder.decode(first, first + buffer.size(), true);
+  BOOST_CHECK(result == message.cref());
+  BOOST_CHECK(first == &buffer[0] + buffer.size());
+
+  // the last integer is cut short
+  first = &buffer[0];
+  BOOST_CHECK_THROW(decoder.decode(first, first + buffer.size() - 1, true), mfast::fast_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
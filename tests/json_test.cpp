@@ -20,6 +20,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "test3.h"
+#include "simple10.h"
 #include <mfast/json/json.h>
 #include <sstream>
 #include "debug_allocator.h"
@@ -516,4 +517,27 @@ BOOST_AUTO_TEST_CASE(test_decimal_input)
 }
 
 
+BOOST_AUTO_TEST_CASE(test_decode_utf8_validation)
+{
+  simple10::Test msg;
+
+  {
+    std::stringstream strm("{\"field1\":\"caf\xC3\xA9\"}");
+    mfast::json::decode(strm, msg.mref(), 0, true);
+    BOOST_CHECK_EQUAL(msg.cref().get_field1().value(), boost::string_ref("caf\xC3\xA9"));
+  }
+  {
+    std::stringstream strm("{\"field1\":\"caf\xC3\x28\"}");
+    mfast::json::decode(strm, msg.mref());
+    std::stringstream strm2("{\"field1\":\"caf\xC3\x28\"}");
+    BOOST_CHECK_THROW(mfast::json::decode(strm2, msg.mref(), 0, true), std::runtime_error);
+  }
+  {
+    // an unpaired surrogate
+    std::stringstream strm("{\"field1\":\"\\ud800\"}");
+    BOOST_CHECK_THROW(mfast::json::decode(strm, msg.mref(), 0, true), std::runtime_error);
+  }
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
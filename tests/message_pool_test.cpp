@@ -0,0 +1,145 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast/message_pool.h>
+#include <mfast/field_comparator.h>
+#include <thread>
+
+#include "test3.h"
+#include "debug_allocator.h"
+
+using namespace mfast;
+
+namespace {
+
+  class counting_allocator
+    : public debug_allocator
+  {
+  public:
+    counting_allocator()
+      : count_(0)
+    {
+    }
+
+    virtual void* allocate(std::size_t s)
+    {
+      ++count_;
+      return debug_allocator::allocate(s);
+    }
+
+    virtual std::size_t reallocate(void*& pointer, std::size_t old_size, std::size_t new_size)
+    {
+      ++count_;
+      return debug_allocator::reallocate(pointer, old_size, new_size);
+    }
+
+    std::size_t count_;
+  };
+
+  void fill_person(test3::Person_mref person,
+                   const char*        last_name,
+                   std::size_t        num_phones,
+                   uint64_t           account_number)
+  {
+    using namespace test3;
+
+    person.set_firstName().as("John");
+    person.set_lastName().as(last_name);
+    person.set_age().as(25);
+
+    Person_mref::phoneNumbers_mref phones = person.set_phoneNumbers();
+    phones.resize(num_phones);
+    for (std::size_t i = 0; i < num_phones; ++i) {
+      phones[i].set_type().as("home");
+      phones[i].set_number().as("212 555-1234");
+    }
+
+    LoginAccount_mref login = person.set_login().as<LoginAccount>();
+    login.set_userName().as("jsmith");
+    login.set_password().as("J0hnsm1th");
+
+    person.set_bankAccounts().resize(1);
+    BankAccount_mref acct = person.set_bankAccounts()[0].as<BankAccount>();
+    acct.set_number().as(account_number);
+    acct.set_routingNumber().as(87654321);
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE( message_pool_test_suite )
+
+BOOST_AUTO_TEST_CASE(message_pool_recycle_test)
+{
+  using namespace test3;
+
+  Person person_holder;
+  fill_person(person_holder.mref(), "Smith-Williamson-Johnson", 3, 12345678);
+
+  counting_allocator alloc;
+  {
+    message_pool pool(&alloc);
+
+    pooled_message msg1 = pool.copy(person_holder.cref());
+    BOOST_CHECK(msg1.cref() == person_holder.cref());
+    BOOST_CHECK_EQUAL(msg1.use_count(), 1);
+
+    const value_storage* storage = aggregate_cref_core_access::storage_of(msg1.cref());
+    {
+      pooled_message msg2(msg1);
+      BOOST_CHECK_EQUAL(msg1.use_count(), 2);
+    }
+    BOOST_CHECK_EQUAL(msg1.use_count(), 1);
+    BOOST_CHECK_EQUAL(pool.idle_count(person_holder.cref().instruction()), 0U);
+
+    msg1.reset();
+    BOOST_CHECK(msg1.empty());
+    BOOST_CHECK_EQUAL(pool.idle_count(person_holder.cref().instruction()), 1U);
+
+    // copying a message no larger than before reuses the idle one without any allocation
+    fill_person(person_holder.mref(), "Smith", 2, 99);
+    std::size_t count = alloc.count_;
+    pooled_message msg3 = pool.copy(person_holder.cref());
+    BOOST_CHECK_EQUAL(alloc.count_, count);
+    BOOST_CHECK_EQUAL(aggregate_cref_core_access::storage_of(msg3.cref()), storage);
+    BOOST_CHECK(msg3.cref() == person_holder.cref());
+    BOOST_CHECK_EQUAL(pool.idle_count(person_holder.cref().instruction()), 0U);
+
+    // the copy doesn't refer to the source
+    person_holder.mref().set_lastName().as("Jones");
+    BOOST_CHECK(Person_cref(msg3.cref()).get_lastName().value() == "Smith");
+
+    // a longer message grows the recycled one
+    fill_person(person_holder.mref(), "Smith-Williamson-Johnson-Taylor", 4, 1);
+    msg3.reset();
+    pooled_message msg4 = pool.copy(person_holder.cref());
+    BOOST_CHECK(msg4.cref() == person_holder.cref());
+
+    // handles released by another thread give the message back to the pool
+    std::thread worker([](pooled_message msg) {
+      BOOST_CHECK_EQUAL(Person_cref(msg.cref()).get_phoneNumbers().size(), 4U);
+    }, std::move(msg4));
+    worker.join();
+    BOOST_CHECK_EQUAL(pool.idle_count(person_holder.cref().instruction()), 1U);
+  }
+  // all the memory has been released when the pool is gone; otherwise ~debug_allocator() complains
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast/message_snapshot.h>
+#include <mfast/field_comparator.h>
+#include <thread>
+#include <vector>
+
+#include "test3.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( message_snapshot_test_suite )
+
+BOOST_AUTO_TEST_CASE(message_snapshot_share_test)
+{
+  using namespace test3;
+
+  Person person_holder;
+  Person_mref person = person_holder.mref();
+  person.set_firstName().as("John");
+  person.set_lastName().as("Smith-Williamson-Johnson");
+  person.set_age().as(25);
+  Person_mref::phoneNumbers_mref phones = person.set_phoneNumbers();
+  phones.resize(2);
+  phones[0].set_type().as("home");
+  phones[0].set_number().as("212 555-1234");
+  phones[1].set_type().as("fax");
+  phones[1].set_number().as("646 555-4567");
+  LoginAccount_mref login = person.set_login().as<LoginAccount>();
+  login.set_userName().as("jsmith");
+  login.set_password().as("a rather long password of a rather careful user");
+
+  message_snapshot snapshot(person_holder.cref());
+  BOOST_CHECK_EQUAL(snapshot.use_count(), 1);
+  BOOST_CHECK(snapshot.cref() == person_holder.cref());
+
+  // the whole message is in a single allocation
+  const char* begin = static_cast<const char*>(snapshot.data());
+  const char* last_name = Person_cref(snapshot.cref()).get_lastName().c_str();
+  BOOST_CHECK(last_name > begin && last_name < begin + snapshot.size());
+
+  // the snapshot doesn't refer to the source
+  person.set_lastName().as("Jones");
+  BOOST_CHECK(Person_cref(snapshot.cref()).get_lastName() == "Smith-Williamson-Johnson");
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.push_back(std::thread([](message_snapshot s) {
+      Person_cref p(s.cref());
+      BOOST_CHECK_EQUAL(p.get_phoneNumbers().size(), 2U);
+      BOOST_CHECK(p.get_phoneNumbers()[1].get_type() == "fax");
+    }, snapshot));
+  }
+  for (std::size_t i = 0; i < readers.size(); ++i)
+    readers[i].join();
+  BOOST_CHECK_EQUAL(snapshot.use_count(), 1);
+
+  message_snapshot copy(snapshot);
+  BOOST_CHECK_EQUAL(snapshot.use_count(), 2);
+  BOOST_CHECK_EQUAL(copy.data(), snapshot.data());
+  snapshot.reset();
+  BOOST_CHECK(snapshot.empty());
+  BOOST_CHECK_EQUAL(copy.use_count(), 1);
+  BOOST_CHECK(Person_cref(copy.cref()).get_age().value() == 25U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
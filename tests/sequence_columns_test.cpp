@@ -0,0 +1,93 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/sequence_columns.h>
+#include <stdexcept>
+#include <string>
+
+#include "test2.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( sequence_columns_test_suite )
+
+BOOST_AUTO_TEST_CASE(sequence_columns_extract_test)
+{
+  test2::MDRefreshSample sample;
+  test2::MDRefreshSample_mref::MDEntries_mref entries = sample.mref().set_MDEntries();
+  entries.resize(3);
+  const char* symbols[] = { "MSFT", "IBM", "GOOGLE" };
+  for (std::size_t i = 0; i < 3; ++i) {
+    entries[i].set_Symbol().as(symbols[i]);
+    entries[i].set_NumberOfOrders().as(10*i + 1);
+    entries[i].set_MDEntryPx().as(12345 + i, -2);
+    entries[i].set_MDEntrySize().as(100*i, -2);
+  }
+  entries[1].set_SecurityID().as("ID1");
+
+  const sequence_field_instruction* inst = entries.instruction();
+  sequence_column_extractor extractor(inst);
+  BOOST_CHECK_THROW(extractor.field_index("NoSuchField"), std::invalid_argument);
+
+  int64_t orders[3];
+  int64_t px_mantissas[3];
+  int16_t px_exponents[3];
+  int64_t size_mantissas[3];
+  int16_t size_exponents[3];
+  uint32_t symbol_offsets[4];
+  char symbol_data[16];
+  uint32_t id_offsets[4];
+  char id_data[4];
+  uint8_t id_present[3];
+
+  sequence_cref seq = sample.cref().get_MDEntries();
+  BOOST_CHECK_EQUAL(extractor.string_data_size(seq, extractor.field_index("Symbol")), 13U);
+
+  sequence_column columns[] = {
+    sequence_column::integers(extractor.field_index("NumberOfOrders"), orders),
+    sequence_column::decimals(extractor.field_index("MDEntryPx"), px_mantissas, px_exponents),
+    sequence_column::decimals(extractor.field_index("MDEntrySize"), size_mantissas, size_exponents),
+    sequence_column::strings(extractor.field_index("Symbol"), symbol_offsets, symbol_data, sizeof(symbol_data)),
+    sequence_column::strings(extractor.field_index("SecurityID"), id_offsets, id_data, sizeof(id_data), id_present)
+  };
+  extractor.extract(seq, columns, 5);
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    BOOST_CHECK_EQUAL(orders[i], int64_t(10*i + 1));
+    BOOST_CHECK_EQUAL(px_mantissas[i], int64_t(12345 + i));
+    BOOST_CHECK_EQUAL(px_exponents[i], -2);
+    BOOST_CHECK_EQUAL(size_mantissas[i], int64_t(100*i));
+    BOOST_CHECK_EQUAL(std::string(symbol_data + symbol_offsets[i], symbol_data + symbol_offsets[i+1]),
+                      symbols[i]);
+    BOOST_CHECK_EQUAL(id_present[i], i == 1);
+  }
+  BOOST_CHECK_EQUAL(id_offsets[1], 0U);
+  BOOST_CHECK_EQUAL(id_offsets[2], 3U);
+  BOOST_CHECK_EQUAL(id_offsets[3], 3U);
+
+  sequence_column wrong_type = sequence_column::integers(extractor.field_index("Symbol"), orders);
+  BOOST_CHECK_THROW(extractor.extract(seq, &wrong_type, 1), std::invalid_argument);
+  sequence_column too_small = sequence_column::strings(extractor.field_index("Symbol"), symbol_offsets, symbol_data, 12);
+  BOOST_CHECK_THROW(extractor.extract(seq, &too_small, 1), std::length_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,354 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/coder/fast_encoder_v2.h>
+#include <mfast/coder/fast_decoder_v2.h>
+#include <mfast/coder/shm_frame_ring.h>
+#include <thread>
+#include <sstream>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "simple1.h"
+#include "simple8.h"
+#include "simple11.h"
+
+using namespace mfast;
+
+namespace {
+  std::string ring_name()
+  {
+    std::stringstream strm;
+    strm << "/mfast_ring_test_" << ::getpid();
+    return strm.str();
+  }
+
+  struct field1_collector
+  {
+    std::vector<uint32_t>* values_;
+
+    void operator() (const message_cref& msg)
+    {
+      simple1::Test_cref ref(msg);
+      values_->push_back(ref.get_field1().value());
+    }
+  };
+
+  // Pad field9 so that the next message of encoder encodes to exactly size bytes.
+  void set_encoded_size(fast_encoder_v2& encoder, simple11::Test_mref msg, std::size_t size)
+  {
+    msg.set_field9().as("x");
+    std::size_t base = encoder.encoded_size(msg) - 1;
+    msg.set_field9().as(std::string(size - base, 'x'));
+  }
+
+  std::vector<std::string> pop_field9(shm_frame_ring& consumer, fast_decoder_v2<0>& decoder)
+  {
+    std::vector<std::string> values;
+    auto collect = [&values](const message_cref& m) {
+      simple11::Test_cref ref(m);
+      values.push_back(ref.get_field9().value());
+    };
+    while (consumer.try_pop(decoder, collect))
+      ;
+    return values;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( test_shm_frame_ring )
+
+BOOST_AUTO_TEST_CASE(encode_decode_in_place)
+{
+  std::string name = ring_name();
+  // two cells, each holding a whole frame
+  shm_frame_ring producer(name.c_str(), 128);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  BOOST_CHECK_EQUAL(consumer.capacity(), 128U);
+
+  fast_encoder_v2 encoder(simple1::templates_description::instance());
+  fast_decoder_v2<0> decoder(simple1::templates_description::instance());
+
+  simple1::Test msg;
+  simple1::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field2().as(2);
+  msg_ref.set_field3().as(3);
+
+  std::vector<uint32_t> values;
+  field1_collector collector = { &values };
+
+  BOOST_CHECK(!consumer.try_pop(decoder, collector));
+
+  msg_ref.set_field1().as(1);
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+  msg_ref.set_field1().as(2);
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+  // the ring is full
+  msg_ref.set_field1().as(3);
+  BOOST_CHECK(!producer.try_push(encoder, msg_ref));
+
+  BOOST_CHECK(consumer.try_pop(decoder, collector));
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+  BOOST_CHECK(consumer.try_pop(decoder, collector));
+  BOOST_CHECK(consumer.try_pop(decoder, collector));
+  BOOST_CHECK(!consumer.try_pop(decoder, collector));
+
+  BOOST_REQUIRE_EQUAL(values.size(), 3U);
+  BOOST_CHECK_EQUAL(values[0], 1U);
+  BOOST_CHECK_EQUAL(values[1], 2U);
+  BOOST_CHECK_EQUAL(values[2], 3U);
+
+  // an abandoned reservation is skipped by the consumer
+  shm_frame_ring::frame f;
+  BOOST_CHECK(producer.try_reserve(f, 10));
+  BOOST_CHECK_EQUAL(f.size(), 64U);
+  producer.commit(f, 0);
+  BOOST_CHECK(!consumer.try_acquire(f));
+}
+
+BOOST_AUTO_TEST_CASE(variable_length_frames)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 256);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  shm_frame_ring::frame f;
+  BOOST_REQUIRE(producer.try_reserve(f, 10));
+  BOOST_CHECK_EQUAL(f.size(), 64U);
+  std::memset(f.data(), 'a', 10);
+  producer.commit(f, 10);
+
+  BOOST_REQUIRE(producer.try_reserve(f, 100));
+  BOOST_CHECK_EQUAL(f.size(), 128U);
+  std::memset(f.data(), 'b', 100);
+  producer.commit(f, 100);
+
+  // the last cell becomes padding, but the first cell is still in use
+  BOOST_CHECK(!producer.try_reserve(f, 100));
+
+  BOOST_REQUIRE(consumer.try_acquire(f));
+  BOOST_CHECK_EQUAL(f.size(), 10U);
+  BOOST_CHECK_EQUAL(f.data()[9], 'a');
+  consumer.release(f);
+
+  // the frame starts over at the first cell
+  BOOST_REQUIRE(producer.try_reserve(f, 64));
+  std::memset(f.data(), 'c', 64);
+  producer.commit(f, 64);
+
+  BOOST_REQUIRE(consumer.try_acquire(f));
+  BOOST_CHECK_EQUAL(f.size(), 100U);
+  BOOST_CHECK_EQUAL(f.data()[99], 'b');
+  consumer.release(f);
+
+  BOOST_REQUIRE(consumer.try_acquire(f));
+  BOOST_CHECK_EQUAL(f.size(), 64U);
+  BOOST_CHECK_EQUAL(f.data()[63], 'c');
+  consumer.release(f);
+  BOOST_CHECK(!consumer.try_acquire(f));
+
+  BOOST_CHECK_THROW(producer.try_reserve(f, 257), buffer_overflow_error);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_producer_consumer)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 512);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  const uint32_t num_messages = 10000;
+
+  std::thread producer_thread([&producer, num_messages]() {
+    fast_encoder_v2 encoder(simple1::templates_description::instance());
+    simple1::Test msg;
+    simple1::Test_mref msg_ref = msg.mref();
+    msg_ref.set_field2().as(2);
+    msg_ref.set_field3().as(3);
+    for (uint32_t i = 0; i < num_messages; ++i) {
+      msg_ref.set_field1().as(i);
+      while (!producer.try_push(encoder, msg_ref))
+        std::this_thread::yield();
+    }
+  });
+
+  fast_decoder_v2<0> decoder(simple1::templates_description::instance());
+  std::vector<uint32_t> values;
+  field1_collector collector = { &values };
+  while (values.size() < num_messages) {
+    if (!consumer.try_pop(decoder, collector))
+      std::this_thread::yield();
+  }
+  producer_thread.join();
+
+  bool in_order = true;
+  for (uint32_t i = 0; i < num_messages; ++i)
+    in_order = in_order && values[i] == i;
+  BOOST_CHECK(in_order);
+}
+
+BOOST_AUTO_TEST_CASE(frames_sized_by_encoded_size)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 512);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  fast_encoder_v2 encoder(simple8::templates_description::instance());
+  fast_decoder_v2<0> decoder(simple8::templates_description::instance());
+
+  simple8::Test msg;
+  simple8::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as(1);
+  msg_ref.set_field2().as(std::string(150, 'x'));
+  msg_ref.set_field3().as("abc");
+
+  // each frame takes three cells
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+  msg_ref.set_field2().as(std::string(150, 'y'));
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+  msg_ref.set_field2().as(std::string(150, 'z'));
+  BOOST_CHECK(!producer.try_push(encoder, msg_ref));
+
+  // a frame longer than the ring leaves the encoder dictionary untouched
+  msg_ref.set_field2().as(std::string(600, 'w'));
+  BOOST_CHECK_THROW(producer.try_push(encoder, msg_ref), buffer_overflow_error);
+
+  std::vector<std::string> values;
+  auto collect = [&values](const message_cref& m) {
+    simple8::Test_cref ref(m);
+    values.push_back(ref.get_field2().value());
+  };
+  BOOST_CHECK(consumer.try_pop(decoder, collect));
+
+  // the two cells at the end of the ring were turned into padding by the failed push
+  msg_ref.set_field2().as(std::string(150, 'z'));
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+
+  BOOST_CHECK(consumer.try_pop(decoder, collect));
+  BOOST_CHECK(consumer.try_pop(decoder, collect));
+  BOOST_CHECK(!consumer.try_pop(decoder, collect));
+
+  BOOST_REQUIRE_EQUAL(values.size(), 3U);
+  BOOST_CHECK_EQUAL(values[0], std::string(150, 'x'));
+  BOOST_CHECK_EQUAL(values[1], std::string(150, 'y'));
+  BOOST_CHECK_EQUAL(values[2], std::string(150, 'z'));
+}
+
+BOOST_AUTO_TEST_CASE(frames_filling_whole_cells)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 128);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  fast_encoder_v2 encoder(simple11::templates_description::instance());
+  fast_decoder_v2<0> decoder(simple11::templates_description::instance());
+
+  simple11::Test msg;
+  simple11::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as(1);
+  msg_ref.set_field2().as(2);
+  msg_ref.set_field3().as(3);
+  msg_ref.set_field4().as(4);
+  msg_ref.set_field5().as(5);
+  msg_ref.set_field6().as(6);
+  msg_ref.set_field7().as(7);
+  msg_ref.set_field8().as(8);
+
+  // a message of exactly one cell must not overflow its frame
+  set_encoded_size(encoder, msg_ref, 64);
+  BOOST_REQUIRE_EQUAL(encoder.encoded_size(msg_ref), 64U);
+  std::string first = msg_ref.get_field9().value();
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+
+  set_encoded_size(encoder, msg_ref, 64);
+  BOOST_REQUIRE_EQUAL(encoder.encoded_size(msg_ref), 64U);
+  std::string second = msg_ref.get_field9().value();
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+
+  std::vector<std::string> values = pop_field9(consumer, decoder);
+  BOOST_REQUIRE_EQUAL(values.size(), 2U);
+  BOOST_CHECK_EQUAL(values[0], first);
+  BOOST_CHECK_EQUAL(values[1], second);
+}
+
+BOOST_AUTO_TEST_CASE(frames_without_overlong_pmap)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 256);
+  shm_frame_ring consumer(name.c_str());
+  shm_frame_ring::remove(name.c_str());
+
+  fast_encoder_v2 encoder(simple11::templates_description::instance());
+  encoder.allow_overlong_pmap(false);
+  fast_decoder_v2<0> decoder(simple11::templates_description::instance());
+
+  simple11::Test msg;
+  simple11::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as(1);
+  msg_ref.set_field2().as(2);
+  msg_ref.set_field3().as(3);
+  msg_ref.set_field4().as(4);
+  msg_ref.set_field5().as(5);
+  msg_ref.set_field6().as(6);
+  msg_ref.set_field7().as(7);
+  msg_ref.set_field8().as(8);
+
+  set_encoded_size(encoder, msg_ref, 64);
+  std::string first = msg_ref.get_field9().value();
+  BOOST_CHECK_EQUAL(encoder.required_buffer_size(msg_ref), 64U);
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+
+  // all copied fields are unchanged now, so the two byte presence map is shrunk
+  // to one byte only after the encoder has occupied both
+  set_encoded_size(encoder, msg_ref, 64);
+  std::string second = msg_ref.get_field9().value();
+  BOOST_REQUIRE_EQUAL(encoder.encoded_size(msg_ref), 64U);
+  BOOST_CHECK_EQUAL(encoder.required_buffer_size(msg_ref), 65U);
+  BOOST_CHECK(producer.try_push(encoder, msg_ref));
+
+  std::vector<std::string> values = pop_field9(consumer, decoder);
+  BOOST_REQUIRE_EQUAL(values.size(), 2U);
+  BOOST_CHECK_EQUAL(values[0], first);
+  BOOST_CHECK_EQUAL(values[1], second);
+}
+
+BOOST_AUTO_TEST_CASE(reject_truncated_ring)
+{
+  std::string name = ring_name();
+  shm_frame_ring producer(name.c_str(), 256);
+
+  int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+  BOOST_REQUIRE(fd != -1);
+  BOOST_REQUIRE(::ftruncate(fd, 256) == 0);
+  ::close(fd);
+
+  BOOST_CHECK_THROW(shm_frame_ring consumer(name.c_str()), shm_frame_ring_error);
+  shm_frame_ring::remove(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
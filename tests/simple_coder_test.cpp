@@ -21,10 +21,15 @@
 
 #include <mfast.h>
 #include <mfast/field_comparator.h>
+#include <mfast/coder/fast_encoder.h>
 #include <mfast/coder/fast_encoder_v2.h>
 #include <mfast/coder/fast_decoder_v2.h>
+#include <mfast/coder/fast_pod_encoder.h>
+#include <mfast/coder/fast_pod_decoder.h>
+#include <mfast/coder/encoder/pooled_fast_ostreambuf.h>
 #include <cstring>
 #include <stdexcept>
+#include <type_traits>
 
 #include "simple1.h"
 #include "simple2.h"
@@ -33,6 +38,9 @@
 #include "simple5.h"
 #include "simple6.h"
 #include "simple7.h"
+#include "simple8.h"
+#include "simple9.h"
+#include "simple10.h"
 
 #include "byte_stream.h"
 #include "debug_allocator.h"
@@ -55,16 +63,20 @@ class fast_coding_test_case
       const int buffer_size = 128;
       char buffer[buffer_size];
 
+      std::size_t expected_size = encoder_.encoded_size(msg_ref, reset);
+
       std::size_t encoded_size = encoder_.encode(msg_ref,
                                                  buffer,
                                                  buffer_size,
                                                  reset);
 
-      if (result == byte_stream(buffer, encoded_size))
+      if (result == byte_stream(buffer, encoded_size) && expected_size == encoded_size)
         return true;
 
       boost::test_tools::predicate_result res( false );
       res.message() << "Got \"" << byte_stream(buffer, encoded_size) << "\" instead.";
+      if (expected_size != encoded_size)
+        res.message() << " encoded_size() returned " << expected_size << ".";
       return res;
     }
 
@@ -108,6 +120,43 @@ BOOST_AUTO_TEST_CASE(simple_coder_test)
   BOOST_CHECK(test_case.decoding("\xB8\x81\x82\x83", msg_ref));
 }
 
+BOOST_AUTO_TEST_CASE(changed_fields_test)
+{
+  debug_allocator alloc;
+  mfast::fast_encoder_v2 encoder(simple2::templates_description::instance(), &alloc);
+  mfast::fast_decoder_v2<0> decoder(simple2::templates_description::instance(), &alloc);
+  decoder.report_changed_fields(true);
+
+  simple2::Test msg(&alloc);
+  simple2::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as(1);
+
+  char buffer[128];
+  std::size_t encoded_size = encoder.encode(msg_ref, buffer, sizeof(buffer));
+  const char* first = buffer;
+  decoder.decode(first, buffer + encoded_size);
+  BOOST_CHECK(decoder.field_changed(0));
+  BOOST_CHECK(decoder.field_changed(1));
+
+  // field1 is copied from the previous message
+  msg_ref.set_group1().set_field2().as(2);
+  msg_ref.set_group1().set_field3().as(3);
+  encoded_size = encoder.encode(msg_ref, buffer, sizeof(buffer));
+  first = buffer;
+  simple2::Test_cref result(decoder.decode(first, buffer + encoded_size));
+  BOOST_CHECK(msg_ref == result);
+  BOOST_CHECK(!decoder.field_changed(0));
+  BOOST_CHECK(decoder.field_changed(1));
+  BOOST_REQUIRE_EQUAL(decoder.changed_fields().size(), 1U);
+  BOOST_CHECK_EQUAL(decoder.changed_fields()[0], 2U);
+
+  msg_ref.set_field1().as(2);
+  encoded_size = encoder.encode(msg_ref, buffer, sizeof(buffer));
+  first = buffer;
+  decoder.decode(first, buffer + encoded_size);
+  BOOST_CHECK(decoder.field_changed(0));
+}
+
 BOOST_AUTO_TEST_CASE(group_coder_test)
 {
   fast_coding_test_case<simple2::templates_description> test_case;
@@ -160,6 +209,70 @@ BOOST_AUTO_TEST_CASE(sequence_coder_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(long_sequence_coder_test)
+{
+  fast_coding_test_case<simple3::templates_description> test_case;
+
+  debug_allocator alloc;
+  simple3::Test msg(&alloc);
+  simple3::Test_mref msg_ref = msg.mref();
+
+  msg_ref.set_field1().as(1);
+  simple3::Test_mref::sequence1_mref seq(msg_ref.set_sequence1());
+  seq.resize(30);
+  for (uint32_t i = 0; i < 30; ++i) {
+    seq[i].set_field2().as(i/3);
+    seq[i].set_field3().as(7);
+  }
+
+  // the element by element encoding of the original encoder
+  mfast::fast_encoder encoder(&alloc);
+  const templates_description* descriptions[] = { simple3::description() };
+  encoder.include(descriptions);
+
+  std::vector<char> expected;
+  encoder.encode(msg_ref, expected);
+
+  BOOST_CHECK(test_case.encoding(msg_ref, byte_stream(expected.data(), expected.size())));
+  BOOST_CHECK(test_case.decoding(byte_stream(expected.data(), expected.size()), msg_ref));
+}
+
+BOOST_AUTO_TEST_CASE(sequence_length_hints_test)
+{
+  debug_allocator alloc;
+  mfast::fast_encoder_v2 encoder(simple3::templates_description::instance(), &alloc);
+  mfast::fast_decoder_v2<0> decoder(simple3::templates_description::instance(), &alloc);
+  decoder.sequence_length_hints(true);
+
+  simple3::Test msg(&alloc);
+  simple3::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as(1);
+
+  const unsigned lengths[] = { 2, 5, 3 };
+  for (int i = 0; i < 3; ++i) {
+    simple3::Test_mref::sequence1_mref seq(msg_ref.set_sequence1());
+    seq.resize(lengths[i]);
+    for (unsigned j = 0; j < lengths[i]; ++j) {
+      seq[j].set_field2().as(j);
+      seq[j].set_field3().as(j);
+    }
+
+    char buffer[128];
+    std::size_t encoded_size = encoder.encode(msg.cref(), buffer, sizeof(buffer));
+    const char* first = buffer;
+    simple3::Test_cref result(decoder.decode(first, buffer + encoded_size));
+    BOOST_CHECK(result == msg.cref());
+  }
+
+  std::vector<mfast::sequence_length_stats> stats = decoder.sequence_statistics();
+  BOOST_REQUIRE_EQUAL(stats.size(), 1U);
+  BOOST_CHECK_EQUAL(stats[0].instruction->name(), std::string("sequence1"));
+  BOOST_CHECK_EQUAL(stats[0].count, 3U);
+  BOOST_CHECK_EQUAL(stats[0].high_water_mark, 5U);
+  // 2, then 2 + (5-2)/8, then 2.375 + (3-2.375)/8
+  BOOST_CHECK_CLOSE(stats[0].average, 2.453125, 0.0001);
+}
+
 BOOST_AUTO_TEST_CASE(static_templateref_coder_test)
 {
   fast_coding_test_case<simple4::templates_description> test_case;
@@ -262,5 +375,205 @@ BOOST_AUTO_TEST_CASE(auto_reset_coder_test)
   BOOST_CHECK(test_case.decoding("\x80", msg_ref));
 }
 
+BOOST_AUTO_TEST_CASE(encoded_size_test)
+{
+  fast_coding_test_case<simple8::templates_description> test_case;
+
+  debug_allocator alloc;
+  simple8::Test msg(&alloc);
+  simple8::Test_mref msg_ref = msg.mref();
+
+  msg_ref.set_field1().as(1);
+  msg_ref.set_field2().as("ABC");
+  msg_ref.set_field3().as("DEFGH");
+  msg_ref.omit_field4();
+
+  // pmap | f1 | f2          | f3
+  //  B0    81   41 42 C3      80 44 45 46 47 C8
+  BOOST_CHECK(test_case.encoding(msg_ref, "\xB0\x81\x41\x42\xC3\x80\x44\x45\x46\x47\xC8"));
+
+  msg_ref.set_field1().as(2);
+  msg_ref.set_field2().as("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+  msg_ref.set_field3().as("DEFGHIJ");
+  const unsigned char bytes[] = { 1, 2 };
+  msg_ref.set_field4().assign(bytes, bytes+2);
+
+  // pmap | f2 | f3 (append "IJ") | f4
+  BOOST_CHECK(test_case.encoding(msg_ref,
+                                 "\x98\x41\x42\x43\x44\x45\x46\x47\x48\x49\x4A\x4B\x4C\x4D\x4E\x4F"
+                                 "\x50\x51\x52\x53\x54\x55\x56\x57\x58\x59\xDA\x80\x49\xCA\x83\x01\x02"));
+
+  // field1 is not incremented; field3 has nothing to append
+  BOOST_CHECK(test_case.encoding(msg_ref, "\xA0\x82\x80\x80"));
+
+  msg_ref.set_field2().as("A");
+  msg_ref.set_field3().as("DEF");
+  // f3 removes "GHIJ" from the tail
+  BOOST_CHECK(test_case.encoding(msg_ref, "\xB0\x82\xC1\x84\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(pod_struct_test)
+{
+  BOOST_CHECK(std::is_trivially_copyable<simple9::Order_pod>::value);
+  BOOST_CHECK_EQUAL(sizeof(simple9::Order_pod().symbol.data), 8U);
+  BOOST_CHECK_EQUAL(simple9::Order_pod().fills.capacity(), 4U);
+
+  debug_allocator alloc;
+  mfast::fast_encoder_v2 encoder(simple9::templates_description::instance(), &alloc);
+  mfast::fast_decoder_v2<0> decoder(simple9::templates_description::instance(), &alloc);
+
+  simple9::Order_pod order;
+  std::memset(&order, 0, sizeof(order));
+  order.orderId = 1001;
+  order.quantity = -200;
+  order.price.mantissa = 12345;
+  order.price.exponent = -2;
+  order.price_present = true;
+  order.symbol.length = 4;
+  std::memcpy(order.symbol.data, "MSFT", 4);
+  order.note_present = false;
+  order.party_present = true;
+  order.party.partyId.length = 3;
+  std::memcpy(order.party.partyId.data, "ABC", 3);
+  order.party.role = 7;
+  order.fills.size = 2;
+  order.fills.elements[0].fillPrice.mantissa = 12340;
+  order.fills.elements[0].fillPrice.exponent = -2;
+  order.fills.elements[0].fillQty = 50;
+  order.fills.elements[1].fillPrice.mantissa = 1235;
+  order.fills.elements[1].fillPrice.exponent = -1;
+  order.fills.elements[1].fillQty = 150;
+
+  simple9::Order msg(&alloc);
+  order.store(msg.mref());
+  BOOST_CHECK_EQUAL(msg.cref().get_venue().value(), "XNAS");
+
+  char buffer[128];
+  std::size_t encoded_size = encoder.encode(msg.cref(), buffer, sizeof(buffer));
+  const char* first = buffer;
+  simple9::Order_cref result(decoder.decode(first, buffer + encoded_size));
+  BOOST_CHECK(msg.cref() == result);
+
+  simple9::Order_pod decoded;
+  decoded.load(result);
+  BOOST_CHECK_EQUAL(decoded.orderId, 1001U);
+  BOOST_CHECK_EQUAL(decoded.quantity, -200);
+  BOOST_CHECK(decoded.price_present);
+  BOOST_CHECK_EQUAL(decoded.price.mantissa, 12345);
+  BOOST_CHECK_EQUAL(decoded.price.exponent, -2);
+  BOOST_CHECK_EQUAL(decoded.symbol.value(), "MSFT");
+  BOOST_CHECK(!decoded.note_present);
+  BOOST_CHECK(decoded.party_present);
+  BOOST_CHECK_EQUAL(decoded.party.partyId.value(), "ABC");
+  BOOST_CHECK_EQUAL(decoded.party.role, 7U);
+  BOOST_REQUIRE_EQUAL(decoded.fills.size, 2U);
+  BOOST_CHECK_EQUAL(decoded.fills.elements[1].fillPrice.mantissa, 1235);
+  BOOST_CHECK_EQUAL(decoded.fills.elements[1].fillQty, 150U);
+
+  // the struct is copied as plain bytes
+  simple9::Order_pod copy;
+  std::memcpy(&copy, &decoded, sizeof(copy));
+  simple9::Order copied_msg(&alloc);
+  copy.store(copied_msg.mref());
+  BOOST_CHECK(copied_msg.cref() == result);
+
+  simple9::Order long_symbol(&alloc);
+  long_symbol.mref().set_symbol().as("ABCDEFGHI");
+  BOOST_CHECK_THROW(decoded.load(long_symbol.cref()), std::length_error);
+
+  // the struct is coded straight from and to the stream fast_encoder_v2 produces for the message
+  BOOST_CHECK((std::is_same<simple9::Order_pod::message_type, simple9::Order>::value));
+  mfast::fast_pod_encoder pod_encoder(simple9::templates_description::instance(), &alloc);
+  mfast::fast_pod_decoder pod_decoder(simple9::templates_description::instance(), &alloc);
+  mfast::fast_encoder_v2 message_encoder(simple9::templates_description::instance(), &alloc);
+
+  simple9::Order_pod next = order;
+  next.orderId = 1002;
+  next.quantity = -150;
+  next.price_present = false;
+  next.symbol.length = 3;
+  std::memcpy(next.symbol.data, "IBM", 3);
+  next.note_present = true;
+  next.note.size = 2;
+  std::memcpy(next.note.elements, "\x01\x02", 2);
+  next.party_present = false;
+  next.fills.size = 1;
+
+  const simple9::Order_pod* orders[] = { &order, &next, &next };
+  for (std::size_t i = 0; i < 3; ++i) {
+    char pod_buffer[128];
+    std::size_t pod_size = pod_encoder.encode(*orders[i], pod_buffer, sizeof(pod_buffer));
+
+    simple9::Order expected(&alloc);
+    orders[i]->store(expected.mref());
+    encoded_size = message_encoder.encode(expected.cref(), buffer, sizeof(buffer));
+    BOOST_CHECK_EQUAL(pod_size, encoded_size);
+    BOOST_CHECK(std::memcmp(pod_buffer, buffer, pod_size) == 0);
+
+    simple9::Order_pod roundtrip;
+    std::memset(&roundtrip, 0, sizeof(roundtrip));
+    first = pod_buffer;
+    pod_decoder.decode(first, pod_buffer + pod_size, roundtrip);
+    BOOST_CHECK(first == pod_buffer + pod_size);
+
+    simple9::Order decoded_msg(&alloc);
+    roundtrip.store(decoded_msg.mref());
+    BOOST_CHECK(decoded_msg.cref() == expected.cref());
+  }
+
+  next.symbol.length = 9;
+  BOOST_CHECK_THROW(pod_encoder.encode(next, buffer, sizeof(buffer)), std::length_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(pooled_buffer_encode_test)
+{
+  mfast::fast_encoder_v2 encoder(simple1::templates_description::instance());
+
+  simple1::Test msg;
+  simple1::Test_mref msg_ref = msg.mref();
+
+  msg_ref.set_field1().as(1);
+  msg_ref.set_field2().as(2);
+  msg_ref.set_field3().as(3);
+
+  pooled_fast_ostreambuf buffer;
+  encoder.encode(msg_ref, buffer);
+  BOOST_CHECK(byte_stream(buffer) == byte_stream("\xB8\x81\x82\x83"));
+
+  // the second message is appended
+  msg_ref.set_field1().as(2);
+  encoder.encode(msg_ref, buffer);
+  BOOST_CHECK(byte_stream(buffer) == byte_stream("\xB8\x81\x82\x83\xA0\x82"));
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validation_test)
+{
+  fast_coding_test_case<simple10::templates_description> test_case;
+
+  debug_allocator alloc;
+  simple10::Test msg(&alloc);
+  simple10::Test_mref msg_ref = msg.mref();
+  msg_ref.set_field1().as("\xC3\xA9");
+
+  BOOST_CHECK(test_case.encoding(msg_ref, "\xA0\x82\xC3\xA9", true));
+
+  mfast::fast_decoder_v2<0> decoder(simple10::templates_description::instance(), &alloc);
+  decoder.validate_utf8(true);
+
+  const char valid[] = "\xA0\x82\xC3\xA9";
+  const char* first = valid;
+  simple10::Test_cref result(decoder.decode(first, valid + 4, true));
+  BOOST_CHECK(result == msg_ref);
+
+  // the copied value is not checked again
+  const char copied[] = "\x80";
+  first = copied;
+  decoder.decode(first, copied + 1);
+
+  const char malformed[] = "\xA0\x82\xC3\x28";
+  first = malformed;
+  BOOST_CHECK_THROW(decoder.decode(first, malformed + 4, true), mfast::fast_reportable_error);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,141 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast.h>
+#include <mfast/thread_caching_allocator.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "simple3.h"
+
+using namespace mfast;
+
+BOOST_AUTO_TEST_SUITE( thread_caching_allocator_test_suite )
+
+BOOST_AUTO_TEST_CASE(thread_caching_allocator_reuse_test)
+{
+  allocator* alloc = thread_caching_allocator::instance();
+
+  void* block1 = alloc->allocate(100);
+  alloc->deallocate(block1, 100);
+  // the block is cached by this thread
+  void* block2 = alloc->allocate(120);
+  BOOST_CHECK_EQUAL(block1, block2);
+  alloc->deallocate(block2, 120);
+
+  void* pointer = 0;
+  std::size_t capacity = alloc->reallocate(pointer, 0, 10);
+  BOOST_CHECK_EQUAL(capacity, 64U);
+  std::memset(pointer, 'a', capacity);
+
+  capacity = alloc->reallocate(pointer, capacity, 65);
+  BOOST_CHECK_EQUAL(capacity, 128U);
+  BOOST_CHECK_EQUAL(static_cast<char*>(pointer)[63], 'a');
+
+  // blocks larger than max_block_size are not cached
+  capacity = alloc->reallocate(pointer, capacity, thread_caching_allocator::max_block_size + 1);
+  BOOST_CHECK(capacity > static_cast<std::size_t>(thread_caching_allocator::max_block_size));
+  BOOST_CHECK_EQUAL(static_cast<char*>(pointer)[0], 'a');
+  alloc->deallocate(pointer, capacity);
+}
+
+BOOST_AUTO_TEST_CASE(thread_caching_allocator_cross_thread_test)
+{
+  allocator* alloc = thread_caching_allocator::instance();
+
+  // blocks allocated in one thread and freed in another
+  const std::size_t num_blocks = 10 * thread_caching_allocator::magazine_capacity;
+  std::vector<void*> blocks(num_blocks);
+
+  for (int round = 0; round < 3; ++round) {
+    std::thread producer([&]() {
+      for (std::size_t i = 0; i < num_blocks; ++i) {
+        blocks[i] = alloc->allocate(48);
+        std::memset(blocks[i], static_cast<int>(i), 48);
+      }
+    });
+    producer.join();
+
+    std::thread consumer([&]() {
+      for (std::size_t i = 0; i < num_blocks; ++i) {
+        BOOST_CHECK_EQUAL(static_cast<unsigned char*>(blocks[i])[47], static_cast<unsigned char>(i));
+        alloc->deallocate(blocks[i], 48);
+      }
+    });
+    consumer.join();
+  }
+}
+
+namespace {
+  // Frees its block from a thread_local destructor which runs after the
+  // allocator's own thread cache has been destroyed.
+  struct late_deallocator
+  {
+    void* block_;
+    bool* reallocated_;
+
+    late_deallocator()
+      : block_(0)
+      , reallocated_(0)
+    {
+    }
+
+    ~late_deallocator()
+    {
+      allocator* alloc = thread_caching_allocator::instance();
+      alloc->deallocate(block_, 48);
+      void* block = alloc->allocate(48);
+      std::memset(block, 0, 48);
+      alloc->deallocate(block, 48);
+      *reallocated_ = true;
+    }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(thread_caching_allocator_teardown_test)
+{
+  bool reallocated = false;
+  std::thread worker([&]() {
+    // constructed before the thread cache, hence destroyed after it
+    static thread_local late_deallocator holder;
+    holder.reallocated_ = &reallocated;
+    holder.block_ = thread_caching_allocator::instance()->allocate(48);
+  });
+  worker.join();
+  BOOST_CHECK(reallocated);
+}
+
+BOOST_AUTO_TEST_CASE(thread_caching_allocator_message_test)
+{
+  simple3::Test msg(thread_caching_allocator::instance());
+  simple3::Test_mref msg_ref = msg.mref();
+
+  msg_ref.set_field1().as(1);
+  simple3::Test_mref::sequence1_mref seq(msg_ref.set_sequence1());
+  seq.resize(100);
+  seq[99].set_field2().as(2);
+
+  simple3::Test copy(msg.cref(), thread_caching_allocator::instance());
+  BOOST_CHECK(copy.cref() == msg.cref());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
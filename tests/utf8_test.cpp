@@ -0,0 +1,84 @@
+// Copyright (c) 2013, 2014, Huang-Ming Huang,  Object Computing, Inc.
+// All rights reserved.
+//
+// This file is part of mFAST.
+//
+//     mFAST is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU Lesser General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     mFAST is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU Lesser General Public License
+//     along with mFast.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <mfast/utf8.h>
+#include <cstring>
+#include <string>
+
+using namespace mfast;
+
+namespace {
+
+  bool valid(const std::string& str)
+  {
+    return is_valid_utf8(str.data(), str.size());
+  }
+
+}
+
+BOOST_AUTO_TEST_SUITE( test_utf8 )
+
+BOOST_AUTO_TEST_CASE(valid_utf8_test)
+{
+  BOOST_CHECK(is_valid_utf8(0, 0));
+  BOOST_CHECK(valid("abc"));
+  BOOST_CHECK(valid(std::string(100, 'x')));
+  BOOST_CHECK(valid("\xC3\xA9"));
+  BOOST_CHECK(valid("\xE2\x82\xAC"));
+  BOOST_CHECK(valid("\xED\x9F\xBF"));
+  BOOST_CHECK(valid("\xEF\xBF\xBF"));
+  BOOST_CHECK(valid("\xF0\x9F\x98\x80"));
+  BOOST_CHECK(valid("\xF4\x8F\xBF\xBF"));
+  // multibyte characters on both sides of the ASCII runs
+  BOOST_CHECK(valid("\xC3\xA9" + std::string(40, 'a') + "\xE2\x82\xAC" + std::string(17, 'b') + "\xF0\x9F\x98\x80"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_utf8_test)
+{
+  // overlong encodings
+  BOOST_CHECK(!valid("\xC0\x80"));
+  BOOST_CHECK(!valid("\xC1\xBF"));
+  BOOST_CHECK(!valid("\xE0\x80\x80"));
+  BOOST_CHECK(!valid("\xF0\x80\x80\x80"));
+  // surrogates
+  BOOST_CHECK(!valid("\xED\xA0\x80"));
+  // beyond U+10FFFF
+  BOOST_CHECK(!valid("\xF4\x90\x80\x80"));
+  BOOST_CHECK(!valid("\xF5\x80\x80\x80"));
+  // truncated sequences
+  BOOST_CHECK(!valid("\xC3"));
+  BOOST_CHECK(!valid("\xE2\x82"));
+  BOOST_CHECK(!valid("\xF0\x9F\x98"));
+  // stray continuation bytes
+  BOOST_CHECK(!valid("\x80"));
+  BOOST_CHECK(!valid("a\xBF" "b"));
+  BOOST_CHECK(!valid("\xC3\x28"));
+  BOOST_CHECK(!valid("\xFF"));
+
+  // the error in every position after and within a long ASCII run
+  for (std::size_t i = 0; i < 40; ++i) {
+    std::string str(40, 'a');
+    str[i] = '\x80';
+    BOOST_CHECK(!valid(str));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()